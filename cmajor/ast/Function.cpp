@@ -232,6 +232,12 @@ void FunctionNode::SwitchToBody()
     }
 }
 
+void FunctionNode::ReleaseBody()
+{
+    body.reset();
+    bodySource.reset();
+}
+
 void FunctionNode::SetReturnTypeExpr(Node* returnTypeExpr_)
 {
     returnTypeExpr.reset(returnTypeExpr_);
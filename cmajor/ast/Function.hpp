@@ -47,6 +47,7 @@ public:
     void SetBody(CompoundStatementNode* body_);
     const CompoundStatementNode* BodySource() const { return bodySource.get(); }
     void SetBodySource(CompoundStatementNode* bodySource_);
+    void ReleaseBody();
     bool IsProgramMain() const { return programMain; }
     void SetProgramMain() { programMain = true; }
     Attributes* GetAttributes() const { return attributes.get(); }
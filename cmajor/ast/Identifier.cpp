@@ -8,39 +8,79 @@
 #include <cmajor/ast/AstWriter.hpp>
 #include <cmajor/ast/AstReader.hpp>
 #include <cmajor/util/Unicode.hpp>
+#include <unordered_set>
+#include <mutex>
 
 namespace cmajor { namespace ast {
 
 using namespace cmajor::unicode;
 
-IdentifierNode::IdentifierNode(const Span& span_) : Node(NodeType::identifierNode, span_), identifier()
+//  Source files are parsed in parallel, so the identifier pool is divided into independently locked shards.
+
+const int numIdentifierPoolShards = 16;
+
+class IdentifierPool
+{
+public:
+    const std::u32string* Intern(const std::u32string& identifier);
+private:
+    struct Shard
+    {
+        std::mutex mtx;
+        std::unordered_set<std::u32string> identifiers;
+    };
+    Shard shards[numIdentifierPoolShards];
+};
+
+const std::u32string* IdentifierPool::Intern(const std::u32string& identifier)
 {
+    Shard& shard = shards[std::hash<std::u32string>()(identifier) % numIdentifierPoolShards];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    return &*shard.identifiers.insert(identifier).first;
 }
 
-IdentifierNode::IdentifierNode(const Span& span_, NodeType nodeType_) : Node(NodeType::cursorIdNode, span_), identifier()
+IdentifierPool* identifierPool = nullptr;
+std::once_flag identifierPoolFlag;
+const std::u32string emptyIdentifier;
+
+const std::u32string* InternIdentifier(const std::u32string& identifier)
 {
+    std::call_once(identifierPoolFlag, []() { identifierPool = new IdentifierPool(); });
+    return identifierPool->Intern(identifier);
 }
 
-IdentifierNode::IdentifierNode(const Span& span_, const std::u32string& identifier_) : Node(NodeType::identifierNode, span_), identifier(identifier_)
+IdentifierNode::IdentifierNode(const Span& span_) : Node(NodeType::identifierNode, span_), identifier(&emptyIdentifier)
 {
 }
 
-IdentifierNode::IdentifierNode(const Span& span_, NodeType nodeType_, const std::u32string& identifier_) : Node(NodeType::cursorIdNode, span_), identifier(identifier_)
+IdentifierNode::IdentifierNode(const Span& span_, NodeType nodeType_) : Node(NodeType::cursorIdNode, span_), identifier(&emptyIdentifier)
+{
+}
+
+IdentifierNode::IdentifierNode(const Span& span_, const std::u32string& identifier_) : Node(NodeType::identifierNode, span_), identifier(InternIdentifier(identifier_))
+{
+}
+
+IdentifierNode::IdentifierNode(const Span& span_, NodeType nodeType_, const std::u32string& identifier_) : Node(NodeType::cursorIdNode, span_), identifier(nullptr)
 {
     std::u32string result;
-    for (char32_t c : identifier)
+    for (char32_t c : identifier_)
     {
         if (c != '`')
         {
             result.append(1, c);
         }
     }
-    std::swap(result, identifier);
+    identifier = InternIdentifier(result);
+}
+
+IdentifierNode::IdentifierNode(const IdentifierNode& that) : Node(NodeType::identifierNode, that.GetSpan()), identifier(that.identifier)
+{
 }
 
 Node* IdentifierNode::Clone(CloneContext& cloneContext) const
 {
-    return new IdentifierNode(GetSpan(), identifier);
+    return new IdentifierNode(*this);
 }
 
 void IdentifierNode::Accept(Visitor& visitor)
@@ -51,18 +91,18 @@ void IdentifierNode::Accept(Visitor& visitor)
 void IdentifierNode::Write(AstWriter& writer)
 {
     Node::Write(writer);
-    writer.GetBinaryWriter().Write(identifier);
+    writer.GetBinaryWriter().Write(*identifier);
 }
 
 void IdentifierNode::Read(AstReader& reader)
 {
     Node::Read(reader);
-    identifier = reader.GetBinaryReader().ReadUtf32String();
+    identifier = InternIdentifier(reader.GetBinaryReader().ReadUtf32String());
 }
 
 std::string IdentifierNode::ToString() const
 {
-    return ToUtf8(identifier);
+    return ToUtf8(*identifier);
 }
 
 CursorIdNode::CursorIdNode(const Span& span_) : IdentifierNode(span_, NodeType::cursorIdNode)
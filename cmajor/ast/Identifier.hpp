@@ -9,6 +9,10 @@
 
 namespace cmajor { namespace ast {
 
+//  Returns the unique copy of the given identifier. Interned identifiers live until the end of the program.
+
+const std::u32string* InternIdentifier(const std::u32string& identifier);
+
 class IdentifierNode : public Node
 {
 public:
@@ -16,14 +20,15 @@ public:
     IdentifierNode(const Span& span_, NodeType nodeType_);
     IdentifierNode(const Span& span_, const std::u32string& identifier_);
     IdentifierNode(const Span& span_, NodeType nodeType_, const std::u32string& identifier_);
+    IdentifierNode(const IdentifierNode& that);
     Node* Clone(CloneContext& cloneContext) const override;
     void Accept(Visitor& visitor) override;
     void Write(AstWriter& writer) override;
     void Read(AstReader& reader) override;
-    const std::u32string& Str() const { return identifier; }
+    const std::u32string& Str() const { return *identifier; }
     std::string ToString() const override;
 private:
-    std::u32string identifier;
+    const std::u32string* identifier;
 };
 
 class CursorIdNode : public IdentifierNode
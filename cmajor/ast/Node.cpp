@@ -23,9 +23,12 @@
 #include <cmajor/ast/Class.hpp>
 #include <cmajor/ast/Interface.hpp>
 #include <cmajor/ast/Concept.hpp>
+#include <cmajor/util/NodeMemory.hpp>
 
 namespace cmajor { namespace ast {
 
+using namespace cmajor::util;
+
 const char* nodeTypeStr[] = 
 {
     "boolNode", "sbyteNode", "byteNode", "shortNode", "ushortNode", "intNode", "uintNode", "longNode", "ulongNode", "floatNode", "doubleNode", "charNode", "wcharNode", "ucharNode", "voidNode",
@@ -69,6 +72,16 @@ Node::~Node()
 {
 }
 
+void* Node::operator new(size_t size)
+{
+    return AllocateNodeMemory(size);
+}
+
+void Node::operator delete(void* memory, size_t size)
+{
+    FreeNodeMemory(memory, size);
+}
+
 void Node::Write(AstWriter& writer)
 {
 }
@@ -56,6 +56,8 @@ class Node
 public:
     Node(NodeType nodeType_, const Span& span_);
     virtual ~Node();
+    static void* operator new(size_t size);
+    static void operator delete(void* memory, size_t size);
     NodeType GetNodeType() const { return nodeType; }
     virtual Node* Clone(CloneContext& cloneContext) const = 0;
     virtual void Accept(Visitor& visitor) = 0;
@@ -250,6 +250,7 @@ BoundCompileUnit::BoundCompileUnit(Module& module_, CompileUnitNode* compileUnit
         llFilePath = GetFullPath(llfp.generic_string());
         optLLFilePath = GetFullPath(optllfp.generic_string());
         objectFilePath = GetFullPath(objfp.generic_string());
+        objectFilePaths.push_back(objectFilePath);
     }
 }
 
@@ -667,6 +668,11 @@ FunctionNode* BoundCompileUnit::GetFunctionNodeFor(FunctionSymbol* constExprFunc
     return constExprFunctionRepository.GetFunctionNodeFor(constExprFunctionSymbol);
 }
 
+void BoundCompileUnit::CheckConstExprFunctionReturnPaths(FunctionSymbol* constExprFunctionSymbol, FunctionNode& functionNode, ContainerScope* containerScope)
+{
+    constExprFunctionRepository.CheckReturnPaths(constExprFunctionSymbol, functionNode, containerScope);
+}
+
 void BoundCompileUnit::GenerateCopyConstructorFor(ClassTypeSymbol* classTypeSymbol, ContainerScope* containerScope, BoundFunction* currentFunction, const Span& span)
 {
     operationRepository.GenerateCopyConstructorFor(classTypeSymbol, containerScope, currentFunction, span);
@@ -38,6 +38,7 @@ public:
     void Accept(BoundNodeVisitor& visitor) override;
     Module& GetModule() { return module; }
     SymbolTable& GetSymbolTable() { return symbolTable; }
+    BoundNodeArena& GetBoundNodeArena() { return boundNodeArena; }
     CompileUnitNode* GetCompileUnitNode() const { return compileUnitNode; }
     void AddFileScope(FileScope* fileScope);
     void RemoveLastFileScope();
@@ -53,6 +54,7 @@ public:
     bool InstantiateClassTemplateMemberFunction(FunctionSymbol* memberFunction, ContainerScope* containerScope, BoundFunction* currentFunction, const Span& span);
     FunctionSymbol* InstantiateInlineFunction(FunctionSymbol* inlineFunction, ContainerScope* containerScope, const Span& span);
     FunctionNode* GetFunctionNodeFor(FunctionSymbol* constExprFunctionSymbol);
+    void CheckConstExprFunctionReturnPaths(FunctionSymbol* constExprFunctionSymbol, FunctionNode& functionNode, ContainerScope* containerScope);
     void GenerateCopyConstructorFor(ClassTypeSymbol* classTypeSymbol, ContainerScope* containerScope, BoundFunction* currentFunction, const Span& span);
     void GenerateCopyConstructorFor(InterfaceTypeSymbol* interfaceTypeSymbol, ContainerScope* containerScope, BoundFunction* currentFunction, const Span& span);
     int Install(const std::string& str);
@@ -74,6 +76,8 @@ public:
     const std::string& LLFilePath() const { return llFilePath; }
     const std::string& OptLLFilePath() const { return optLLFilePath; }
     const std::string& ObjectFilePath() const { return objectFilePath; }
+    const std::vector<std::string>& ObjectFilePaths() const { return objectFilePaths; }
+    void AddObjectFilePath(const std::string& objectFilePath_) { objectFilePaths.push_back(objectFilePath_); }
     void SetHasGotos() { hasGotos = true; }
     bool HasGotos() const { return hasGotos; }
     ClassTemplateRepository& GetClassTemplateRepository() { return classTemplateRepository; }
@@ -94,6 +98,7 @@ public:
     void AddGlobalNs(std::unique_ptr<NamespaceNode>&& globalNs);
     void AddFunctionSymbol(std::unique_ptr<FunctionSymbol>&& functionSymbol);
 private:
+    BoundNodeArena boundNodeArena;
     Module& module;
     SymbolTable& symbolTable;
     CompileUnitNode* compileUnitNode;
@@ -103,6 +108,7 @@ private:
     std::string llFilePath;
     std::string optLLFilePath;
     std::string objectFilePath;
+    std::vector<std::string> objectFilePaths;
     std::vector<std::unique_ptr<FileScope>> fileScopes;
     std::vector<std::unique_ptr<BoundNode>> boundNodes;
     std::vector<std::unique_ptr<FunctionSymbol>> functionSymbols;
@@ -32,6 +32,7 @@ public:
     BoundConstraint* Clone() const override;
     bool Satisfied() const { return satisfied; }
     void SetConcept(ConceptSymbol* concept_) { concept = concept_; }
+    ConceptSymbol* Concept() const { return concept; }
 private:
     bool satisfied;
     ConceptSymbol* concept;
@@ -4,11 +4,125 @@
 // =================================
 
 #include <cmajor/binder/BoundNode.hpp>
+#include <cmajor/util/Error.hpp>
+#include <new>
 
 namespace cmajor { namespace binder {
 
+const size_t granularity = 16;
+const size_t numSizeClasses = 32;
+const size_t blockSize = 64 * 1024;
+//  The header holds one pointer but takes 16 bytes, so that nodes keep the alignment of memory allocated by operator new.
+const size_t headerSize = 16;
+
+#ifdef _WIN32
+__declspec(thread) BoundNodeArena* currentArena = nullptr;
+#else
+__thread BoundNodeArena* currentArena = nullptr;
+#endif
+
+BoundNodeArena::BoundNodeArena() : freeLists(numSizeClasses, nullptr), blockPos(nullptr), blockEnd(nullptr)
+{
+}
+
+BoundNodeArena::~BoundNodeArena()
+{
+    for (char* block : blocks)
+    {
+        ::operator delete(block);
+    }
+}
+
+void* BoundNodeArena::Allocate(size_t size)
+{
+    size_t sizeClass = (size + granularity - 1) / granularity;
+    if (sizeClass == 0 || sizeClass > numSizeClasses)
+    {
+        return nullptr;
+    }
+    FreeBlock*& head = freeLists[sizeClass - 1];
+    if (head)
+    {
+        FreeBlock* freeBlock = head;
+        head = freeBlock->next;
+        return freeBlock;
+    }
+    size_t allocationSize = sizeClass * granularity;
+    if (blockEnd - blockPos < static_cast<ptrdiff_t>(allocationSize))
+    {
+        blockPos = static_cast<char*>(::operator new(blockSize));
+        blockEnd = blockPos + blockSize;
+        blocks.push_back(blockPos);
+    }
+    void* memory = blockPos;
+    blockPos += allocationSize;
+    return memory;
+}
+
+void BoundNodeArena::Free(void* memory, size_t size)
+{
+    size_t sizeClass = (size + granularity - 1) / granularity;
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(memory);
+    FreeBlock*& head = freeLists[sizeClass - 1];
+    freeBlock->next = head;
+    head = freeBlock;
+}
+
+BoundNodeArenaScope::BoundNodeArenaScope(BoundNodeArena& arena) : prevArena(currentArena)
+{
+    currentArena = &arena;
+}
+
+BoundNodeArenaScope::~BoundNodeArenaScope()
+{
+    currentArena = prevArena;
+}
+
 BoundNode::BoundNode(Module* module_, const Span& span_, BoundNodeType boundNodeType_) : module(module_), span(span_), boundNodeType(boundNodeType_)
 {
 }
 
+//  Each node is preceded by a header that holds the arena the node was allocated from, or null if it was allocated from the heap.
+//  A node of an arena is deleted either in the scope of its own arena, or outside of any arena when its compile unit is destroyed, 
+//  in which case its memory is left to the arena to release. Deleting it in the scope of another arena is an error.
+
+void* BoundNode::operator new(size_t size)
+{
+    BoundNodeArena* arena = currentArena;
+    void* memory = nullptr;
+    if (arena)
+    {
+        memory = arena->Allocate(headerSize + size);
+    }
+    if (!memory)
+    {
+        arena = nullptr;
+        memory = ::operator new(headerSize + size);
+    }
+    *static_cast<BoundNodeArena**>(memory) = arena;
+    return static_cast<char*>(memory) + headerSize;
+}
+
+void BoundNode::operator delete(void* memory, size_t size)
+{
+    if (!memory)
+    {
+        return;
+    }
+    void* block = static_cast<char*>(memory) - headerSize;
+    BoundNodeArena* arena = *static_cast<BoundNodeArena**>(block);
+    if (!arena)
+    {
+        ::operator delete(block);
+    }
+    else if (arena == currentArena)
+    {
+        arena->Free(block, headerSize + size);
+    }
+    else
+    {
+        Assert(!currentArena, "bound node deleted in the arena scope of another compile unit");
+    }
+}
+
 } } // namespace cmajor::binder
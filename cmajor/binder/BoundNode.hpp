@@ -8,6 +8,7 @@
 #include <cmajor/parsing/Scanner.hpp>
 #include <cmajor/ir/GenObject.hpp>
 #include <cmajor/symbols/Module.hpp>
+#include <vector>
 
 namespace cmajor { namespace binder {
 
@@ -33,10 +34,53 @@ enum class BoundNodeType : uint8_t
 
 class BoundNodeVisitor;
 
+//  ==================================================================================================
+//  Bound nodes are allocated from the arena of the compile unit that the current thread is binding or
+//  generating code for. Memory of a node deleted by that thread is recycled through the free lists of
+//  the arena, and all memory of the arena is released at once when the compile unit is destroyed.
+//  Nodes created when there is no current arena are allocated from the heap.
+//  ==================================================================================================
+
+class BoundNodeArena
+{
+public:
+    BoundNodeArena();
+    BoundNodeArena(const BoundNodeArena&) = delete;
+    BoundNodeArena& operator=(const BoundNodeArena&) = delete;
+    ~BoundNodeArena();
+    //  Returns null if the size is too large to be allocated from the arena.
+    void* Allocate(size_t size);
+    void Free(void* memory, size_t size);
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+    std::vector<FreeBlock*> freeLists;
+    std::vector<char*> blocks;
+    char* blockPos;
+    char* blockEnd;
+};
+
+//  Makes the given arena the current arena of this thread for the lifetime of the scope object.
+
+class BoundNodeArenaScope
+{
+public:
+    BoundNodeArenaScope(BoundNodeArena& arena);
+    BoundNodeArenaScope(const BoundNodeArenaScope&) = delete;
+    BoundNodeArenaScope& operator=(const BoundNodeArenaScope&) = delete;
+    ~BoundNodeArenaScope();
+private:
+    BoundNodeArena* prevArena;
+};
+
 class BoundNode : public GenObject
 {
 public:
     BoundNode(Module* module_, const Span& span_, BoundNodeType boundNodeType_);
+    static void* operator new(size_t size);
+    static void operator delete(void* memory, size_t size);
     virtual void Accept(BoundNodeVisitor& visitor) = 0;
     const Span& GetSpan() const { return span; }
     BoundNodeType GetBoundNodeType() const { return boundNodeType; }
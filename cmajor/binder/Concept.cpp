@@ -12,6 +12,7 @@
 #include <cmajor/binder/Evaluator.hpp>
 #include <cmajor/symbols/TypedefSymbol.hpp>
 #include <cmajor/symbols/ConceptSymbol.hpp>
+#include <cmajor/symbols/Module.hpp>
 #include <cmajor/ast/Visitor.hpp>
 #include <cmajor/ast/Identifier.hpp>
 #include <cmajor/ast/Expression.hpp>
@@ -1274,7 +1275,7 @@ void ConstraintChecker::Visit(NonreferenceTypeConstraintNode& nonreferenceTypeCo
     }
 }
 
-std::unique_ptr<BoundConcept> Instantiate(ConceptSymbol* conceptSymbol, const std::vector<TypeSymbol*>& typeArguments, BoundCompileUnit& boundCompileUnit, ContainerScope* containerScope, 
+std::unique_ptr<BoundConcept> InstantiateConcept(ConceptSymbol* conceptSymbol, const std::vector<TypeSymbol*>& typeArguments, BoundCompileUnit& boundCompileUnit, ContainerScope* containerScope, 
     BoundFunction* currentFunction, std::unique_ptr<BoundConstraint>& boundConstraint, const Span& span, std::unique_ptr<Exception>& exception)
 {
     ConceptNode* conceptNode = conceptSymbol->GetConceptNode();
@@ -1381,6 +1382,149 @@ std::unique_ptr<BoundConcept> Instantiate(ConceptSymbol* conceptSymbol, const st
     }
 }
 
+void MakeConceptCheckConstraint(BoundConstraint* boundConstraint, std::vector<ConceptCheckConstraint>& constraint)
+{
+    switch (boundConstraint->GetBoundNodeType())
+    {
+        case BoundNodeType::boundAtomicConstraint:
+        {
+            BoundAtomicConstraint* atomicConstraint = static_cast<BoundAtomicConstraint*>(boundConstraint);
+            constraint.push_back(ConceptCheckConstraint(ConceptCheckConstraintKind::atomic, atomicConstraint->Satisfied(), atomicConstraint->Concept()));
+            break;
+        }
+        case BoundNodeType::boundDisjunctiveConstraint: case BoundNodeType::boundConjunctiveConstraint:
+        {
+            BoundBinaryConstraint* binaryConstraint = static_cast<BoundBinaryConstraint*>(boundConstraint);
+            ConceptCheckConstraintKind kind = ConceptCheckConstraintKind::disjunctive;
+            if (boundConstraint->GetBoundNodeType() == BoundNodeType::boundConjunctiveConstraint)
+            {
+                kind = ConceptCheckConstraintKind::conjunctive;
+            }
+            constraint.push_back(ConceptCheckConstraint(kind, true, nullptr));
+            MakeConceptCheckConstraint(binaryConstraint->Left(), constraint);
+            MakeConceptCheckConstraint(binaryConstraint->Right(), constraint);
+            break;
+        }
+    }
+}
+
+BoundConstraint* MakeBoundConstraint(const std::vector<ConceptCheckConstraint>& constraint, int& index, Module* module, const Span& span)
+{
+    const ConceptCheckConstraint& constraintItem = constraint[index++];
+    switch (constraintItem.kind)
+    {
+        case ConceptCheckConstraintKind::atomic:
+        {
+            BoundAtomicConstraint* atomicConstraint = new BoundAtomicConstraint(module, span, constraintItem.satisfied);
+            atomicConstraint->SetConcept(constraintItem.conceptSymbol);
+            return atomicConstraint;
+        }
+        case ConceptCheckConstraintKind::disjunctive:
+        {
+            BoundConstraint* left = MakeBoundConstraint(constraint, index, module, span);
+            BoundConstraint* right = MakeBoundConstraint(constraint, index, module, span);
+            return new BoundDisjunctiveConstraint(module, span, left, right);
+        }
+        case ConceptCheckConstraintKind::conjunctive:
+        {
+            BoundConstraint* left = MakeBoundConstraint(constraint, index, module, span);
+            BoundConstraint* right = MakeBoundConstraint(constraint, index, module, span);
+            return new BoundConjunctiveConstraint(module, span, left, right);
+        }
+    }
+    return nullptr;
+}
+
+BoundConstraint* MakeBoundConstraint(const std::vector<ConceptCheckConstraint>& constraint, Module* module, const Span& span)
+{
+    int index = 0;
+    return MakeBoundConstraint(constraint, index, module, span);
+}
+
+//  The result of instantiating a concept for given type arguments is looked up from the concept check cache of the module, 
+//  so that the same concept is not checked again for the same types when binding the other compile units of the project.
+//  Checking looks up names from the container scope and the file scopes of the compile unit, so they are part of the key.
+//  A result is cached only if checking did not leave behind an overload resolution exception that could be reported later.
+
+std::unique_ptr<BoundConcept> Instantiate(ConceptSymbol* conceptSymbol, const std::vector<TypeSymbol*>& typeArguments, BoundCompileUnit& boundCompileUnit, ContainerScope* containerScope, 
+    BoundFunction* currentFunction, std::unique_ptr<BoundConstraint>& boundConstraint, const Span& span, std::unique_ptr<Exception>& exception)
+{
+    Module* module = &boundCompileUnit.GetModule();
+    ConceptCheckCache& conceptCheckCache = module->GetConceptCheckCache();
+    ConceptCheckKey key(conceptSymbol, typeArguments, LookupScopeKey(containerScope, boundCompileUnit.FileScopes()));
+    ConceptCheckResult result;
+    if (conceptCheckCache.GetResult(key, result))
+    {
+        if (result.satisfied)
+        {
+            boundConstraint.reset(MakeBoundConstraint(result.constraint, module, span));
+            BoundConcept* boundConcept = new BoundConcept(module, conceptSymbol, typeArguments, span);
+            boundConcept->SetBoundConstraint(std::unique_ptr<BoundConstraint>(MakeBoundConstraint(result.constraint, module, span)));
+            if (result.commonType)
+            {
+                BoundTemplateParameterSymbol* commonType = new BoundTemplateParameterSymbol(span, U"CommonType");
+                commonType->SetType(result.commonType);
+                boundConcept->AddBoundTemplateParameter(std::unique_ptr<BoundTemplateParameterSymbol>(commonType));
+                containerScope->Install(commonType);
+                boundConcept->SetCommonType(result.commonType);
+            }
+            return std::unique_ptr<BoundConcept>(boundConcept);
+        }
+        else if (result.hasError)
+        {
+            std::vector<Span> references;
+            for (const Span& reference : result.errorReferences)
+            {
+                if (reference == result.errorSpan)
+                {
+                    references.push_back(span);
+                }
+                else
+                {
+                    references.push_back(reference);
+                }
+            }
+            throw Exception(module, result.errorMessage, span, references);
+        }
+        else
+        {
+            if (!result.constraint.empty())
+            {
+                boundConstraint.reset(MakeBoundConstraint(result.constraint, module, span));
+            }
+            return std::unique_ptr<BoundConcept>();
+        }
+    }
+    Exception* prevException = exception.get();
+    try
+    {
+        std::unique_ptr<BoundConcept> boundConcept = InstantiateConcept(conceptSymbol, typeArguments, boundCompileUnit, containerScope, currentFunction, boundConstraint, span, exception);
+        if (exception.get() == prevException)
+        {
+            if (boundConstraint)
+            {
+                MakeConceptCheckConstraint(boundConstraint.get(), result.constraint);
+            }
+            if (boundConcept)
+            {
+                result.satisfied = true;
+                result.commonType = boundConcept->CommonType();
+            }
+            conceptCheckCache.SetResult(key, result);
+        }
+        return boundConcept;
+    }
+    catch (const Exception& ex)
+    {
+        result.hasError = true;
+        result.errorMessage = ex.Message();
+        result.errorSpan = span;
+        result.errorReferences = ex.References();
+        conceptCheckCache.SetResult(key, result);
+        throw;
+    }
+}
+
 bool CheckConstraint(ConstraintNode* constraint, const NodeList<Node>& usingNodes, BoundCompileUnit& boundCompileUnit, ContainerScope* containerScope, BoundFunction* currentFunction,
     const std::vector<TemplateParameterSymbol*>& templateParameters, const std::unordered_map<TemplateParameterSymbol*, TypeSymbol*>& templateParameterMap, 
     std::unique_ptr<BoundConstraint>& boundConstraint, const Span& span, FunctionSymbol* viableFunction, std::unique_ptr<Exception>& conceptCheckException)
@@ -5,6 +5,7 @@
 
 #include <cmajor/binder/ConstExprFunctionRepository.hpp>
 #include <cmajor/binder/TypeBinder.hpp>
+#include <cmajor/binder/StatementBinder.hpp>
 #include <cmajor/binder/BoundCompileUnit.hpp>
 
 namespace cmajor { namespace binder {
@@ -15,6 +16,11 @@ ConstExprFunctionRepository::ConstExprFunctionRepository(BoundCompileUnit& bound
 
 FunctionNode* ConstExprFunctionRepository::GetFunctionNodeFor(FunctionSymbol* constExprFunctionSymbol)
 {
+    auto it = functionNodeMap.find(constExprFunctionSymbol);
+    if (it != functionNodeMap.cend())
+    {
+        return it->second;
+    }
     Node* node = boundCompileUnit.GetSymbolTable().GetNodeNoThrow(constExprFunctionSymbol);
     if (!node)
     {
@@ -28,7 +34,15 @@ FunctionNode* ConstExprFunctionRepository::GetFunctionNodeFor(FunctionSymbol* co
         TypeBinder typeBinder(boundCompileUnit);
         functionNode->Accept(typeBinder);
     }
+    functionNodeMap[constExprFunctionSymbol] = functionNode;
     return functionNode;
 }
 
+void ConstExprFunctionRepository::CheckReturnPaths(FunctionSymbol* constExprFunctionSymbol, FunctionNode& functionNode, ContainerScope* containerScope)
+{
+    if (returnPathsChecked.find(constExprFunctionSymbol) != returnPathsChecked.cend()) return;
+    CheckFunctionReturnPaths(constExprFunctionSymbol, functionNode, containerScope, boundCompileUnit);
+    returnPathsChecked.insert(constExprFunctionSymbol);
+}
+
 } } // namespace cmajor::binder
@@ -7,6 +7,8 @@
 #define CMAJOR_BINDER_CONST_EXPR_FUNCTION_REPOSITORY_INCLUDED
 #include <cmajor/symbols/FunctionSymbol.hpp>
 #include <cmajor/ast/Function.hpp>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace cmajor { namespace binder {
 
@@ -19,8 +21,11 @@ class ConstExprFunctionRepository
 public:
     ConstExprFunctionRepository(BoundCompileUnit& boundCompileUnit_);
     FunctionNode* GetFunctionNodeFor(FunctionSymbol* constExprFunctionSymbol);
+    void CheckReturnPaths(FunctionSymbol* constExprFunctionSymbol, FunctionNode& functionNode, ContainerScope* containerScope);
 private:
     BoundCompileUnit& boundCompileUnit;
+    std::unordered_map<FunctionSymbol*, FunctionNode*> functionNodeMap;
+    std::unordered_set<FunctionSymbol*> returnPathsChecked;
 };
 
 } } // namespace cmajor::binder
@@ -3732,7 +3732,7 @@ void Evaluator::Visit(InvokeNode& invokeNode)
         else if (functionSymbol->IsConstExpr())
         {
             FunctionNode* functionNode = boundCompileUnit.GetFunctionNodeFor(functionSymbol);
-            CheckFunctionReturnPaths(functionSymbol, *functionNode, containerScope, boundCompileUnit);
+            boundCompileUnit.CheckConstExprFunctionReturnPaths(functionSymbol, *functionNode, containerScope);
             bool skipFirst = memberFunctionCall || functionGroupValue->Receiver();
             argumentValues = ArgumentsToValues(functionCall->Arguments(), error, skipFirst, boundCompileUnit);
             if (error)
@@ -3746,6 +3746,28 @@ void Evaluator::Visit(InvokeNode& invokeNode)
                     ThrowCannotEvaluateStatically(module, span, invokeNode.GetSpan());
                 }
             }
+            ConstExprCallKey callKey(functionSymbol, templateTypeArguments, targetValueType, cast, LookupScopeKey(boundCompileUnit.FileScopes()));
+            bool memoize = !memberFunctionCall && !functionGroupValue->Receiver() && !currentClassType;
+            if (memoize)
+            {
+                for (const std::unique_ptr<Value>& argumentValue : argumentValues)
+                {
+                    if (!callKey.AddArgument(argumentValue.get()))
+                    {
+                        memoize = false;
+                        break;
+                    }
+                }
+            }
+            if (memoize)
+            {
+                value = module->GetConstExprCallCache().GetResult(callKey, invokeNode.GetSpan());
+                if (value)
+                {
+                    argumentValues.clear();
+                    return;
+                }
+            }
             ClassTypeSymbol* prevClassType = currentClassType;
             if (functionGroupValue->Receiver() && functionGroupValue->Receiver()->IsScopedValue())
             {
@@ -3758,6 +3780,10 @@ void Evaluator::Visit(InvokeNode& invokeNode)
             }
             functionNode->Accept(*this);
             currentClassType = prevClassType;
+            if (memoize && !error && value)
+            {
+                module->GetConstExprCallCache().SetResult(callKey, value.get());
+            }
         }
         else 
         {
@@ -27,6 +27,7 @@
 #include <cmajor/symbols/Meta.hpp>
 #include <cmajor/ast2dom/Ast2Dom.hpp>
 #include <cmajor/bdt2dom/Bdt2Dom.hpp>
+#include <cmajor/dom/Serializer.hpp>
 #include <cmajor/cmdoclib/Input.hpp>
 #include <cmajor/cmdoclib/Global.hpp>
 #include <cmajor/cmdoclib/ParserDoc.hpp>
@@ -47,6 +48,8 @@
 #include <cmajor/util/TextUtils.hpp>
 #include <cmajor/util/Log.hpp>
 #include <cmajor/util/Time.hpp>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Support/Path.h>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
@@ -120,9 +123,9 @@ std::vector<std::unique_ptr<CompileUnitNode>> ParseSourcesInMainThread(Module* m
                 std::unique_ptr<dom::Document> ast2xmlDoc = cmajor::ast2dom::GenerateAstDocument(compileUnit.get());
                 std::string ast2xmlFilePath = Path::ChangeExtension(sourceFilePath, ".ast.xml");
                 std::ofstream ast2xmlFile(ast2xmlFilePath);
-                CodeFormatter formatter(ast2xmlFile);
-                formatter.SetIndentSize(1);
-                ast2xmlDoc->Write(formatter);
+                dom::Serializer serializer(ast2xmlFile);
+                serializer.SetIndentSize(1);
+                serializer.Write(ast2xmlDoc.get());
             }
             if (GetGlobalFlag(GlobalFlags::generateDebugInfo) || GetGlobalFlag(GlobalFlags::cmdoc))
             {
@@ -190,9 +193,9 @@ void ParseSourceFile(ParserData* parserData)
                     std::unique_ptr<dom::Document> ast2xmlDoc = cmajor::ast2dom::GenerateAstDocument(compileUnit.get());
                     std::string ast2xmlFilePath = Path::ChangeExtension(sourceFilePath, ".ast.xml");
                     std::ofstream ast2xmlFile(ast2xmlFilePath);
-                    CodeFormatter formatter(ast2xmlFile);
-                    formatter.SetIndentSize(1);
-                    ast2xmlDoc->Write(formatter);
+                    dom::Serializer serializer(ast2xmlFile);
+                    serializer.SetIndentSize(1);
+                    serializer.Write(ast2xmlDoc.get());
                 }
                 if (GetGlobalFlag(GlobalFlags::generateDebugInfo) || GetGlobalFlag(GlobalFlags::cmdoc))
                 {
@@ -328,6 +331,7 @@ std::vector<std::unique_ptr<BoundCompileUnit>> BindTypes(Module& module, const s
             return std::vector<std::unique_ptr<BoundCompileUnit>>();
         }
         std::unique_ptr<BoundCompileUnit> boundCompileUnit(new BoundCompileUnit(module, compileUnit.get(), attributeBinder));
+        BoundNodeArenaScope arenaScope(boundCompileUnit->GetBoundNodeArena());
         boundCompileUnit->PushBindingTypes();
         TypeBinder typeBinder(*boundCompileUnit);
         compileUnit->Accept(typeBinder);
@@ -339,80 +343,51 @@ std::vector<std::unique_ptr<BoundCompileUnit>> BindTypes(Module& module, const s
 
 void BindStatements(BoundCompileUnit& boundCompileUnit)
 {
+    BoundNodeArenaScope arenaScope(boundCompileUnit.GetBoundNodeArena());
     StatementBinder statementBinder(boundCompileUnit);
     boundCompileUnit.GetCompileUnitNode()->Accept(statementBinder);
 }
 
-#ifdef _WIN32
-
-void GenerateLibrary(Module* module, const std::vector<std::string>& objectFilePaths, const std::string& libraryFilePath)
-{
-    if (GetGlobalFlag(GlobalFlags::verbose) && !GetGlobalFlag(GlobalFlags::unitTest))
-    {
-        LogMessage(module->LogStreamId(), "Creating library...");
-    }
-    module->SetCurrentToolName(U"llvm-lib");
-    std::vector<std::string> args;
-    args.push_back("/out:" + QuotedPath(libraryFilePath));
-    int n = objectFilePaths.size();
-    for (int i = 0; i < n; ++i)
-    {
-        args.push_back(QuotedPath(objectFilePaths[i]));
-    }
-    std::string libErrorFilePath = Path::Combine(Path::GetDirectoryName(libraryFilePath), "llvm-lib.error");
-    std::string libCommandLine = "cmfileredirector -2 " + libErrorFilePath + " llvm-lib";
-    for (const std::string& arg : args)
-    {
-        libCommandLine.append(1, ' ').append(arg);
-    }
-    try
-    {
-        System(libCommandLine);
-        boost::filesystem::remove(boost::filesystem::path(libErrorFilePath));
-    }
-    catch (const std::exception& ex)
-    {
-        std::string errors = ReadFile(libErrorFilePath);
-        throw std::runtime_error("generating library '" + libraryFilePath + "' failed: " + ex.what() + ":\nerrors:\n" + errors);
-    }
-    if (GetGlobalFlag(GlobalFlags::verbose) && !GetGlobalFlag(GlobalFlags::unitTest))
-    {
-        LogMessage(module->LogStreamId(), "==> " + libraryFilePath);
-    }
-}
-
-#else
-
 void GenerateLibrary(Module* module, const std::vector<std::string>& objectFilePaths, const std::string& libraryFilePath)
 {
     if (GetGlobalFlag(GlobalFlags::verbose) && !GetGlobalFlag(GlobalFlags::unitTest))
     {
         LogMessage(module->LogStreamId(), "Creating library...");
     }
-    boost::filesystem::remove(libraryFilePath);
-    module->SetCurrentToolName(U"ar");
-    std::vector<std::string> args;
-    args.push_back("-o " + QuotedPath(libraryFilePath));
-    int n = objectFilePaths.size();
-    for (int i = 0; i < n; ++i)
-    {
-        args.push_back(QuotedPath(objectFilePaths[i]));
-    }
-    std::string libErrorFilePath = Path::Combine(Path::GetDirectoryName(libraryFilePath), "ar.error");
-    std::string libCommandLine = "cmfileredirector -2 " + libErrorFilePath + " ar q";
-    for (const std::string& arg : args)
-    {
-        libCommandLine.append(1, ' ').append(arg);
-    }
-    try
+    module->SetCurrentToolName(U"cmc");
+    //  System libraries are copied to the system library directory when installed, so they are never created as thin archives.
+    bool thin = GetGlobalFlag(GlobalFlags::thinArchive) && !module->IsSystemModule();
+    std::vector<llvm::NewArchiveMember> members;
+    std::vector<std::string> memberNames;
+    memberNames.reserve(objectFilePaths.size());
+    for (const std::string& objectFilePath : objectFilePaths)
     {
-        System(libCommandLine);
-        boost::filesystem::remove(boost::filesystem::path(libErrorFilePath));
+        llvm::Expected<llvm::NewArchiveMember> member = llvm::NewArchiveMember::getFile(objectFilePath, true);
+        if (!member)
+        {
+            throw std::runtime_error("generating library '" + libraryFilePath + "' failed: " + llvm::toString(member.takeError()));
+        }
+        //  Like llvm-ar, store plain file names, or for thin archives, paths relative to the library.
+        if (thin)
+        {
+            llvm::Expected<std::string> relativePath = llvm::computeArchiveRelativePath(libraryFilePath, objectFilePath);
+            if (!relativePath)
+            {
+                throw std::runtime_error("generating library '" + libraryFilePath + "' failed: " + llvm::toString(relativePath.takeError()));
+            }
+            memberNames.push_back(*relativePath);
+        }
+        else
+        {
+            memberNames.push_back(llvm::sys::path::filename(objectFilePath).str());
+        }
+        member->MemberName = memberNames.back();
+        members.push_back(std::move(*member));
     }
-    catch (const std::exception& ex)
+    llvm::Error error = llvm::writeArchive(libraryFilePath, members, true, llvm::object::Archive::K_GNU, true, thin);
+    if (error)
     {
-        std::string errors = ReadFile(libErrorFilePath);
-        throw std::runtime_error("generating library '" + libraryFilePath + "' failed: " + ex.what() + ":\nerrors:\n" + errors);
+        throw std::runtime_error("generating library '" + libraryFilePath + "' failed: " + llvm::toString(std::move(error)));
     }
     if (GetGlobalFlag(GlobalFlags::verbose) && !GetGlobalFlag(GlobalFlags::unitTest))
     {
@@ -420,8 +395,6 @@ void GenerateLibrary(Module* module, const std::vector<std::string>& objectFileP
     }
 }
 
-#endif
-
 #ifdef _WIN32
 
 void CreateDefFile(const std::string& defFilePath, Module& module)
@@ -702,7 +675,7 @@ void CreateJsonRegistrationUnit(std::vector<std::string>& objectFilePaths, Modul
         AnalyzeControlFlow(boundJsonCompileUnit);
     }
     GenerateCode(emittingContext, boundJsonCompileUnit);
-    objectFilePaths.push_back(boundJsonCompileUnit.ObjectFilePath());
+    objectFilePaths.insert(objectFilePaths.end(), boundJsonCompileUnit.ObjectFilePaths().begin(), boundJsonCompileUnit.ObjectFilePaths().end());
 }
 
 void CreateMainUnit(std::vector<std::string>& objectFilePaths, Module& module, EmittingContext& emittingContext, AttributeBinder* attributeBinder)
@@ -826,7 +799,7 @@ void CreateMainUnit(std::vector<std::string>& objectFilePaths, Module& module, E
         AnalyzeControlFlow(boundMainCompileUnit);
     }
     GenerateCode(emittingContext, boundMainCompileUnit);
-    objectFilePaths.push_back(boundMainCompileUnit.ObjectFilePath());
+    objectFilePaths.insert(objectFilePaths.end(), boundMainCompileUnit.ObjectFilePaths().begin(), boundMainCompileUnit.ObjectFilePaths().end());
 }
 
 void SetDefines(Module* module, const std::string& definesFilePath)
@@ -903,6 +876,88 @@ void InstallSystemLibraries(Module* systemInstallModule)
     }
 }
 
+void EmitCompileUnit(Project* project, BoundCompileUnit* boundCompileUnit, EmittingContext& emittingContext, std::vector<std::string>& objectFilePaths, 
+    std::unordered_map<int, cmdoclib::File>& docFileMap)
+{
+    if (GetGlobalFlag(GlobalFlags::cmdoc))
+    {
+        cmdoclib::GenerateSourceCode(project, boundCompileUnit, docFileMap);
+    }
+    else
+    {
+        GenerateCode(emittingContext, *boundCompileUnit);
+        objectFilePaths.insert(objectFilePaths.end(), boundCompileUnit->ObjectFilePaths().begin(), boundCompileUnit->ObjectFilePaths().end());
+    }
+}
+
+//  Whole-program devirtualization needs every class of the program, so when building a program with it, 
+//  the statements of all compile units are bound before code is generated for any of them.
+
+bool DevirtualizeCalls(Project* project)
+{
+    return GetGlobalFlag(GlobalFlags::devirtualize) && project->GetTarget() == Target::program && !GetGlobalFlag(GlobalFlags::cmdoc);
+}
+
+void CreateClassHierarchyAnalysis(Module* rootModule)
+{
+    ClassHierarchyAnalysis* classHierarchyAnalysis = new ClassHierarchyAnalysis(rootModule->GetSymbolTable());
+    rootModule->SetClassHierarchyAnalysis(classHierarchyAnalysis);
+    if (GetGlobalFlag(GlobalFlags::verbose))
+    {
+        LogMessage(rootModule->LogStreamId(), "Devirtualizing calls using class hierarchy of " + std::to_string(classHierarchyAnalysis->NumClasses()) + " polymorphic classes...");
+    }
+}
+
+//  In pipelined mode the function bodies of a compile unit are released as soon as code has been generated for it.
+//  The syntax trees the symbol table still needs for binding the other compile units and for writing the module are kept: 
+//  those of function templates, class templates, concepts, and inline and constexpr functions.
+
+bool PipelinedCompile()
+{
+    return GetGlobalFlag(GlobalFlags::pipelinedCompile) && !GetGlobalFlag(GlobalFlags::cmdoc);
+}
+
+void ReleaseFunctionBodies(SymbolTable& symbolTable, Node* node)
+{
+    if (node->GetNodeType() == NodeType::namespaceNode)
+    {
+        NamespaceNode* namespaceNode = static_cast<NamespaceNode*>(node);
+        int n = namespaceNode->Members().Count();
+        for (int i = 0; i < n; ++i)
+        {
+            ReleaseFunctionBodies(symbolTable, namespaceNode->Members()[i]);
+        }
+    }
+    else if (node->GetNodeType() == NodeType::classNode)
+    {
+        ClassNode* classNode = static_cast<ClassNode*>(node);
+        if (classNode->TemplateParameters().Count() > 0) return;
+        int n = classNode->Members().Count();
+        for (int i = 0; i < n; ++i)
+        {
+            ReleaseFunctionBodies(symbolTable, classNode->Members()[i]);
+        }
+    }
+    else if (node->IsFunctionNode())
+    {
+        FunctionNode* functionNode = static_cast<FunctionNode*>(node);
+        if (!functionNode->Body() && !functionNode->BodySource()) return;
+        Symbol* symbol = symbolTable.GetSymbolNoThrow(functionNode);
+        if (!symbol || !symbol->IsFunctionSymbol()) return;
+        FunctionSymbol* functionSymbol = static_cast<FunctionSymbol*>(symbol);
+        if (functionSymbol->IsFunctionTemplate() || functionSymbol->IsInline() || functionSymbol->IsConstExpr()) return;
+        symbolTable.UnmapFunctionBody(functionSymbol);
+        functionNode->ReleaseBody();
+    }
+}
+
+void ReleaseCompileUnit(std::unique_ptr<BoundCompileUnit>& boundCompileUnit, SymbolTable& symbolTable)
+{
+    CompileUnitNode* compileUnitNode = boundCompileUnit->GetCompileUnitNode();
+    boundCompileUnit.reset();
+    ReleaseFunctionBodies(symbolTable, compileUnitNode->GlobalNs());
+}
+
 void CompileSingleThreaded(Project* project, Module* rootModule, std::vector<std::unique_ptr<BoundCompileUnit>>& boundCompileUnits, EmittingContext& emittingContext,
     std::vector<std::string>& objectFilePaths, std::unordered_map<int, cmdoclib::File>& docFileMap, bool& stop)
 {
@@ -911,6 +966,8 @@ void CompileSingleThreaded(Project* project, Module* rootModule, std::vector<std
         LogMessage(project->LogStreamId(), "Compiling...");
     }
     rootModule->StartBuild();
+    bool devirtualize = DevirtualizeCalls(project);
+    bool pipelined = PipelinedCompile();
     for (std::unique_ptr<BoundCompileUnit>& boundCompileUnit : boundCompileUnits)
     {
         if (stop)
@@ -931,18 +988,33 @@ void CompileSingleThreaded(Project* project, Module* rootModule, std::vector<std
             std::unique_ptr<dom::Document> bdtDoc = cmajor::bdt2dom::GenerateBdtDocument(boundCompileUnit.get());
             std::string bdtXmlFilePath = Path::ChangeExtension(boundCompileUnit->GetCompileUnitNode()->FilePath(), ".bdt.xml");
             std::ofstream bdtXmlFile(bdtXmlFilePath);
-            CodeFormatter formatter(bdtXmlFile);
-            formatter.SetIndentSize(1);
-            bdtDoc->Write(formatter);
+            dom::Serializer serializer(bdtXmlFile);
+            serializer.SetIndentSize(1);
+            serializer.Write(bdtDoc.get());
         }
-        if (GetGlobalFlag(GlobalFlags::cmdoc))
+        if (!devirtualize)
         {
-            cmdoclib::GenerateSourceCode(project, boundCompileUnit.get(), docFileMap);
+            EmitCompileUnit(project, boundCompileUnit.get(), emittingContext, objectFilePaths, docFileMap);
+            if (pipelined)
+            {
+                ReleaseCompileUnit(boundCompileUnit, rootModule->GetSymbolTable());
+            }
         }
-        else
+    }
+    if (devirtualize)
+    {
+        CreateClassHierarchyAnalysis(rootModule);
+        for (std::unique_ptr<BoundCompileUnit>& boundCompileUnit : boundCompileUnits)
         {
-            GenerateCode(emittingContext, *boundCompileUnit);
-            objectFilePaths.push_back(boundCompileUnit->ObjectFilePath());
+            if (stop)
+            {
+                return;
+            }
+            EmitCompileUnit(project, boundCompileUnit.get(), emittingContext, objectFilePaths, docFileMap);
+            if (pipelined)
+            {
+                ReleaseCompileUnit(boundCompileUnit, rootModule->GetSymbolTable());
+            }
         }
     }
     rootModule->StopBuild();
@@ -967,6 +1039,7 @@ public:
     CompileQueue(const std::string& name_, bool& stop_, bool& ready_, int logStreamId_);
     void Put(int compileUnitIndex);
     int Get();
+    int TryGet();
 private:
     std::string name;
     std::list<int> queue;
@@ -1008,6 +1081,15 @@ int CompileQueue::Get()
     return -1;
 }
 
+int CompileQueue::TryGet()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (queue.empty()) return -1;
+    int compileUnitIndex = queue.front();
+    queue.pop_front();
+    return compileUnitIndex;
+}
+
 struct CompileData
 {
     CompileData(Module* rootModule_, std::vector<std::unique_ptr<BoundCompileUnit>>& boundCompileUnits_, std::vector<std::string>& objectFilePaths_, bool& stop_, bool& ready_,
@@ -1053,7 +1135,7 @@ void GenerateCode(CompileData* data, int threadId)
                         " of " + std::to_string(data->boundCompileUnits.size()));
                 }
                 std::lock_guard<std::mutex> lock(data->mtx);
-                data->objectFilePaths.push_back(compileUnit->ObjectFilePath());
+                data->objectFilePaths.insert(data->objectFilePaths.end(), compileUnit->ObjectFilePaths().begin(), compileUnit->ObjectFilePaths().end());
                 data->boundCompileUnits[compileUnitIndex].reset();
                 data->output.Put(compileUnitIndex);
             }
@@ -1088,12 +1170,20 @@ void CompileMultiThreaded(Project* project, Module* rootModule, std::vector<std:
     CompileQueue input("input", stop, ready, rootModule->LogStreamId());
     CompileQueue output("output", stop, ready, rootModule->LogStreamId());
     CompileData compileData(rootModule, boundCompileUnits, objectFilePaths, stop, ready, numThreads, input, output);
+    bool pipelined = PipelinedCompile();
+    std::vector<CompileUnitNode*> compileUnitNodes;
+    for (const std::unique_ptr<BoundCompileUnit>& boundCompileUnit : boundCompileUnits)
+    {
+        compileUnitNodes.push_back(boundCompileUnit->GetCompileUnitNode());
+    }
     std::vector<std::thread> threads;
     for (int i = 0; i < numThreads; ++i)
     {
         threads.push_back(std::thread{ GenerateCode, &compileData, i });
     }
+    bool devirtualize = DevirtualizeCalls(project);
     int n = boundCompileUnits.size();
+    int numOutputsReceived = 0;
     for (int i = 0; i < n; ++i)
     {
         BoundCompileUnit* compileUnit = boundCompileUnits[i].get();
@@ -1134,14 +1224,38 @@ void CompileMultiThreaded(Project* project, Module* rootModule, std::vector<std:
         {
             LogMessage(rootModule->LogStreamId(), CurrentCompileDebugMsStr() + " end bind statements of compile unit " + std::to_string(i) + " of " + std::to_string(n));
         }
-        input.Put(i);
+        if (!devirtualize)
+        {
+            input.Put(i);
+            if (pipelined)
+            {
+                int compileUnitIndex = output.TryGet();
+                while (compileUnitIndex != -1)
+                {
+                    ReleaseFunctionBodies(rootModule->GetSymbolTable(), compileUnitNodes[compileUnitIndex]->GlobalNs());
+                    ++numOutputsReceived;
+                    compileUnitIndex = output.TryGet();
+                }
+            }
+        }
+    }
+    if (devirtualize)
+    {
+        CreateClassHierarchyAnalysis(rootModule);
+        for (int i = 0; i < n; ++i)
+        {
+            input.Put(i);
+        }
     }
-    int numOutputsReceived = 0;
     while (numOutputsReceived < n && !stop)
     {
         int compileUnitIndex = output.Get();
-        if (numOutputsReceived != -1)
+        if (compileUnitIndex != -1)
         {
+            if (pipelined)
+            {
+                ReleaseFunctionBodies(rootModule->GetSymbolTable(), compileUnitNodes[compileUnitIndex]->GlobalNs());
+            }
             ++numOutputsReceived;
         }
     }
@@ -1222,9 +1336,9 @@ void BuildProject(Project* project, std::unique_ptr<Module>& rootModule, bool& s
             std::unique_ptr<dom::Document> symbolTableDoc = rootModule->GetSymbolTable().ToDomDocument();
             std::string symbolTableXmlFilePath = Path::ChangeExtension(project->FilePath(), ".sym0.xml");
             std::ofstream symbolTableXmlFile(symbolTableXmlFilePath);
-            CodeFormatter formatter(symbolTableXmlFile);
-            formatter.SetIndentSize(1);
-            symbolTableDoc->Write(formatter);
+            dom::Serializer serializer(symbolTableXmlFile);
+            serializer.SetIndentSize(1);
+            serializer.Write(symbolTableDoc.get());
         }
         CompileUnitNode* compileUnit0 = nullptr;
         if (!compileUnits.empty())
@@ -1246,9 +1360,9 @@ void BuildProject(Project* project, std::unique_ptr<Module>& rootModule, bool& s
             std::unique_ptr<dom::Document> symbolTableDoc = rootModule->GetSymbolTable().ToDomDocument();
             std::string symbolTableXmlFilePath = Path::ChangeExtension(project->FilePath(), ".sym1.xml");
             std::ofstream symbolTableXmlFile(symbolTableXmlFilePath);
-            CodeFormatter formatter(symbolTableXmlFile);
-            formatter.SetIndentSize(1);
-            symbolTableDoc->Write(formatter);
+            dom::Serializer serializer(symbolTableXmlFile);
+            serializer.SetIndentSize(1);
+            serializer.Write(symbolTableDoc.get());
         }
         std::unordered_map<int, cmdoclib::File> docFileMap;
         EmittingContext emittingContext;
@@ -1273,9 +1387,9 @@ void BuildProject(Project* project, std::unique_ptr<Module>& rootModule, bool& s
                 std::unique_ptr<dom::Document> symbolTableDoc = rootModule->GetSymbolTable().ToDomDocument();
                 std::string symbolTableXmlFilePath = Path::ChangeExtension(project->FilePath(), ".sym2.xml");
                 std::ofstream symbolTableXmlFile(symbolTableXmlFilePath);
-                CodeFormatter formatter(symbolTableXmlFile);
-                formatter.SetIndentSize(1);
-                symbolTableDoc->Write(formatter);
+                dom::Serializer serializer(symbolTableXmlFile);
+                serializer.SetIndentSize(1);
+                serializer.Write(symbolTableDoc.get());
             }
             if (project->GetTarget() == Target::program)
             {
@@ -1294,6 +1408,7 @@ void BuildProject(Project* project, std::unique_ptr<Module>& rootModule, bool& s
             {
                 Link(project->ExecutableFilePath(), project->LibraryFilePath(), rootModule->LibraryFilePaths(), *rootModule);
             }
+            rootModule->SetClassHierarchyAnalysis(nullptr);
             if (GetGlobalFlag(GlobalFlags::verbose))
             {
                 LogMessage(project->LogStreamId(), "Writing module file...");
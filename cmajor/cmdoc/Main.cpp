@@ -59,9 +59,13 @@ void PrintHelp()
     std::cout << "--help (-h)" << std::endl;
     std::cout << "  print this help" << std::endl;
     std::cout << "--optimize (-o)" << std::endl;
-    std::cout << "  optimize output generation" << std::endl;
+    std::cout << "  optimize output generation:" << std::endl;
+    std::cout << "  skip projects and modules whose documentation is up-to-date" << std::endl;
     std::cout << "--build-threads=N (-bt=N)" << std::endl;
-    std::cout << "  set number of build threads to N\n" << std::endl;
+    std::cout << "  set number of build threads to N" << std::endl;
+    std::cout << "--doc-threads=N (-dt=N)" << std::endl;
+    std::cout << "  set number of threads used to generate HTML pages to N" << std::endl;
+    std::cout << "  default is the number of hardware threads\n" << std::endl;
 }
 
 using namespace cmajor::cmdoclib;
@@ -107,6 +111,11 @@ int main(int argc, const char** argv)
                             int numBuildThreads = boost::lexical_cast<int>(components[1]);
                             SetNumBuildThreads(numBuildThreads);
                         }
+                        else if (components[0] == "--doc-threads" || components[0] == "-dt")
+                        {
+                            int numDocThreads = boost::lexical_cast<int>(components[1]);
+                            SetNumDocThreads(numDocThreads);
+                        }
                         else
                         { 
                             throw std::runtime_error("unknown option '" + arg + "'");
@@ -13,13 +13,20 @@
 #include <cmajor/dom/Parser.hpp>
 #include <cmajor/dom/Element.hpp>
 #include <cmajor/dom/CharacterData.hpp>
+#include <cmajor/dom/Serializer.hpp>
 #include <cmajor/util/Path.hpp>
 #include <cmajor/util/Unicode.hpp>
 #include <cmajor/util/Util.hpp>
 #include <cmajor/util/TextUtils.hpp>
+#include <cmajor/util/Time.hpp>
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <thread>
 
 namespace cmajor { namespace cmdoclib {
 
@@ -347,6 +354,162 @@ std::unique_ptr<dom::Element> GetDescriptionAndDetails(Input* input, const std::
     return allParagraphs;
 }
 
+int numDocThreads = 0;
+
+void SetNumDocThreads(int numDocThreads_)
+{
+    numDocThreads = numDocThreads_;
+}
+
+int GetNumDocThreads()
+{
+    if (numDocThreads <= 0)
+    {
+        return std::max(1, int(std::thread::hardware_concurrency()));
+    }
+    return numDocThreads;
+}
+
+//  Runs page generation tasks on a fixed set of threads. A task may schedule further tasks.
+//  Page generation only reads the module documents and builds a document of its own, so the tasks need no other synchronization.
+
+class PageQueue
+{
+public:
+    PageQueue(int numThreads);
+    PageQueue(const PageQueue&) = delete;
+    PageQueue& operator=(const PageQueue&) = delete;
+    ~PageQueue();
+    void Put(std::function<void()>&& task);
+    void Wait();
+private:
+    std::mutex mtx;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    std::deque<std::function<void()>> tasks;
+    int numPendingTasks;
+    bool exiting;
+    std::exception_ptr exception;
+    std::vector<std::thread> threads;
+    void Run();
+};
+
+PageQueue::PageQueue(int numThreads) : numPendingTasks(0), exiting(false)
+{
+    for (int i = 0; i < numThreads; ++i)
+    {
+        threads.push_back(std::thread{ &PageQueue::Run, this });
+    }
+}
+
+PageQueue::~PageQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        exiting = true;
+    }
+    taskAvailable.notify_all();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void PageQueue::Put(std::function<void()>&& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        tasks.push_back(std::move(task));
+        ++numPendingTasks;
+    }
+    taskAvailable.notify_one();
+}
+
+void PageQueue::Wait()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    allDone.wait(lock, [this]{ return numPendingTasks == 0; });
+    if (exception)
+    {
+        std::exception_ptr ex = exception;
+        exception = std::exception_ptr();
+        std::rethrow_exception(ex);
+    }
+}
+
+void PageQueue::Run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            taskAvailable.wait(lock, [this]{ return exiting || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            if (exception)
+            {
+                task = std::function<void()>();
+            }
+        }
+        if (task)
+        {
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!exception)
+                {
+                    exception = std::current_exception();
+                }
+            }
+        }
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            --numPendingTasks;
+            done = numPendingTasks == 0;
+        }
+        if (done)
+        {
+            allDone.notify_all();
+        }
+    }
+}
+
+PageQueue* pageQueue = nullptr;
+
+void SchedulePage(std::function<void()>&& generatePage)
+{
+    if (pageQueue)
+    {
+        pageQueue->Put(std::move(generatePage));
+    }
+    else
+    {
+        generatePage();
+    }
+}
+
+std::mutex outputMutex;
+
+void WriteHtmlFile(dom::Document& htmlDoc, const std::string& htmlFilePath)
+{
+    std::ofstream htmlFile(htmlFilePath);
+    dom::Serializer serializer(htmlFile);
+    serializer.SetIndentSize(1);
+    serializer.Write(&htmlDoc);
+    if (GetGlobalFlag(GlobalFlags::verbose))
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << "==> " << htmlFilePath << std::endl;
+    }
+}
+
 void GenerateRootIndexHtml(Input* input, const std::string& targetDir, const std::u32string& solutionName, const std::vector<std::u32string>& moduleNames, 
     const std::vector<std::string>& moduleLinks, const std::vector<std::unique_ptr<dom::Document>>& moduleXmlDocs)
 {
@@ -414,14 +577,7 @@ void GenerateRootIndexHtml(Input* input, const std::string& targetDir, const std
     htmlElement->AppendChild(std::unique_ptr<dom::Node>(bodyElement.release()));
     indexDoc.AppendChild(std::unique_ptr<dom::Node>(htmlElement.release()));
     std::string indexFilePath = GetFullPath(Path::Combine(targetDir, "index.html"));
-    std::ofstream indexFile(indexFilePath);
-    CodeFormatter formatter(indexFile);
-    formatter.SetIndentSize(1);
-    indexDoc.Write(formatter);
-    if (GetGlobalFlag(GlobalFlags::verbose))
-    {
-        std::cout << "==> " << indexFilePath << std::endl;
-    }
+    WriteHtmlFile(indexDoc, indexFilePath);
 }
 
 bool GenerateNamespaceNames(int level, dom::Element* namespaceTableElement, dom::Element* namespaceParentElement, const std::u32string& prefix,
@@ -2023,14 +2179,7 @@ void GenerateEnumdoc(Input* input, const std::string& docDir, dom::Element* enum
     htmlElement->AppendChild(std::unique_ptr<dom::Node>(bodyElement.release()));
     doc.AppendChild(std::unique_ptr<dom::Node>(htmlElement.release()));
     std::string docFilePath = GetFullPath(Path::Combine(docDir, ToUtf8(enumTypeElement->GetAttribute(U"id")) + ".html"));
-    std::ofstream docFile(docFilePath);
-    CodeFormatter formatter(docFile);
-    formatter.SetIndentSize(1);
-    doc.Write(formatter);
-    if (GetGlobalFlag(GlobalFlags::verbose))
-    {
-        std::cout << "==> " << docFilePath << std::endl;
-    }
+    WriteHtmlFile(doc, docFilePath);
 }
 
 void GenerateClassDoc(Input* input, const std::string& docDir, dom::Element* classElement, dom::Document* moduleXmlDoc, const std::vector<dom::Document*>& otherModuleXmlDocs)
@@ -2254,7 +2403,7 @@ void GenerateClassDoc(Input* input, const std::string& docDir, dom::Element* cla
                 trElement->AppendChild(std::unique_ptr<dom::Node>(td3Element.release()));
             }
             classTableElement->AppendChild(std::unique_ptr<dom::Node>(trElement.release()));
-            GenerateClassDoc(input, docDir, classElement, moduleXmlDoc, otherModuleXmlDocs);
+            SchedulePage([=]() { GenerateClassDoc(input, docDir, classElement, moduleXmlDoc, otherModuleXmlDocs); });
         }
         bodyElement->AppendChild(std::unique_ptr<dom::Node>(classTableElement.release()));
     }
@@ -2504,7 +2653,7 @@ void GenerateClassDoc(Input* input, const std::string& docDir, dom::Element* cla
                 trElement->AppendChild(std::unique_ptr<dom::Node>(td3Element.release()));
             }
             enumTypeTableElement->AppendChild(std::unique_ptr<dom::Node>(trElement.release()));
-            GenerateEnumdoc(input, docDir, enumTypeElement, moduleXmlDoc, otherModuleXmlDocs);
+            SchedulePage([=]() { GenerateEnumdoc(input, docDir, enumTypeElement, moduleXmlDoc, otherModuleXmlDocs); });
         }
         bodyElement->AppendChild(std::unique_ptr<dom::Node>(enumTypeTableElement.release()));
     }
@@ -2583,14 +2732,7 @@ void GenerateClassDoc(Input* input, const std::string& docDir, dom::Element* cla
     htmlElement->AppendChild(std::unique_ptr<dom::Node>(bodyElement.release()));
     doc.AppendChild(std::unique_ptr<dom::Node>(htmlElement.release()));
     std::string docFilePath = GetFullPath(Path::Combine(docDir, ToUtf8(classElement->GetAttribute(U"id")) + ".html"));
-    std::ofstream docFile(docFilePath);
-    CodeFormatter formatter(docFile);
-    formatter.SetIndentSize(1);
-    doc.Write(formatter);
-    if (GetGlobalFlag(GlobalFlags::verbose))
-    {
-        std::cout << "==> " << docFilePath << std::endl;
-    }
+    WriteHtmlFile(doc, docFilePath);
 }
 
 void GetConcepts(dom::Element* parentElement, std::unique_ptr<xpath::XPathObject>& conceptObject, std::vector<dom::Element*>& conceptElements)
@@ -2883,14 +3025,7 @@ void GenerateConceptDoc(Input* input, const std::string& docDir, dom::Element* c
     htmlElement->AppendChild(std::unique_ptr<dom::Node>(bodyElement.release()));
     doc.AppendChild(std::unique_ptr<dom::Node>(htmlElement.release()));
     std::string docFilePath = GetFullPath(Path::Combine(docDir, ToUtf8(conceptElement->GetAttribute(U"id")) + ".html"));
-    std::ofstream docFile(docFilePath);
-    CodeFormatter formatter(docFile);
-    formatter.SetIndentSize(1);
-    doc.Write(formatter);
-    if (GetGlobalFlag(GlobalFlags::verbose))
-    {
-        std::cout << "==> " << docFilePath << std::endl;
-    }
+    WriteHtmlFile(doc, docFilePath);
 }
 
 void GenerateNamespaceDoc(Input* input, const std::string& docDir, dom::Element* nsElement, dom::Document* moduleXmlDoc, const std::vector<dom::Document*>& otherModuleXmlDocs)
@@ -2968,7 +3103,7 @@ void GenerateNamespaceDoc(Input* input, const std::string& docDir, dom::Element*
                 trElement->AppendChild(std::unique_ptr<dom::Node>(td3Element.release()));
             }
             conceptTableElement->AppendChild(std::unique_ptr<dom::Node>(trElement.release()));
-            GenerateConceptDoc(input, docDir, conceptElement, moduleXmlDoc, otherModuleXmlDocs);
+            SchedulePage([=]() { GenerateConceptDoc(input, docDir, conceptElement, moduleXmlDoc, otherModuleXmlDocs); });
         }
         bodyElement->AppendChild(std::unique_ptr<dom::Node>(conceptTableElement.release()));
     }
@@ -3006,7 +3141,7 @@ void GenerateNamespaceDoc(Input* input, const std::string& docDir, dom::Element*
                 trElement->AppendChild(std::unique_ptr<dom::Node>(td3Element.release()));
             }
             classTableElement->AppendChild(std::unique_ptr<dom::Node>(trElement.release()));
-            GenerateClassDoc(input, docDir, classElement, moduleXmlDoc, otherModuleXmlDocs);
+            SchedulePage([=]() { GenerateClassDoc(input, docDir, classElement, moduleXmlDoc, otherModuleXmlDocs); });
         }
         bodyElement->AppendChild(std::unique_ptr<dom::Node>(classTableElement.release()));
     }
@@ -3198,7 +3333,7 @@ void GenerateNamespaceDoc(Input* input, const std::string& docDir, dom::Element*
                 trElement->AppendChild(std::unique_ptr<dom::Node>(td3Element.release()));
             }
             enumTypeTableElement->AppendChild(std::unique_ptr<dom::Node>(trElement.release()));
-            GenerateEnumdoc(input, docDir, enumTypeElement, moduleXmlDoc, otherModuleXmlDocs);
+            SchedulePage([=]() { GenerateEnumdoc(input, docDir, enumTypeElement, moduleXmlDoc, otherModuleXmlDocs); });
         }
         bodyElement->AppendChild(std::unique_ptr<dom::Node>(enumTypeTableElement.release()));
     }
@@ -3242,14 +3377,7 @@ void GenerateNamespaceDoc(Input* input, const std::string& docDir, dom::Element*
     htmlElement->AppendChild(std::unique_ptr<dom::Node>(bodyElement.release()));
     doc.AppendChild(std::unique_ptr<dom::Node>(htmlElement.release()));
     std::string docFilePath = GetFullPath(Path::Combine(docDir, ToUtf8(nsElement->GetAttribute(U"id")) + ".html"));
-    std::ofstream docFile(docFilePath);
-    CodeFormatter formatter(docFile);
-    formatter.SetIndentSize(1);
-    doc.Write(formatter);
-    if (GetGlobalFlag(GlobalFlags::verbose))
-    {
-        std::cout << "==> " << docFilePath << std::endl;
-    }
+    WriteHtmlFile(doc, docFilePath);
 }
 
 void GenerateModuleIndexHtml(Input* input, const std::string& moduleDir, const std::u32string& moduleName, dom::Document* moduleXmlDoc, 
@@ -3333,7 +3461,7 @@ void GenerateModuleIndexHtml(Input* input, const std::string& moduleDir, const s
                 for (int i = 0; i < n; ++i)
                 {
                     dom::Element* nsElement = nsElements[i];
-                    GenerateNamespaceDoc(input, docDir, nsElement, moduleXmlDoc, otherModuleXmlDocs);
+                    SchedulePage([=]() { GenerateNamespaceDoc(input, docDir, nsElement, moduleXmlDoc, otherModuleXmlDocs); });
                 }
             }
         }
@@ -3411,7 +3539,7 @@ void GenerateModuleIndexHtml(Input* input, const std::string& moduleDir, const s
                     trElement->AppendChild(std::unique_ptr<dom::Node>(td3Element.release()));
                 }
                 conceptTableElement->AppendChild(std::unique_ptr<dom::Node>(trElement.release()));
-                GenerateConceptDoc(input, docDir, conceptElement, moduleXmlDoc, otherModuleXmlDocs);
+                SchedulePage([=]() { GenerateConceptDoc(input, docDir, conceptElement, moduleXmlDoc, otherModuleXmlDocs); });
             }
             bodyElement->AppendChild(std::unique_ptr<dom::Node>(conceptTableElement.release()));
         }
@@ -3447,7 +3575,7 @@ void GenerateModuleIndexHtml(Input* input, const std::string& moduleDir, const s
                     trElement->AppendChild(std::unique_ptr<dom::Node>(td3Element.release()));
                 }
                 classTableElement->AppendChild(std::unique_ptr<dom::Node>(trElement.release()));
-                GenerateClassDoc(input, docDir, classElement, moduleXmlDoc, otherModuleXmlDocs);
+                SchedulePage([=]() { GenerateClassDoc(input, docDir, classElement, moduleXmlDoc, otherModuleXmlDocs); });
             }
             bodyElement->AppendChild(std::unique_ptr<dom::Node>(classTableElement.release()));
         }
@@ -3641,7 +3769,7 @@ void GenerateModuleIndexHtml(Input* input, const std::string& moduleDir, const s
                     trElement->AppendChild(std::unique_ptr<dom::Node>(td3Element.release()));
                 }
                 enumTypeTableElement->AppendChild(std::unique_ptr<dom::Node>(trElement.release()));
-                GenerateEnumdoc(input, docDir, enumTypeElement, moduleXmlDoc, otherModuleXmlDocs);
+                SchedulePage([=]() { GenerateEnumdoc(input, docDir, enumTypeElement, moduleXmlDoc, otherModuleXmlDocs); });
             }
             bodyElement->AppendChild(std::unique_ptr<dom::Node>(enumTypeTableElement.release()));
         }
@@ -3686,14 +3814,30 @@ void GenerateModuleIndexHtml(Input* input, const std::string& moduleDir, const s
     htmlElement->AppendChild(std::unique_ptr<dom::Node>(bodyElement.release()));
     indexDoc.AppendChild(std::unique_ptr<dom::Node>(htmlElement.release()));
     std::string indexFilePath = GetFullPath(Path::Combine(moduleDir, "index.html"));
-    std::ofstream indexFile(indexFilePath);
-    CodeFormatter formatter(indexFile);
-    formatter.SetIndentSize(1);
-    indexDoc.Write(formatter);
-    if (GetGlobalFlag(GlobalFlags::verbose))
+    WriteHtmlFile(indexDoc, indexFilePath);
+}
+
+//  Module pages are up-to-date if they have been generated completely after the last change of any module XML or documentation file they are generated from.
+//  Up-to-date checking is done for a module as a whole, not for each page: the pages of a module link to each other and to the pages of the other modules, 
+//  so a change in one input file may change any page of the module. If any input is newer than the stamp, all pages of the module are generated again.
+
+bool ModuleDocsUpToDate(const std::string& moduleDir, const std::vector<std::string>& inputFilePaths)
+{
+    std::string stampFilePath = Path::Combine(moduleDir, "doc.stamp");
+    if (!boost::filesystem::exists(stampFilePath)) return false;
+    std::time_t stampTime = boost::filesystem::last_write_time(stampFilePath);
+    for (const std::string& inputFilePath : inputFilePaths)
     {
-        std::cout << "==> " << indexFilePath << std::endl;
+        if (boost::filesystem::exists(inputFilePath) && stampTime < boost::filesystem::last_write_time(inputFilePath)) return false;
     }
+    return true;
+}
+
+void WriteModuleDocsStamp(const std::string& moduleDir)
+{
+    std::string stampFilePath = Path::Combine(moduleDir, "doc.stamp");
+    std::ofstream stampFile(stampFilePath);
+    stampFile << GetCurrentDateTime().ToString() << std::endl;
 }
 
 void BuildDocs(const std::u32string& solutionName, const std::vector<std::u32string>& moduleNames, std::vector<std::string>& grammarFilePaths)
@@ -3710,6 +3854,19 @@ void BuildDocs(const std::u32string& solutionName, const std::vector<std::u32str
     boost::filesystem::create_directories(contentDir);
     std::vector<std::unique_ptr<dom::Document>> moduleXmlFiles;
     std::vector<std::string> moduleLinks;
+    std::vector<std::string> inputFilePaths;
+    if (!input->docFilePath.empty())
+    {
+        inputFilePaths.push_back(input->docFilePath);
+    }
+    for (const auto& p : input->libraryPrefixMap)
+    {
+        if (!p.second.empty())
+        {
+            std::string moduleNameStr = ToUtf8(p.first);
+            inputFilePaths.push_back(Path::Combine(Path::Combine(Path::Combine(input->baseDir, p.second), moduleNameStr), moduleNameStr + ".xml"));
+        }
+    }
     for (const std::u32string& moduleName : moduleNames)
     {
         std::string moduleNameStr = ToUtf8(moduleName);
@@ -3726,34 +3883,72 @@ void BuildDocs(const std::u32string& solutionName, const std::vector<std::u32str
         }
         std::unique_ptr<dom::Document> moduleXmlFile = dom::ReadDocument(moduleXmlFilePath);
         moduleXmlFiles.push_back(std::move(moduleXmlFile));
+        inputFilePaths.push_back(moduleXmlFilePath);
     }
-    int n = moduleNames.size();
-    for (int i = 0; i < n; ++i)
+    int numThreads = GetNumDocThreads();
+    std::unique_ptr<PageQueue> queue;
+    if (numThreads > 1)
     {
-        const std::u32string& moduleName = moduleNames[i];
-        std::string moduleNameStr = ToUtf8(moduleName);
-        std::string moduleDir = GetFullPath(Path::Combine(contentDir, moduleNameStr));
-        std::string grammarXmlFilePath = GetFullPath(Path::Combine(moduleDir, "grammars.xml"));
-        std::string relativeModuleDir = Path::Combine("content", moduleNameStr);
-        std::vector<GrammarInfo> grammars;
-        BuildParserDocs(input, moduleDir, grammarXmlFilePath, relativeModuleDir, grammarFilePaths, moduleName, grammars);
-        dom::Document* moduleXmlDoc = moduleXmlFiles[i].get();
-        std::vector<dom::Document*> otherModuleXmlDocs;
+        queue.reset(new PageQueue(numThreads));
+        pageQueue = queue.get();
+    }
+    std::vector<std::string> generatedModuleDirs;
+    try
+    {
+        int n = moduleNames.size();
+        for (int i = 0; i < n; ++i)
         {
-            std::lock_guard<std::mutex> lock(GetInputMutex());
-            for (const auto& externalModuleDoc : input->externalModuleDocs)
+            const std::u32string& moduleName = moduleNames[i];
+            std::string moduleNameStr = ToUtf8(moduleName);
+            std::string moduleDir = GetFullPath(Path::Combine(contentDir, moduleNameStr));
+            std::string grammarXmlFilePath = GetFullPath(Path::Combine(moduleDir, "grammars.xml"));
+            std::string relativeModuleDir = Path::Combine("content", moduleNameStr);
+            std::vector<GrammarInfo> grammars;
+            BuildParserDocs(input, moduleDir, grammarXmlFilePath, relativeModuleDir, grammarFilePaths, moduleName, grammars);
+            if (GetGlobalFlag(GlobalFlags::optimizeCmDoc) && ModuleDocsUpToDate(moduleDir, inputFilePaths))
+            {
+                if (verbose)
+                {
+                    std::cout << "Module '" << moduleNameStr << "' documentation is up-to-date." << std::endl;
+                }
+                continue;
+            }
+            dom::Document* moduleXmlDoc = moduleXmlFiles[i].get();
+            std::vector<dom::Document*> otherModuleXmlDocs;
             {
-                otherModuleXmlDocs.push_back(externalModuleDoc.get());
+                std::lock_guard<std::mutex> lock(GetInputMutex());
+                for (const auto& externalModuleDoc : input->externalModuleDocs)
+                {
+                    otherModuleXmlDocs.push_back(externalModuleDoc.get());
+                }
             }
-        }
-        for (int j = 0; j < n; ++j)
-        {
-            if (i != j)
+            for (int j = 0; j < n; ++j)
             {
-                otherModuleXmlDocs.push_back(moduleXmlFiles[j].get());
+                if (i != j)
+                {
+                    otherModuleXmlDocs.push_back(moduleXmlFiles[j].get());
+                }
             }
+            GenerateModuleIndexHtml(input, moduleDir, moduleName, moduleXmlDoc, otherModuleXmlDocs, grammars);
+            generatedModuleDirs.push_back(moduleDir);
+        }
+        if (queue)
+        {
+            queue->Wait();
         }
-        GenerateModuleIndexHtml(input, moduleDir, moduleName, moduleXmlDoc, otherModuleXmlDocs, grammars);
+    }
+    catch (...)
+    {
+        queue.reset();
+        pageQueue = nullptr;
+        throw;
+    }
+    //  Destroying the queue joins the workers, so no page task is running when the queue pointer is cleared.
+    queue.reset();
+    pageQueue = nullptr;
+    for (const std::string& moduleDir : generatedModuleDirs)
+    {
+        WriteModuleDocsStamp(moduleDir);
     }
     GenerateRootIndexHtml(input, targetDir, solutionName, moduleNames, moduleLinks, moduleXmlFiles);
     if (verbose)
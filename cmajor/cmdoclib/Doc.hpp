@@ -10,6 +10,9 @@
 
 namespace cmajor { namespace cmdoclib {
 
+//  Sets the number of threads used for generating the HTML pages. If N <= 0, the number of hardware threads is used.
+void SetNumDocThreads(int numDocThreads_);
+int GetNumDocThreads();
 void BuildDocs(const std::u32string& solutionName, const std::vector<std::u32string>& moduleNames, std::vector<std::string>& grammarFilePaths);
 
 } } // namespace cmajor::cmdoclib
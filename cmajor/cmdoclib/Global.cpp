@@ -8,6 +8,7 @@
 #include <cmajor/symbols/Module.hpp>
 #include <cmajor/xpath/XPathEvaluate.hpp>
 #include <cmajor/dom/Parser.hpp>
+#include <cmajor/dom/Serializer.hpp>
 #include <cmajor/util/Path.hpp>
 #include <cmajor/util/Unicode.hpp>
 #include <boost/filesystem.hpp>
@@ -160,8 +161,8 @@ void Global::Write(const std::vector<std::u32string>& moduleNames)
             globalElement->AppendChild(std::unique_ptr<dom::Node>(derivedClassMapElement.release()));
             globalDoc.AppendChild(std::unique_ptr<dom::Node>(globalElement.release()));
             std::ofstream globalFile(globalXmlPath);
-            CodeFormatter formatter(globalFile);
-            globalDoc.Write(formatter);
+            dom::Serializer serializer(globalFile);
+            serializer.Write(&globalDoc);
         }
     }
 }
@@ -231,9 +232,9 @@ void WriteModuleXml(const std::string& targetDir, const std::vector<std::u32stri
     moduleXmlDoc->AppendChild(std::unique_ptr<dom::Node>(modulesElement.release()));
     std::string moduleXmlFilePath = Path::Combine(targetDir, "modules.xml");
     std::ofstream moduleXmlFile(moduleXmlFilePath);
-    CodeFormatter formatter(moduleXmlFile);
-    formatter.SetIndentSize(1);
-    moduleXmlDoc->Write(formatter);
+    dom::Serializer serializer(moduleXmlFile);
+    serializer.SetIndentSize(1);
+    serializer.Write(moduleXmlDoc.get());
 }
 
 void ReadGrammars(Input* input)
@@ -282,8 +283,8 @@ void WriteGrammars(Input* input, const std::vector<std::string>& grammarFilePath
 {
     std::string globalGrammarFilePath = GetFullPath(Path::Combine(input->targetDirPath, "grammars.xml"));
     std::ofstream globalGrammarFile(globalGrammarFilePath);
-    CodeFormatter formatter(globalGrammarFile);
-    formatter.SetIndentSize(1);
+    dom::Serializer serializer(globalGrammarFile);
+    serializer.SetIndentSize(1);
     dom::Document globalGrammarDoc;
     std::unique_ptr<dom::Element> grammarsElement(new dom::Element(U"grammars"));
     for (const std::string& grammarFilePath : grammarFilePaths)
@@ -293,7 +294,7 @@ void WriteGrammars(Input* input, const std::vector<std::string>& grammarFilePath
         grammarsElement->AppendChild(std::unique_ptr<dom::Node>(grammarElement.release()));
     }
     globalGrammarDoc.AppendChild(std::unique_ptr<dom::Node>(grammarsElement.release()));
-    globalGrammarDoc.Write(formatter);
+    serializer.Write(&globalGrammarDoc);
 }
 
 void GlobalInit()
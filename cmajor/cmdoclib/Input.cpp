@@ -63,6 +63,7 @@ Input ReadInputXml(const std::string& cmDocFilePath)
             {
                 dom::Element* docElement = static_cast<dom::Element*>(docNode);
                 std::string docFilePath = GetFullPath(Path::Combine(input.baseDir, ToUtf8(docElement->GetAttribute(U"filePath"))));
+                input.docFilePath = docFilePath;
                 input.docs = dom::ReadDocument(docFilePath);
             }
         }
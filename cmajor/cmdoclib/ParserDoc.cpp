@@ -9,6 +9,7 @@
 #include <cmajor/dom/Document.hpp>
 #include <cmajor/dom/Element.hpp>
 #include <cmajor/dom/Parser.hpp>
+#include <cmajor/dom/Serializer.hpp>
 #include <cmajor/symbols/GlobalFlags.hpp>
 #include <cmajor/util/System.hpp>
 #include <cmajor/util/Path.hpp>
@@ -32,8 +33,8 @@ void GeneratePPXml(cmajor::ast::Project* project)
     boost::filesystem::create_directories(projectDir);
     std::string ppXmlFilePath = GetFullPath(Path::Combine(projectDir, "pp.xml"));
     std::ofstream ppXmlFile(ppXmlFilePath);
-    CodeFormatter formatter(ppXmlFile);
-    formatter.SetIndentSize(1);
+    dom::Serializer serializer(ppXmlFile);
+    serializer.SetIndentSize(1);
     dom::Document ppDoc;
     std::unique_ptr<dom::Element> parserProjectsElement(new dom::Element(U"parserProjects"));
     for (const std::string& textFilePath : project->RelativeTextFilePaths())
@@ -49,15 +50,15 @@ void GeneratePPXml(cmajor::ast::Project* project)
         }
     }
     ppDoc.AppendChild(std::unique_ptr<dom::Node>(parserProjectsElement.release()));
-    ppDoc.Write(formatter);
+    serializer.Write(&ppDoc);
 }
 
 void GenerateGmXml(Input* input, const std::string& moduleDir)
 {
     std::string gmXmlFilePath = GetFullPath(Path::Combine(moduleDir, "gm.xml"));
     std::ofstream gmXmlFile(gmXmlFilePath);
-    CodeFormatter formatter(gmXmlFile);
-    formatter.SetIndentSize(1);
+    dom::Serializer serializer(gmXmlFile);
+    serializer.SetIndentSize(1);
     dom::Document gmDoc;
     std::unique_ptr<dom::Element> grammarsElement(new dom::Element(U"grammars"));
     for (const auto& p : input->grammarMap)
@@ -68,7 +69,7 @@ void GenerateGmXml(Input* input, const std::string& moduleDir)
         grammarsElement->AppendChild(std::unique_ptr<dom::Node>(grammarElement.release()));
     }
     gmDoc.AppendChild(std::unique_ptr<dom::Node>(grammarsElement.release()));
-    gmDoc.Write(formatter);
+    serializer.Write(&gmDoc);
 }
 
 void BuildParserDocs(Input* input, const std::string& moduleDir, const std::string& grammarXmlFilePath, const std::string& relativeModuleDir, 
@@ -6,6 +6,7 @@
 #include <cmajor/cmdoclib/SourceCodePrinter.hpp>
 #include <cmajor/cmdoclib/Input.hpp>
 #include <cmajor/dom/CharacterData.hpp>
+#include <cmajor/dom/Serializer.hpp>
 #include <cmajor/parser/SourceToken.hpp>
 #include <cmajor/symbols/SymbolTable.hpp>
 #include <cmajor/symbols/GlobalFlags.hpp>
@@ -349,11 +350,11 @@ SourceCodePrinter::SourceCodePrinter(const std::string& htmlFilePath_, const std
 void SourceCodePrinter::WriteDocument()
 {
     std::ofstream htmlFile(htmlFilePath);
-    CodeFormatter formatter(htmlFile);
-    formatter.SetIndentSize(1);
+    dom::Serializer serializer(htmlFile);
+    serializer.SetIndentSize(1);
     htmlElement->AppendChild(std::unique_ptr<dom::Node>(bodyElement.release()));
     htmlDoc->AppendChild(std::unique_ptr<dom::Node>(htmlElement.release()));
-    htmlDoc->Write(formatter);
+    serializer.Write(htmlDoc.get());
 }
 
 void SourceCodePrinter::MoveTo(const Span& span)
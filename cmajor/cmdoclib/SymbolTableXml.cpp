@@ -16,6 +16,7 @@
 #include <cmajor/ast/Expression.hpp>
 #include <cmajor/dom/Parser.hpp>
 #include <cmajor/dom/CharacterData.hpp>
+#include <cmajor/dom/Serializer.hpp>
 #include <cmajor/util/Unicode.hpp>
 #include <cmajor/util/Path.hpp>
 #include <cmajor/util/Log.hpp>
@@ -230,9 +231,9 @@ void SymbolTableXmlBuilder::WriteDocument(const std::string& symbolTableXmlFileP
     GenerateTypes();
     symbolTableXmlDocument->AppendChild(std::unique_ptr<dom::Node>(symbolTableElement.release()));
     std::ofstream symbolTableXmlFile(symbolTableXmlFilePath);
-    CodeFormatter formatter(symbolTableXmlFile);
-    formatter.SetIndentSize(1);
-    symbolTableXmlDocument->Write(formatter);
+    dom::Serializer serializer(symbolTableXmlFile);
+    serializer.SetIndentSize(1);
+    serializer.Write(symbolTableXmlDocument.get());
 }
 
 void SymbolTableXmlBuilder::AddModuleXmlDocument(dom::Document* moduleXmlDocument)
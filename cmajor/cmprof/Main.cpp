@@ -18,6 +18,7 @@
 #include <cmajor/dom/Parser.hpp>
 #include <cmajor/dom/Element.hpp>
 #include <cmajor/dom/CharacterData.hpp>
+#include <cmajor/dom/Serializer.hpp>
 #include <cmajor/xpath/XPathEvaluate.hpp>
 #include <cmajor/build/Build.hpp>
 #include <boost/filesystem.hpp>
@@ -30,6 +31,7 @@
 #include <set>
 #include <chrono>
 #include <limits>
+#include <fstream>
 
 struct InitDone
 {
@@ -82,16 +84,15 @@ inline Report operator&(Report left, Report right)
 
 struct ProfiledFunction
 {
-    ProfiledFunction() : functionId(boost::uuids::nil_generator()()), functionName(), recursionCount(0), count(0), elapsedInclusive(0), elapsedExclusive(0), start(), childCalled(false) {}
+    ProfiledFunction() : functionId(boost::uuids::nil_generator()()), functionName(), recursionCount(0), count(0), elapsedInclusive(0), elapsedExclusive(0), start(0) {}
     boost::uuids::uuid functionId;
     std::u32string functionName;
     int recursionCount;
     int count;
     int64_t elapsedInclusive;
     int64_t elapsedExclusive;
-    std::chrono::high_resolution_clock::time_point start;
-    bool childCalled;
-    void Start(std::chrono::high_resolution_clock::time_point start_)
+    int64_t start;
+    void Start(int64_t start_)
     {
         if (recursionCount == 0)
         {
@@ -99,17 +100,45 @@ struct ProfiledFunction
         }
         ++recursionCount;
     }
-    void Stop(std::chrono::high_resolution_clock::time_point stop)
+    void Stop(int64_t stop)
     {
         --recursionCount;
         if (recursionCount == 0)
         {
-            int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
-            elapsedInclusive += elapsed;
+            elapsedInclusive += stop - start;
         }
     }
 };
 
+struct CallTreeNode
+{
+    CallTreeNode(ProfiledFunction* function_) : function(function_), samples(0), selfSamples(0) {}
+    CallTreeNode* GetChild(ProfiledFunction* fun)
+    {
+        for (const std::unique_ptr<CallTreeNode>& child : children)
+        {
+            if (child->function == fun)
+            {
+                return child.get();
+            }
+        }
+        children.push_back(std::unique_ptr<CallTreeNode>(new CallTreeNode(fun)));
+        return children.back().get();
+    }
+    ProfiledFunction* function;
+    uint64_t samples;
+    uint64_t selfSamples;
+    std::vector<std::unique_ptr<CallTreeNode>> children;
+};
+
+struct CallTreeNodeBySamples
+{
+    bool operator()(const std::unique_ptr<CallTreeNode>& left, const std::unique_ptr<CallTreeNode>& right) const
+    {
+        return left->samples > right->samples;
+    }
+};
+
 struct ProfiledFunctionByName
 {
     bool operator()(ProfiledFunction* left, ProfiledFunction* right) const
@@ -256,8 +285,44 @@ struct ProfiledFunctionByCount
     }
 };
 
-std::unique_ptr<cmajor::dom::Document> GenerateReport(Module& module, std::vector<ProfiledFunction*>& profiledFunctions, Report report, int top, int64_t totalInclusive, int64_t totalExclusive)
+const uint64_t callTreeCutoffPerMille = 1;
+
+std::unique_ptr<cmajor::dom::Element> GenerateCallTreeElement(CallTreeNode* node, uint64_t totalSamples)
 {
+    std::unique_ptr<cmajor::dom::Element> ulElement(new cmajor::dom::Element(U"ul"));
+    std::sort(node->children.begin(), node->children.end(), CallTreeNodeBySamples());
+    for (const std::unique_ptr<CallTreeNode>& child : node->children)
+    {
+        if (child->samples * 1000 < totalSamples * callTreeCutoffPerMille)
+        {
+            break;
+        }
+        std::unique_ptr<cmajor::dom::Element> liElement(new cmajor::dom::Element(U"li"));
+        std::u32string text = child->function->functionName;
+        text.append(U" - ").append(ToUtf32(ToString(100.0 * child->samples / totalSamples, 1))).append(U"% inclusive, ");
+        text.append(ToUtf32(ToString(100.0 * child->selfSamples / totalSamples, 1))).append(U"% exclusive");
+        liElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(text)));
+        if (!child->children.empty())
+        {
+            std::unique_ptr<cmajor::dom::Element> childElement = GenerateCallTreeElement(child.get(), totalSamples);
+            if (childElement->FirstChild())
+            {
+                liElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(childElement.release()));
+            }
+        }
+        ulElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(liElement.release()));
+    }
+    return ulElement;
+}
+
+std::unique_ptr<cmajor::dom::Document> GenerateReport(Module& module, std::vector<ProfiledFunction*>& profiledFunctions, Report report, int top, int64_t totalInclusive, int64_t totalExclusive,
+    CallTreeNode* callTree)
+{
+    std::u32string countTitle = U"execution count";
+    if (callTree)
+    {
+        countTitle = U"sample count";
+    }
     std::unique_ptr<cmajor::dom::Document> reportDoc(new cmajor::dom::Document());
     std::unique_ptr<cmajor::dom::Element> htmlElement(new cmajor::dom::Element(U"html"));
     std::unique_ptr<cmajor::dom::Element> headElement(new cmajor::dom::Element(U"head"));
@@ -336,7 +401,7 @@ std::unique_ptr<cmajor::dom::Document> GenerateReport(Module& module, std::vecto
         thExclusivePercentElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"exclusive-%")));
         trTitlesElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(thExclusivePercentElement.release()));
         std::unique_ptr<cmajor::dom::Element> thCountElement(new cmajor::dom::Element(U"th"));
-        thCountElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"execution count")));
+        thCountElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(countTitle)));
         trTitlesElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(thCountElement.release()));
         tableElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(trTitlesElement.release()));
 
@@ -403,7 +468,7 @@ std::unique_ptr<cmajor::dom::Document> GenerateReport(Module& module, std::vecto
         thInclusivePercentElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"inclusive-%")));
         trTitlesElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(thInclusivePercentElement.release()));
         std::unique_ptr<cmajor::dom::Element> thCountElement(new cmajor::dom::Element(U"th"));
-        thCountElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"execution count")));
+        thCountElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(countTitle)));
         trTitlesElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(thCountElement.release()));
         tableElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(trTitlesElement.release()));
 
@@ -445,7 +510,14 @@ std::unique_ptr<cmajor::dom::Document> GenerateReport(Module& module, std::vecto
     if ((report & Report::count) != Report::none)
     {
         std::unique_ptr<cmajor::dom::Element> h2Element(new cmajor::dom::Element(U"h2"));
-        h2Element->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"Execution Count")));
+        if (callTree)
+        {
+            h2Element->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"Sample Count")));
+        }
+        else
+        {
+            h2Element->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"Execution Count")));
+        }
         bodyElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(h2Element.release()));
         std::unique_ptr<cmajor::dom::Element> tableElement(new cmajor::dom::Element(U"table"));
 
@@ -457,7 +529,7 @@ std::unique_ptr<cmajor::dom::Document> GenerateReport(Module& module, std::vecto
         thFunctionElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"function")));
         trTitlesElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(thFunctionElement.release()));
         std::unique_ptr<cmajor::dom::Element> thCountElement(new cmajor::dom::Element(U"th"));
-        thCountElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"execution count")));
+        thCountElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(countTitle)));
         trTitlesElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(thCountElement.release()));
         std::unique_ptr<cmajor::dom::Element> thInclusiveElement(new cmajor::dom::Element(U"th"));
         thInclusiveElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"elapsed time inclusive")));
@@ -508,6 +580,13 @@ std::unique_ptr<cmajor::dom::Document> GenerateReport(Module& module, std::vecto
         }
         bodyElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(tableElement.release()));
     }
+    if (callTree && callTree->samples != 0)
+    {
+        std::unique_ptr<cmajor::dom::Element> h2Element(new cmajor::dom::Element(U"h2"));
+        h2Element->AppendChild(std::unique_ptr<cmajor::dom::Node>(new cmajor::dom::Text(U"Call Tree")));
+        bodyElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(h2Element.release()));
+        bodyElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(GenerateCallTreeElement(callTree, callTree->samples).release()));
+    }
     headElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(titleElement.release()));
     headElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(styleElement.release()));
     htmlElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(headElement.release()));
@@ -516,95 +595,202 @@ std::unique_ptr<cmajor::dom::Document> GenerateReport(Module& module, std::vecto
     return reportDoc;
 }
 
-const uint8_t startEvent = 0;
-const uint8_t endEvent = 1;
+const uint32_t profileDataMagic = 0x434D5046;
+const uint8_t profileDataVersion = 2;
+const uint8_t functionRecord = 0;
+const uint8_t chunkRecord = 1;
+const uint8_t endRecord = 2;
+const uint32_t startEvent = 0;
+const uint32_t endEvent = 1;
 
-std::unique_ptr<cmajor::dom::Document> AnalyzeProfileData(const std::string& profileDataFileName, Module& module,
-    std::unordered_map<boost::uuids::uuid, ProfiledFunction, boost::hash<boost::uuids::uuid>>& functionProfileMap, std::vector<ProfiledFunction*>& profiledFunctions, int64_t& totalInclusive, int64_t& totalExclusive)
+// Reads the profile data file sequentially through a fixed-size buffer, so that the size of the profile data does not affect memory use.
+
+class ProfileDataReader
 {
-    std::unique_ptr<cmajor::dom::Document> analyzedProfileDataDoc(new cmajor::dom::Document());
-    std::vector<ProfiledFunction*> functionPath;
-    std::chrono::high_resolution_clock::time_point prevTimePoint;
-    std::chrono::high_resolution_clock::time_point start { std::chrono::high_resolution_clock::duration{ std::numeric_limits<int64_t>::max() } };
-    std::chrono::high_resolution_clock::time_point end { std::chrono::high_resolution_clock::duration{ std::numeric_limits<int64_t>::min() } };
-    bool prevWasEnd = false;
-    BinaryReader reader(profileDataFileName);
-    uint64_t n = reader.ReadULong();
-    for (uint64_t i = 0; i < n; ++i)
+public:
+    ProfileDataReader(const std::string& fileName_) : fileName(fileName_), file(fileName, std::ios::binary), buffer(bufferSize), pos(0), end(0)
     {
-        boost::uuids::uuid functionId;
-        reader.ReadUuid(functionId);
-        uint64_t timePointCount = reader.ReadULong();
-        uint8_t eventKind = reader.ReadByte();
-        std::chrono::high_resolution_clock::time_point timePoint{ std::chrono::high_resolution_clock::duration{ timePointCount } };
-        if (timePoint < start)
+        if (!file)
         {
-            start = timePoint;
+            throw std::runtime_error("could not open profile data file '" + fileName + "'");
         }
-        if (timePoint > end)
+    }
+    uint8_t ReadByte()
+    {
+        if (pos == end)
         {
-            end = timePoint;
+            Fill();
         }
-        if (i == 0 || prevTimePoint > timePoint)
+        return buffer[pos++];
+    }
+    uint32_t ReadUInt()
+    {
+        uint32_t result = 0;
+        for (int i = 0; i < 4; ++i)
         {
-            prevTimePoint = timePoint;
+            result = (result << 8) | ReadByte();
         }
-        ProfiledFunction& fun = functionProfileMap[functionId];
-        if (fun.functionId.is_nil())
+        return result;
+    }
+    uint32_t ReadULEB128UInt()
+    {
+        uint32_t result = 0;
+        uint32_t shift = 0;
+        while (true)
         {
-            fun.functionId = functionId;
-            fun.functionName = module.GetSymbolTable().GetProfiledFunctionName(functionId);
-            if (fun.functionName.empty())
-            {
-                //fun.functionName = ToUtf32(std::to_string(functionId));
-                fun.functionName = ToUtf32(boost::uuids::to_string(functionId));
-            }
+            uint8_t b = ReadByte();
+            result |= ((b & 0x7F) << shift);
+            if ((b & 0x80) == 0) break;
+            shift += 7;
+        }
+        return result;
+    }
+    uint64_t ReadULEB128ULong()
+    {
+        uint64_t result = 0;
+        uint64_t shift = 0;
+        while (true)
+        {
+            uint8_t b = ReadByte();
+            result |= (uint64_t(b & 0x7F) << shift);
+            if ((b & 0x80) == 0) break;
+            shift += 7;
         }
-        if (eventKind == startEvent)
+        return result;
+    }
+    void ReadUuid(boost::uuids::uuid& uuid)
+    {
+        for (boost::uuids::uuid::value_type& x : uuid)
         {
-            if (!functionPath.empty())
-            {
-                ProfiledFunction* parentFun = functionPath.back();
-                parentFun->elapsedExclusive = std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint - prevTimePoint).count();
-                parentFun->childCalled = true;
-            }
-            fun.Start(timePoint);
-            ++fun.count;
-            functionPath.push_back(&fun);
-            prevWasEnd = false;
+            x = ReadByte();
+        }
+    }
+private:
+    static const size_t bufferSize = 64 * 1024;
+    std::string fileName;
+    std::ifstream file;
+    std::vector<uint8_t> buffer;
+    size_t pos;
+    size_t end;
+    void Fill()
+    {
+        file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        end = size_t(file.gcount());
+        pos = 0;
+        if (end == 0)
+        {
+            throw std::runtime_error("unexpected end of profile data file '" + fileName + "'");
+        }
+    }
+};
+
+struct ThreadProfileState
+{
+    ThreadProfileState() : timePoint(0) {}
+    std::vector<ProfiledFunction*> functionPath;
+    int64_t timePoint;
+};
+
+ProfiledFunction* GetProfiledFunction(const boost::uuids::uuid& functionId, Module& module,
+    std::unordered_map<boost::uuids::uuid, ProfiledFunction, boost::hash<boost::uuids::uuid>>& functionProfileMap)
+{
+    ProfiledFunction& fun = functionProfileMap[functionId];
+    if (fun.functionId.is_nil())
+    {
+        fun.functionId = functionId;
+        fun.functionName = module.GetSymbolTable().GetProfiledFunctionName(functionId);
+        if (fun.functionName.empty())
+        {
+            fun.functionName = ToUtf32(boost::uuids::to_string(functionId));
+        }
+    }
+    return &fun;
+}
+
+std::unique_ptr<cmajor::dom::Document> AnalyzeProfileData(const std::string& profileDataFileName, Module& module,
+    std::unordered_map<boost::uuids::uuid, ProfiledFunction, boost::hash<boost::uuids::uuid>>& functionProfileMap, std::vector<ProfiledFunction*>& profiledFunctions, int64_t& totalInclusive, int64_t& totalExclusive)
+{
+    std::unique_ptr<cmajor::dom::Document> analyzedProfileDataDoc(new cmajor::dom::Document());
+    int64_t start = std::numeric_limits<int64_t>::max();
+    int64_t end = std::numeric_limits<int64_t>::min();
+    std::vector<ProfiledFunction*> functions;
+    std::vector<ThreadProfileState> threads;
+    ProfileDataReader reader(profileDataFileName);
+    if (reader.ReadUInt() != profileDataMagic || reader.ReadByte() != profileDataVersion)
+    {
+        throw std::runtime_error("'" + profileDataFileName + "' is not a profile data file of this version");
+    }
+    uint8_t recordKind = reader.ReadByte();
+    while (recordKind != endRecord)
+    {
+        if (recordKind == functionRecord)
+        {
+            boost::uuids::uuid functionId;
+            reader.ReadUuid(functionId);
+            functions.push_back(GetProfiledFunction(functionId, module, functionProfileMap));
         }
-        else if (eventKind == endEvent)
+        else if (recordKind == chunkRecord)
         {
-            if (!functionPath.empty() && prevWasEnd)
+            uint32_t threadIndex = reader.ReadULEB128UInt();
+            if (threadIndex >= threads.size())
             {
-                ProfiledFunction* parentFun = functionPath.back();
-                parentFun->elapsedExclusive = std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint - prevTimePoint).count();
+                threads.resize(threadIndex + 1);
             }
-            fun.Stop(timePoint);
-            functionPath.pop_back();
-            if (!fun.childCalled)
+            ThreadProfileState& thread = threads[threadIndex];
+            uint32_t eventCount = reader.ReadULEB128UInt();
+            for (uint32_t i = 0; i < eventCount; ++i)
             {
-                fun.elapsedExclusive += std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint - prevTimePoint).count();
+                uint32_t event = reader.ReadULEB128UInt();
+                uint32_t functionIndex = event >> 1;
+                uint32_t eventKind = event & 1;
+                int64_t timePoint = thread.timePoint + int64_t(reader.ReadULEB128ULong());
+                if (functionIndex >= functions.size())
+                {
+                    throw std::runtime_error("invalid function index in profile data");
+                }
+                start = std::min(start, timePoint);
+                end = std::max(end, timePoint);
+                if (!thread.functionPath.empty())
+                {
+                    thread.functionPath.back()->elapsedExclusive += timePoint - thread.timePoint;
+                }
+                ProfiledFunction* fun = functions[functionIndex];
+                if (eventKind == startEvent)
+                {
+                    fun->Start(timePoint);
+                    ++fun->count;
+                    thread.functionPath.push_back(fun);
+                }
+                else
+                {
+                    if (thread.functionPath.empty() || thread.functionPath.back() != fun)
+                    {
+                        throw std::runtime_error("'end' event does not match the 'start' event");
+                    }
+                    fun->Stop(timePoint);
+                    thread.functionPath.pop_back();
+                }
+                thread.timePoint = timePoint;
             }
-            prevWasEnd = true;
         }
         else
         {
-            throw std::runtime_error("'start' or 'end' event expected");
+            throw std::runtime_error("invalid record in profile data");
         }
-        prevTimePoint = timePoint;
+        recordKind = reader.ReadByte();
     }
     for (auto& p : functionProfileMap)
     {
         profiledFunctions.push_back(&p.second);
     }
     std::sort(profiledFunctions.begin(), profiledFunctions.end(), ProfiledFunctionByName());
-    totalInclusive = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    totalInclusive = std::max(end - start, int64_t(1));
     totalExclusive = 0;
     for (ProfiledFunction* fun : profiledFunctions)
     {
         totalExclusive += fun->elapsedExclusive;
     }
+    totalExclusive = std::max(totalExclusive, int64_t(1));
     cmajor::dom::Element* profileElement = new cmajor::dom::Element(U"profile");
     profileElement->SetAttribute(U"project", module.Name());
     profileElement->SetAttribute(U"elapsed", ToUtf32(std::to_string(totalInclusive)));
@@ -624,6 +810,140 @@ std::unique_ptr<cmajor::dom::Document> AnalyzeProfileData(const std::string& pro
     return analyzedProfileDataDoc;
 }
 
+void AddCallTreeElements(cmajor::dom::Element* parentElement, CallTreeNode* node)
+{
+    for (const std::unique_ptr<CallTreeNode>& child : node->children)
+    {
+        cmajor::dom::Element* nodeElement = new cmajor::dom::Element(U"node");
+        nodeElement->SetAttribute(U"name", child->function->functionName);
+        nodeElement->SetAttribute(U"samples", ToUtf32(std::to_string(child->samples)));
+        nodeElement->SetAttribute(U"selfSamples", ToUtf32(std::to_string(child->selfSamples)));
+        AddCallTreeElements(nodeElement, child.get());
+        parentElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(nodeElement));
+    }
+}
+
+// Reads the call stack samples written by the runtime in sampling mode. Inclusive time of a function is estimated from the samples whose stack
+// contains the function and exclusive time from the samples in which the function is on top of the stack.
+
+std::unique_ptr<cmajor::dom::Document> AnalyzeSampleData(const std::string& sampleDataFileName, Module& module,
+    std::unordered_map<boost::uuids::uuid, ProfiledFunction, boost::hash<boost::uuids::uuid>>& functionProfileMap, std::vector<ProfiledFunction*>& profiledFunctions, 
+    CallTreeNode& callTree, int64_t& totalInclusive, int64_t& totalExclusive)
+{
+    std::unique_ptr<cmajor::dom::Document> analyzedProfileDataDoc(new cmajor::dom::Document());
+    BinaryReader reader(sampleDataFileName);
+    int64_t intervalNs = int64_t(reader.ReadUInt()) * 1000;
+    uint32_t functionCount = reader.ReadUInt();
+    std::vector<ProfiledFunction*> functions;
+    for (uint32_t i = 0; i < functionCount; ++i)
+    {
+        boost::uuids::uuid functionId;
+        reader.ReadUuid(functionId);
+        functions.push_back(GetProfiledFunction(functionId, module, functionProfileMap));
+    }
+    std::vector<bool> onStack(functionCount, false);
+    uint64_t stackCount = reader.ReadULong();
+    for (uint64_t i = 0; i < stackCount; ++i)
+    {
+        uint64_t count = reader.ReadULong();
+        uint32_t depth = reader.ReadUInt();
+        std::vector<uint32_t> stack;
+        for (uint32_t j = 0; j < depth; ++j)
+        {
+            uint32_t index = reader.ReadUInt();
+            if (index >= functionCount)
+            {
+                throw std::runtime_error("invalid function index in sample data");
+            }
+            stack.push_back(index);
+        }
+        CallTreeNode* node = &callTree;
+        node->samples += count;
+        for (uint32_t index : stack)
+        {
+            ProfiledFunction* fun = functions[index];
+            if (!onStack[index])
+            {
+                onStack[index] = true;
+                fun->count += int(count);
+                fun->elapsedInclusive += int64_t(count) * intervalNs;
+            }
+            node = node->GetChild(fun);
+            node->samples += count;
+        }
+        if (!stack.empty())
+        {
+            functions[stack.back()]->elapsedExclusive += int64_t(count) * intervalNs;
+            node->selfSamples += count;
+        }
+        for (uint32_t index : stack)
+        {
+            onStack[index] = false;
+        }
+    }
+    uint64_t droppedSamples = reader.ReadULong();
+    for (auto& p : functionProfileMap)
+    {
+        profiledFunctions.push_back(&p.second);
+    }
+    std::sort(profiledFunctions.begin(), profiledFunctions.end(), ProfiledFunctionByName());
+    totalInclusive = int64_t(callTree.samples) * intervalNs;
+    totalExclusive = totalInclusive;
+    if (totalInclusive == 0)
+    {
+        totalInclusive = 1;
+        totalExclusive = 1;
+    }
+    cmajor::dom::Element* profileElement = new cmajor::dom::Element(U"profile");
+    profileElement->SetAttribute(U"project", module.Name());
+    profileElement->SetAttribute(U"mode", U"sampling");
+    profileElement->SetAttribute(U"samples", ToUtf32(std::to_string(callTree.samples)));
+    profileElement->SetAttribute(U"droppedSamples", ToUtf32(std::to_string(droppedSamples)));
+    profileElement->SetAttribute(U"interval", ToUtf32(std::to_string(intervalNs)));
+    for (ProfiledFunction* fun : profiledFunctions)
+    {
+        cmajor::dom::Element* functionElement = new cmajor::dom::Element(U"function");
+        functionElement->SetAttribute(U"id", ToUtf32(boost::uuids::to_string(fun->functionId)));
+        functionElement->SetAttribute(U"name", fun->functionName);
+        functionElement->SetAttribute(U"samples", ToUtf32(std::to_string(fun->count)));
+        functionElement->SetAttribute(U"elapsedInclusive", ToUtf32(std::to_string(fun->elapsedInclusive)));
+        functionElement->SetAttribute(U"elapsedInclusivePercent", ToUtf32(ToString(100.0 * fun->elapsedInclusive / totalInclusive, 1)));
+        functionElement->SetAttribute(U"elapsedExclusive", ToUtf32(std::to_string(fun->elapsedExclusive)));
+        functionElement->SetAttribute(U"elapsedExclusivePercent", ToUtf32(ToString(100.0 * fun->elapsedExclusive / totalExclusive, 1)));
+        profileElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(functionElement));
+    }
+    cmajor::dom::Element* callTreeElement = new cmajor::dom::Element(U"callTree");
+    AddCallTreeElements(callTreeElement, &callTree);
+    profileElement->AppendChild(std::unique_ptr<cmajor::dom::Node>(callTreeElement));
+    analyzedProfileDataDoc->AppendChild(std::unique_ptr<cmajor::dom::Node>(profileElement));
+    if (droppedSamples != 0)
+    {
+        std::cout << "warning: " << droppedSamples << " samples did not fit in the sample buffers and were dropped" << std::endl;
+    }
+    return analyzedProfileDataDoc;
+}
+
+void SetProfilingEnvironment(int samplingIntervalUs)
+{
+    std::string value;
+    if (samplingIntervalUs > 0)
+    {
+        value = std::to_string(samplingIntervalUs);
+    }
+#ifdef _WIN32
+    _putenv_s("CMAJOR_PROFILE_SAMPLING_INTERVAL", value.c_str());
+#else
+    if (value.empty())
+    {
+        unsetenv("CMAJOR_PROFILE_SAMPLING_INTERVAL");
+    }
+    else
+    {
+        setenv("CMAJOR_PROFILE_SAMPLING_INTERVAL", value.c_str(), 1);
+    }
+#endif
+}
+
 cmajor::parser::Project* projectGrammar = nullptr;
 
 void ReadProject(const std::string& projectFilePath, cmajor::ast::Solution& solution, bool requireProgram, std::set<std::u32string>& readProjects)
@@ -664,7 +984,8 @@ void ReadProject(const std::string& projectFilePath, cmajor::ast::Solution& solu
     }
 }
 
-void ProfileProject(const std::string& projectFilePath, bool rebuildSys, bool rebuildApp, int top, Report report, std::string& outFile, const std::string& args, std::unique_ptr<Module>& rootModule)
+void ProfileProject(const std::string& projectFilePath, bool rebuildSys, bool rebuildApp, int top, Report report, std::string& outFile, const std::string& args, int samplingIntervalUs,
+    std::unique_ptr<Module>& rootModule)
 {
     if (GetGlobalFlag(GlobalFlags::verbose))
     {
@@ -737,6 +1058,7 @@ void ProfileProject(const std::string& projectFilePath, bool rebuildSys, bool re
     {
         commandLine.append(1, ' ').append(args);
     }
+    SetProfilingEnvironment(samplingIntervalUs);
     int exitCode = system(commandLine.c_str());
     if (exitCode != 0)
     {
@@ -746,7 +1068,6 @@ void ProfileProject(const std::string& projectFilePath, bool rebuildSys, bool re
     {
         std::cout << "Finished profiling." << std::endl;
     }
-    std::string profileDataFileName = Path::Combine(Path::GetDirectoryName(mainProject->ExecutableFilePath()), "cmprof.bin");
     if (GetGlobalFlag(GlobalFlags::verbose))
     {
         std::cout << "Analyzing profile data..." << std::endl;
@@ -755,7 +1076,19 @@ void ProfileProject(const std::string& projectFilePath, bool rebuildSys, bool re
     std::vector<ProfiledFunction*> profiledFunctions;
     int64_t totalInclusive = 0;
     int64_t totalExclusive = 0;
-    std::unique_ptr<cmajor::dom::Document> analyzedProfileDataDoc = AnalyzeProfileData(profileDataFileName, *rootModule, functionProfileMap, profiledFunctions, totalInclusive, totalExclusive);
+    std::unique_ptr<CallTreeNode> callTree;
+    std::unique_ptr<cmajor::dom::Document> analyzedProfileDataDoc;
+    if (samplingIntervalUs > 0)
+    {
+        callTree.reset(new CallTreeNode(nullptr));
+        std::string sampleDataFileName = Path::Combine(Path::GetDirectoryName(mainProject->ExecutableFilePath()), "cmprof.samples.bin");
+        analyzedProfileDataDoc = AnalyzeSampleData(sampleDataFileName, *rootModule, functionProfileMap, profiledFunctions, *callTree, totalInclusive, totalExclusive);
+    }
+    else
+    {
+        std::string profileDataFileName = Path::Combine(Path::GetDirectoryName(mainProject->ExecutableFilePath()), "cmprof.bin");
+        analyzedProfileDataDoc = AnalyzeProfileData(profileDataFileName, *rootModule, functionProfileMap, profiledFunctions, totalInclusive, totalExclusive);
+    }
     if (GetGlobalFlag(GlobalFlags::verbose))
     {
         std::cout << "Finished analyzing profile data." << std::endl;
@@ -768,9 +1101,9 @@ void ProfileProject(const std::string& projectFilePath, bool rebuildSys, bool re
     boost::filesystem::path xmlFilePath = boost::filesystem::path(outFile).replace_extension(".xml");
     std::string cmProfFileName = GetFullPath(xmlFilePath.generic_string());
     std::ofstream cmProfXmlFile(cmProfFileName);
-    cmajor::util::CodeFormatter xmlFormatter(cmProfXmlFile);
-    xmlFormatter.SetIndentSize(2);
-    analyzedProfileDataDoc->Write(xmlFormatter);
+    cmajor::dom::Serializer xmlSerializer(cmProfXmlFile);
+    xmlSerializer.SetIndentSize(2);
+    xmlSerializer.Write(analyzedProfileDataDoc.get());
     if (GetGlobalFlag(GlobalFlags::verbose))
     {
         std::cout << "=> " << cmProfFileName << std::endl;
@@ -780,12 +1113,12 @@ void ProfileProject(const std::string& projectFilePath, bool rebuildSys, bool re
         std::cout << "Generating report..." << std::endl;
     }
     boost::filesystem::path htmlFilePath = boost::filesystem::path(outFile).replace_extension(".html");
-    std::unique_ptr<cmajor::dom::Document> reportHtmlDoc = GenerateReport(*rootModule, profiledFunctions, report, top, totalInclusive, totalExclusive);
+    std::unique_ptr<cmajor::dom::Document> reportHtmlDoc = GenerateReport(*rootModule, profiledFunctions, report, top, totalInclusive, totalExclusive, callTree.get());
     std::string reportHtmlFileName = GetFullPath(htmlFilePath.generic_string());
     std::ofstream reportHtmlFile(reportHtmlFileName);
-    cmajor::util::CodeFormatter htmlFormatter(reportHtmlFile);
-    htmlFormatter.SetIndentSize(2);
-    reportHtmlDoc->Write(htmlFormatter);
+    cmajor::dom::Serializer htmlSerializer(reportHtmlFile);
+    htmlSerializer.SetIndentSize(2);
+    htmlSerializer.Write(reportHtmlDoc.get());
     if (GetGlobalFlag(GlobalFlags::verbose))
     {
         std::cout << "=> " << reportHtmlFileName << std::endl;
@@ -798,6 +1131,8 @@ void ProfileProject(const std::string& projectFilePath, bool rebuildSys, bool re
 
 const char* version = "3.3.0";
 
+const int defaultSamplingIntervalUs = 1000;
+
 void PrintHelp()
 {
     std::cout << "Cmajor Profiler version " << version << std::endl;
@@ -817,13 +1152,17 @@ void PrintHelp()
         "--exclusive (-x)\n"
         "   report elapsed exclusive time\n" <<
         "--count (-c)\n" <<
-        "   report execution count\n" <<
+        "   report execution count (sample count when sampling)\n" <<
         "--all (-a)\n" <<
         "   report all\n" <<
         "--top=N (-t=N)\n" <<
         "   report top N functions (default=all)\n" <<
         "--out=FILE (-o=FILE)\n" <<
         "   report to file FILE\n" <<
+        "--sample (-s)\n" <<
+        "   sample call stacks with a timer instead of timing every function call\n" <<
+        "--sample=MICROSECONDS (-s=MICROSECONDS)\n" <<
+        "   sample call stacks using given sampling interval (default=1000)\n" <<
         "--args=\"ARGUMENTS\"\n" <<
         "   set program arguments\n" <<
         "--emit-llvm (-l)\n" <<
@@ -849,6 +1188,7 @@ int main(int argc, const char** argv)
         Report report = Report::none;
         std::string outFile;
         std::string args;
+        int samplingIntervalUs = 0;
         for (int i = 1; i < argc; ++i)
         {
             std::string arg = argv[i];
@@ -887,6 +1227,10 @@ int main(int argc, const char** argv)
                 {
                     report = report | Report::all;
                 }
+                else if (arg == "--sample" || arg == "-s")
+                {
+                    samplingIntervalUs = defaultSamplingIntervalUs;
+                }
                 else if (arg == "--emit-llvm" || arg == "-l")
                 {
                     SetGlobalFlag(GlobalFlags::emitLlvm);
@@ -920,6 +1264,14 @@ int main(int argc, const char** argv)
                         {
                             outFile = components[1];
                         }
+                        else if (components[0] == "--sample" || components[0] == "-s")
+                        {
+                            samplingIntervalUs = boost::lexical_cast<int>(components[1]);
+                            if (samplingIntervalUs <= 0)
+                            {
+                                throw std::runtime_error("sampling interval must be positive");
+                            }
+                        }
                         else if (components[0] == "--args")
                         {
                             args = components[1];
@@ -968,7 +1320,7 @@ int main(int argc, const char** argv)
                 }
                 else
                 {
-                    ProfileProject(GetFullPath(project), rebuildSys, rebuildApp, top, report, outFile, args, rootModule);
+                    ProfileProject(GetFullPath(project), rebuildSys, rebuildApp, top, report, outFile, args, samplingIntervalUs, rootModule);
                 }
             }
             else
@@ -28,6 +28,7 @@
 #include <cmajor/dom/Element.hpp>
 #include <cmajor/dom/CharacterData.hpp>
 #include <cmajor/dom/Parser.hpp>
+#include <cmajor/dom/Serializer.hpp>
 #include <cmajor/xpath/InitDone.hpp>
 #include <cmajor/xpath/XPathEvaluate.hpp>
 #include <cmajor/util/Util.hpp>
@@ -210,7 +211,7 @@ void CreateMainUnit(std::vector<std::string>& objectFilePaths, Module& module, E
         AnalyzeControlFlow(boundMainCompileUnit);
     }
     GenerateCode(emittingContext, boundMainCompileUnit);
-    objectFilePaths.push_back(boundMainCompileUnit.ObjectFilePath());
+    objectFilePaths.insert(objectFilePaths.end(), boundMainCompileUnit.ObjectFilePaths().begin(), boundMainCompileUnit.ObjectFilePaths().end());
 }
 
 struct UnitTest
@@ -263,7 +264,7 @@ void TestUnit(FileTable* fileTable, cmajor::ast::Project* project, CompileUnitNo
                 AnalyzeControlFlow(*boundCompileUnit);
             }
             GenerateCode(emittingContext, *boundCompileUnit);
-            objectFilePaths.push_back(boundCompileUnit->ObjectFilePath());
+            objectFilePaths.insert(objectFilePaths.end(), boundCompileUnit->ObjectFilePaths().begin(), boundCompileUnit->ObjectFilePaths().end());
         }
         int32_t numUnitTestAssertions = GetNumUnitTestAssertions();
         CreateMainUnit(objectFilePaths, *rootModule, emittingContext, &attributeBinder, testName, numUnitTestAssertions, unitTestFilePath);
@@ -1077,9 +1078,9 @@ int main(int argc, const char** argv)
         }
         std::string cmunitFileName = GetFullPath(boost::filesystem::path(outFile).replace_extension(".xml").generic_string());
         std::ofstream cmunitXmlFile(cmunitFileName);
-        cmajor::util::CodeFormatter formatter(cmunitXmlFile);
-        formatter.SetIndentSize(2);
-        testDoc.Write(formatter);
+        cmajor::dom::Serializer serializer(cmunitXmlFile);
+        serializer.SetIndentSize(2);
+        serializer.Write(&testDoc);
         if (GetGlobalFlag(GlobalFlags::verbose))
         {
             std::cout << "==> " << cmunitFileName << std::endl;
@@ -1087,9 +1088,9 @@ int main(int argc, const char** argv)
         std::unique_ptr<cmajor::dom::Document> reportDoc = GenerateHtmlReport(&testDoc);
         std::string cmunitReportFileName = Path::ChangeExtension(cmunitFileName, ".html");
         std::ofstream cmunitHtmlFile(cmunitReportFileName);
-        cmajor::util::CodeFormatter htmlFormatter(cmunitHtmlFile);
-        htmlFormatter.SetIndentSize(2);
-        reportDoc->Write(htmlFormatter);
+        cmajor::dom::Serializer htmlSerializer(cmunitHtmlFile);
+        htmlSerializer.SetIndentSize(2);
+        htmlSerializer.Write(reportDoc.get());
         if (GetGlobalFlag(GlobalFlags::verbose))
         {
             std::cout << "==> " << cmunitReportFileName << std::endl;
@@ -109,6 +109,13 @@ void PrintHelp()
         "   compile source files in a project using a single thread\n" <<
         "--debug-compile (-dc)\n" <<
         "   show debug messages from multithreaded compilation\n" <<
+        "--devirtualize (-dv)\n" <<
+        "   devirtualize calls using class hierarchy analysis of the whole program when building a program\n" <<
+        "   (binds all source files before generating code, which raises the peak memory use of the compiler)\n" <<
+        "--pipelined-compile (-pc)\n" <<
+        "   release function bodies of a source file as soon as code has been generated for it\n" <<
+        "--thin-archive (-ta)\n" <<
+        "   create libraries as thin archives that refer to the object files instead of containing them (not for system libraries)\n" <<
         std::endl;
 }
 
@@ -286,6 +293,18 @@ int main(int argc, const char** argv)
                     {
                         SetGlobalFlag(GlobalFlags::debugCompile);
                     }
+                    else if (arg == "--devirtualize" || arg == "-dv")
+                    {
+                        SetGlobalFlag(GlobalFlags::devirtualize);
+                    }
+                    else if (arg == "--pipelined-compile" || arg == "-pc")
+                    {
+                        SetGlobalFlag(GlobalFlags::pipelinedCompile);
+                    }
+                    else if (arg == "--thin-archive" || arg == "-ta")
+                    {
+                        SetGlobalFlag(GlobalFlags::thinArchive);
+                    }
                     else if (arg.find('=') != std::string::npos)
                     {
                         std::vector<std::string> components = Split(arg, '=');
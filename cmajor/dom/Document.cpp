@@ -13,7 +13,7 @@ namespace cmajor { namespace dom {
 
 using namespace cmajor::unicode;
 
-Document::Document() : ParentNode(NodeType::documentNode, U"document"), documentElement(nullptr), docType(nullptr), indexValid(false), xmlStandalone(false)
+Document::Document() : ParentNode(NodeType::documentNode, U"document"), documentElement(nullptr), docType(nullptr), indexValid(false), structureVersion(0), numbering(0), numberedVersion(0), xmlStandalone(false)
 {
 }
 
@@ -105,7 +105,77 @@ Node* Document::AppendChild(std::unique_ptr<Node>&& newChild)
 
 void Document::InternalInvalidateIndex()
 {
-    indexValid = false;
+    indexValid.store(false, std::memory_order_relaxed);
+}
+
+void Document::InternalIncrementStructureVersion()
+{
+    structureVersion.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::atomic<bool> nodesNumbered(false);
+std::atomic<int64_t> nextNumbering(1);
+
+//  Nodes do not generally know their owner document, so the document whose numbering a structural change makes stale is found by walking up to the root.
+//  Changes in other documents and in trees that are not attached to a document leave the numbering intact.
+//  The root is not looked up until some document has been numbered.
+
+void InternalStructureChanged(Node* node)
+{
+    if (nodesNumbered.load(std::memory_order_relaxed))
+    {
+        Node* root = node;
+        while (root->Parent())
+        {
+            root = root->Parent();
+        }
+        if (root->GetNodeType() == NodeType::documentNode)
+        {
+            static_cast<Document*>(root)->InternalIncrementStructureVersion();
+        }
+    }
+}
+
+class NumberNodesOp : public NodeOp
+{
+public:
+    NumberNodesOp(int64_t numbering_) : ordinal(numbering_ << 32) {}
+    void Apply(Node* node) override
+    {
+        node->InternalSetOrdinal(ordinal++);
+        node->WalkAttribute(*this);
+    }
+private:
+    int64_t ordinal;
+};
+
+//  Numbers the nodes of the document in document order if the structure has changed since the last numbering, and gets the ordinals of the given nodes.
+//  An element precedes its attributes and the attributes precede its children.
+//  The high 32 bits of an ordinal identify the numbering, so ordinals of nodes that have been detached from the document or belong to another document are recognized as stale.
+//  The ordinals are read under the same lock that the numbering is done under, so a concurrent sort never sees a numbering in progress.
+//  Returns false if some node is not numbered by this document.
+
+bool Document::InternalGetOrdinals(std::vector<std::pair<int64_t, Node*>>& ordinals)
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+    nodesNumbered.store(true, std::memory_order_relaxed);
+    int64_t version = structureVersion.load(std::memory_order_relaxed);
+    if (numbering == 0 || numberedVersion != version)
+    {
+        numbering = nextNumbering.fetch_add(1);
+        NumberNodesOp numberNodesOp(numbering);
+        WalkDescendantOrSelf(numberNodesOp);
+        numberedVersion = version;
+    }
+    for (std::pair<int64_t, Node*>& ordinal : ordinals)
+    {
+        ordinal.first = ordinal.second->Ordinal();
+        if ((ordinal.first >> 32) != numbering)
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 void Document::Accept(Visitor& visitor)
@@ -137,14 +207,20 @@ void BuildIndexVisitor::BeginVisit(Element* element)
     }
 }
 
+//  The index is built on first use. Concurrent readers of an unmodified document may call GetElementById from several threads.
+
 Element* Document::GetElementById(const std::u32string& elementId)
 {
-    if (!indexValid)
+    if (!indexValid.load(std::memory_order_acquire))
     {
-        elementsByIdMap.clear();
-        BuildIndexVisitor visitor(elementsByIdMap);
-        Accept(visitor);
-        indexValid = true;
+        std::lock_guard<std::mutex> lock(indexMutex);
+        if (!indexValid.load(std::memory_order_relaxed))
+        {
+            elementsByIdMap.clear();
+            BuildIndexVisitor visitor(elementsByIdMap);
+            Accept(visitor);
+            indexValid.store(true, std::memory_order_release);
+        }
     }
     auto it = elementsByIdMap.find(elementId);
     if (it != elementsByIdMap.cend())
@@ -7,6 +7,9 @@
 #define CMAJOR_DOM_DOCUMENT_INCLUDED
 #include <cmajor/dom/Node.hpp>
 #include <unordered_map>
+#include <vector>
+#include <atomic>
+#include <mutex>
 
 namespace cmajor { namespace dom {
 
@@ -37,17 +40,25 @@ public:
     const std::u32string& XmlEncoding() const { return xmlEncoding; }
     void Accept(Visitor& visitor) override;
     void InternalInvalidateIndex();
+    void InternalIncrementStructureVersion();
+    bool InternalGetOrdinals(std::vector<std::pair<int64_t, Node*>>& ordinals);
 private:
     Element* documentElement;
     DocumentType* docType;
     void CheckValidInsert(Node* node, Node* refNode);
     std::unordered_map<std::u32string, Element*> elementsByIdMap;
-    bool indexValid;
+    std::atomic<bool> indexValid;
+    std::mutex indexMutex;
+    std::atomic<int64_t> structureVersion;
+    int64_t numbering;
+    int64_t numberedVersion;
     bool xmlStandalone;
     std::u32string xmlVersion;
     std::u32string xmlEncoding;
 };
 
+void InternalStructureChanged(Node* node);
+
 } } // namespace cmajor::dom
 
 #endif // CMAJOR_DOM_DOCUMENT_INCLUDED
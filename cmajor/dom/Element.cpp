@@ -4,7 +4,9 @@
 // =================================
 
 #include <cmajor/dom/Element.hpp>
+#include <cmajor/dom/Document.hpp>
 #include <cmajor/util/Unicode.hpp>
+#include <algorithm>
 
 namespace cmajor { namespace dom {
 
@@ -74,23 +76,65 @@ Element::Element(const std::u32string& name_) : ParentNode(NodeType::elementNode
 {
 }
 
-Element::Element(const std::u32string& name_, std::map<std::u32string, std::unique_ptr<Attr>>&& attributeMap_) : ParentNode(NodeType::elementNode, name_), attributeMap(std::move(attributeMap_))
+Element::Element(const std::u32string& name_, std::map<std::u32string, std::unique_ptr<Attr>>&& attributeMap_) : ParentNode(NodeType::elementNode, name_)
 {
+    attributes.reserve(attributeMap_.size());
+    for (auto& p : attributeMap_)
+    {
+        attributes.push_back(std::move(p.second));
+    }
+}
+
+struct AttrNameLess
+{
+    bool operator()(const std::unique_ptr<Attr>& left, const std::unique_ptr<Attr>& right) const
+    {
+        return left->Name() < right->Name();
+    }
+    bool operator()(const std::unique_ptr<Attr>& left, const std::u32string& right) const
+    {
+        return left->Name() < right;
+    }
+};
+
+struct AttrNameEqual
+{
+    bool operator()(const std::unique_ptr<Attr>& left, const std::unique_ptr<Attr>& right) const
+    {
+        return &left->Name() == &right->Name();
+    }
+};
+
+Element::Element(const std::u32string& name_, std::vector<std::unique_ptr<Attr>>&& attributes_) : ParentNode(NodeType::elementNode, name_), attributes(std::move(attributes_))
+{
+    std::stable_sort(attributes.begin(), attributes.end(), AttrNameLess());
+    attributes.erase(std::unique(attributes.begin(), attributes.end(), AttrNameEqual()), attributes.end());
+}
+
+std::vector<std::unique_ptr<Attr>>::iterator Element::LowerBound(const std::u32string& attrName)
+{
+    return std::lower_bound(attributes.begin(), attributes.end(), attrName, AttrNameLess());
+}
+
+std::vector<std::unique_ptr<Attr>>::const_iterator Element::LowerBound(const std::u32string& attrName) const
+{
+    return std::lower_bound(attributes.begin(), attributes.end(), attrName, AttrNameLess());
 }
 
 std::unique_ptr<Node> Element::CloneNode(bool deep) 
 {
     std::unique_ptr<Node> clone(new Element(Name()));
     ParentNode* cloneAsParent = static_cast<ParentNode*>(clone.get());
-    std::map<std::u32string, std::unique_ptr<Attr>> clonedAttributeMap;
-    for (const auto& p : attributeMap)
+    std::vector<std::unique_ptr<Attr>> clonedAttributes;
+    clonedAttributes.reserve(attributes.size());
+    for (const std::unique_ptr<Attr>& attr : attributes)
     {
-        std::unique_ptr<Node> clonedAttrNode = p.second->CloneNode(false);
+        std::unique_ptr<Node> clonedAttrNode = attr->CloneNode(false);
         clonedAttrNode->InternalSetParent(cloneAsParent);
-        clonedAttributeMap[p.first] = std::unique_ptr<Attr>(static_cast<Attr*>(clonedAttrNode.release()));
+        clonedAttributes.push_back(std::unique_ptr<Attr>(static_cast<Attr*>(clonedAttrNode.release())));
     }
     Element* cloneAsElement = static_cast<Element*>(clone.get());
-    cloneAsElement->attributeMap = std::move(clonedAttributeMap);
+    cloneAsElement->attributes = std::move(clonedAttributes);
     if (deep)
     {
         CloneChildrenTo(cloneAsParent);
@@ -100,14 +144,14 @@ std::unique_ptr<Node> Element::CloneNode(bool deep)
 
 bool Element::HasAttributes() const
 {
-    return !attributeMap.empty();
+    return !attributes.empty();
 }
 
 void Element::Write(CodeFormatter& formatter)
 {
     if (HasChildNodes())
     {
-        if (attributeMap.empty())
+        if (attributes.empty())
         {
             formatter.Write("<" + ToUtf8(Name()) + ">");
         }
@@ -146,7 +190,7 @@ void Element::Write(CodeFormatter& formatter)
     }
     else
     {
-        if (attributeMap.empty())
+        if (attributes.empty())
         {
             formatter.WriteLine("<" + ToUtf8(Name()) + "/>");
         }
@@ -161,9 +205,8 @@ void Element::Write(CodeFormatter& formatter)
 
 void Element::WriteAttributes(CodeFormatter& formatter)
 {
-    for (auto& p : attributeMap)
+    for (std::unique_ptr<Attr>& attr : attributes)
     {
-        std::unique_ptr<Attr>& attr = p.second;
         attr->Write(formatter);
     }
 }
@@ -182,35 +225,48 @@ bool Element::HasMultilineContent()
 
 std::u32string Element::GetAttribute(const std::u32string& attrName) const
 {
-    auto it = attributeMap.find(attrName);
-    if (it != attributeMap.cend())
+    auto it = LowerBound(attrName);
+    if (it != attributes.cend() && (*it)->Name() == attrName)
     {
-        return it->second->Value();
+        return (*it)->Value();
     }
     return std::u32string();
 }
 
 void Element::AddAttribute(std::unique_ptr<Attr>&& attr)
 {
-    attributeMap[attr->Name()] = std::move(attr);
+    InternalStructureChanged(this);
+    auto it = LowerBound(attr->Name());
+    if (it != attributes.end() && (*it)->Name() == attr->Name())
+    {
+        *it = std::move(attr);
+    }
+    else
+    {
+        attributes.insert(it, std::move(attr));
+    }
 }
 
 void Element::SetAttribute(const std::u32string& attrName, const std::u32string& attrValue)
 {
-    attributeMap[attrName] = std::unique_ptr<Attr>(new Attr(attrName, attrValue));
+    AddAttribute(std::unique_ptr<Attr>(new Attr(attrName, attrValue)));
 }
 
 void Element::RemoveAttribute(const std::u32string& attrName)
 {
-    attributeMap.erase(attrName);
+    InternalStructureChanged(this);
+    auto it = LowerBound(attrName);
+    if (it != attributes.end() && (*it)->Name() == attrName)
+    {
+        attributes.erase(it);
+    }
 }
 
 void Element::WalkAttribute(NodeOp& nodeOp)
 {
-    for (const auto& p : attributeMap)
+    for (const std::unique_ptr<Attr>& attr : attributes)
     {
-        Attr* attr = p.second.get();
-        nodeOp.Apply(attr);
+        nodeOp.Apply(attr.get());
     }
 }
 
@@ -32,6 +32,7 @@ class Element : public ParentNode
 public:
     Element(const std::u32string& name_);
     Element(const std::u32string& name_, std::map<std::u32string, std::unique_ptr<Attr>>&& attributeMap_);
+    Element(const std::u32string& name_, std::vector<std::unique_ptr<Attr>>&& attributes_);
     Element(const Element&) = delete;
     Element& operator=(const Element&) = delete;
     Element(Element&&) = delete;
@@ -48,7 +49,9 @@ public:
     NodeList GetElementsByTagName(const std::u32string& tagName);
     void Accept(Visitor& visitor) override;
 private:
-    std::map<std::u32string, std::unique_ptr<Attr>> attributeMap;
+    std::vector<std::unique_ptr<Attr>> attributes; // sorted by name
+    std::vector<std::unique_ptr<Attr>>::iterator LowerBound(const std::u32string& attrName);
+    std::vector<std::unique_ptr<Attr>>::const_iterator LowerBound(const std::u32string& attrName) const;
     void WriteAttributes(CodeFormatter& formatter);
     bool HasMultilineContent();
 };
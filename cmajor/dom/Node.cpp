@@ -4,6 +4,8 @@
 // =================================
 
 #include <cmajor/dom/Node.hpp>
+#include <cmajor/dom/NodeStorage.hpp>
+#include <cmajor/util/NodeMemory.hpp>
 #include <cmajor/dom/Document.hpp>
 #include <cmajor/dom/DocumentFragment.hpp>
 #include <cmajor/dom/Exception.hpp>
@@ -40,8 +42,25 @@ std::u32string AxisName(Axis axis)
     return std::u32string();
 }
 
-Node::Node(NodeType nodeType_, const std::u32string& name_) : nodeType(nodeType_), name(name_), parent(nullptr), previousSibling(nullptr), nextSibling(nullptr), ownerDocument(nullptr)
+const std::u32string* EmptyName()
 {
+    static const std::u32string* emptyName = InternName(std::u32string());
+    return emptyName;
+}
+
+Node::Node(NodeType nodeType_, const std::u32string& name_) : 
+    nodeType(nodeType_), name(InternName(name_)), namespaceUri(EmptyName()), parent(nullptr), previousSibling(nullptr), nextSibling(nullptr), ownerDocument(nullptr), ordinal(0)
+{
+}
+
+void* Node::operator new(size_t size)
+{
+    return AllocateNodeMemory(size);
+}
+
+void Node::operator delete(void* memory, size_t size)
+{
+    FreeNodeMemory(memory, size);
 }
 
 Node::~Node()
@@ -52,10 +71,10 @@ std::u32string Node::Prefix() const
 {
     if (nodeType == NodeType::elementNode || nodeType == NodeType::attributeNode)
     {
-        auto colonPos = name.find(':');
+        auto colonPos = name->find(':');
         if (colonPos != std::u32string::npos)
         {
-            return name.substr(0, colonPos);
+            return name->substr(0, colonPos);
         }
     }
     return std::u32string();
@@ -65,23 +84,23 @@ void Node::SetPrefix(const std::u32string& prefix)
 {
     if (nodeType == NodeType::elementNode || nodeType == NodeType::attributeNode)
     {
-        auto colonPos = name.find(':');
+        auto colonPos = name->find(':');
         if (prefix.empty())
         {
             if (colonPos != std::u32string::npos)
             {
-                name = name.substr(colonPos + 1);
+                name = InternName(name->substr(colonPos + 1));
             }
         }
         else
         {
             if (colonPos != std::u32string::npos)
             {
-                name = prefix + U":" + name.substr(colonPos + 1);
+                name = InternName(prefix + U":" + name->substr(colonPos + 1));
             }
             else
             {
-                name = prefix + U":" + name;
+                name = InternName(prefix + U":" + *name);
             }
         }
     }
@@ -95,14 +114,14 @@ std::u32string Node::LocalName() const
 {
     if (nodeType == NodeType::elementNode || nodeType == NodeType::attributeNode)
     {
-        auto colonPos = name.find(':');
+        auto colonPos = name->find(':');
         if (colonPos != std::u32string::npos)
         {
-            return name.substr(colonPos + 1);
+            return name->substr(colonPos + 1);
         }
         else
         {
-            return name;
+            return *name;
         }
     }
     else
@@ -154,15 +173,29 @@ void Node::WalkParent(NodeOp& nodeOp)
 void Node::WalkFollowing(NodeOp& nodeOp)
 {
     Node* ns = nextSibling;
-    if (ns)
+    while (ns)
     {
         ns->WalkDescendantOrSelf(nodeOp);
         ns = ns->nextSibling;
     }
+    if (parent)
+    {
+        parent->WalkFollowing(nodeOp);
+    }
 }
 
 void Node::WalkPreceding(NodeOp& nodeOp)
 {
+    Node* ps = previousSibling;
+    while (ps)
+    {
+        ps->WalkPrecedingOrSelf(nodeOp);
+        ps = ps->previousSibling;
+    }
+    if (parent)
+    {
+        parent->WalkPreceding(nodeOp);
+    }
 }
 
 void Node::WalkPrecedingOrSelf(NodeOp& nodeOp)
@@ -190,7 +223,7 @@ void Node::WalkAncestorOrSelf(NodeOp& nodeOp)
 void Node::WalkFollowingSibling(NodeOp& nodeOp)
 {
     Node* ns = nextSibling;
-    if (ns)
+    while (ns)
     {
         nodeOp.Apply(ns);
         ns = ns->nextSibling;
@@ -200,7 +233,7 @@ void Node::WalkFollowingSibling(NodeOp& nodeOp)
 void Node::WalkPrecedingSibling(NodeOp& nodeOp)
 {
     Node* ps = previousSibling;
-    if (ps)
+    while (ps)
     {
         nodeOp.Apply(ps);
         ps = ps->previousSibling;
@@ -239,7 +272,7 @@ void Node::InternalUnlink()
 
 void Node::InternalSetNamespaceUri(const std::u32string& namespaceUri_)
 {
-    namespaceUri = namespaceUri_;
+    namespaceUri = InternName(namespaceUri_);
 }
 
 ParentNode::ParentNode(NodeType nodeType_, const std::u32string& name_) : Node(nodeType_, name_), firstChild(nullptr), lastChild(nullptr)
@@ -291,6 +324,7 @@ void ParentNode::CloneChildrenTo(ParentNode* clone) const
 
 Node* ParentNode::InsertBefore(std::unique_ptr<Node>&& newChild, Node* refChild)
 {
+    InternalStructureChanged(this);
     if (refChild == nullptr)
     {
         return AppendChild(std::move(newChild));
@@ -335,6 +369,7 @@ Node* ParentNode::InsertBefore(std::unique_ptr<Node>&& newChild, Node* refChild)
 
 std::unique_ptr<Node> ParentNode::RemoveChild(Node* oldChild)
 {
+    InternalStructureChanged(this);
     if (!oldChild)
     {
         throw DomException("could not remove node: given old child is null");
@@ -386,6 +421,7 @@ std::unique_ptr<Node> ParentNode::ReplaceChild(std::unique_ptr<Node>&& newChild,
 
 Node* ParentNode::AppendChild(std::unique_ptr<Node>&& newChild)
 {
+    InternalStructureChanged(this);
     if (OwnerDocument())
     {
         OwnerDocument()->InternalInvalidateIndex();
@@ -467,29 +503,75 @@ void ParentNode::WalkDescendantOrSelf(NodeOp& nodeOp)
 
 void ParentNode::WalkPrecedingOrSelf(NodeOp& nodeOp)
 {
-    Node::WalkPrecedingOrSelf(nodeOp);
     Node* child = lastChild;
     while (child != nullptr)
     {
         child->WalkPrecedingOrSelf(nodeOp);
         child = child->PreviousSibling();
     }
+    Node::WalkPrecedingOrSelf(nodeOp);
 }
 
-void ParentNode::WalkPreceding(NodeOp& nodeOp)
+void NodeList::InternalAddNode(Node* node)
 {
-    Node* preceding = PreviousSibling();
-    if (preceding)
+    if (nodes.size() < hashThreshold)
+    {
+        if (std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+        {
+            nodes.push_back(node);
+            if (nodes.size() == hashThreshold)
+            {
+                nodeSet.insert(nodes.begin(), nodes.end());
+            }
+        }
+    }
+    else if (nodeSet.insert(node).second)
     {
-        preceding->WalkPrecedingOrSelf(nodeOp);
+        nodes.push_back(node);
     }
 }
 
-void NodeList::InternalAddNode(Node* node)
+//  Sorts the nodes by the ordinals their document has assigned to them.
+//  If some node is not numbered by the same document, for example a node of a tree that is not attached to a document, the order is left unchanged.
+
+void NodeList::InternalSortInDocumentOrder()
 {
-    if (std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+    if (nodes.size() < 2)
     {
-        nodes.push_back(node);
+        return;
+    }
+    Document* document = nullptr;
+    for (Node* node : nodes)
+    {
+        Node* root = node;
+        while (root->Parent())
+        {
+            root = root->Parent();
+        }
+        if (root->GetNodeType() == NodeType::documentNode)
+        {
+            document = static_cast<Document*>(root);
+            break;
+        }
+    }
+    if (!document)
+    {
+        return;
+    }
+    std::vector<std::pair<int64_t, Node*>> ordinals;
+    ordinals.reserve(nodes.size());
+    for (Node* node : nodes)
+    {
+        ordinals.push_back(std::make_pair(int64_t(0), node));
+    }
+    if (!document->InternalGetOrdinals(ordinals))
+    {
+        return;
+    }
+    std::sort(ordinals.begin(), ordinals.end());
+    for (size_t i = 0; i < ordinals.size(); ++i)
+    {
+        nodes[i] = ordinals[i].second;
     }
 }
 
@@ -9,6 +9,7 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <unordered_set>
 
 namespace cmajor { namespace dom {
 
@@ -67,10 +68,12 @@ public:
     Node& operator=(const Node&) = delete;
     Node(Node&&) = delete;
     Node& operator=(Node&&) = delete;
+    static void* operator new(size_t size);
+    static void operator delete(void* memory, size_t size);
     virtual std::unique_ptr<Node> CloneNode(bool deep) = 0;
     NodeType GetNodeType() const { return nodeType; }
-    const std::u32string& Name() const { return name; }
-    const std::u32string& NamespaceUri() const { return namespaceUri; }
+    const std::u32string& Name() const { return *name; }
+    const std::u32string& NamespaceUri() const { return *namespaceUri; }
     std::u32string Prefix() const;
     void SetPrefix(const std::u32string& prefix);
     std::u32string LocalName() const;
@@ -102,14 +105,17 @@ public:
     void InternalSetParent(ParentNode* parent_) { parent = parent_; }
     void InternalSetOwnerDocument(Document* ownerDocument_) { ownerDocument = ownerDocument_; }
     void InternalSetNamespaceUri(const std::u32string& namespaceUri_);
+    int64_t Ordinal() const { return ordinal; }
+    void InternalSetOrdinal(int64_t ordinal_) { ordinal = ordinal_; }
 private:
     NodeType nodeType;
-    std::u32string name;
-    std::u32string namespaceUri;
+    const std::u32string* name;
+    const std::u32string* namespaceUri;
     ParentNode* parent;
     Node* previousSibling;
     Node* nextSibling;
     Document* ownerDocument;
+    int64_t ordinal;
 };
 
 class ParentNode : public Node
@@ -135,7 +141,6 @@ public:
     void WalkChildren(NodeOp& nodeOp) override;
     void WalkDescendant(NodeOp& nodeOp) override;
     void WalkDescendantOrSelf(NodeOp& nodeOp) override;
-    void WalkPreceding(NodeOp& nodeOp) override;
     void WalkPrecedingOrSelf(NodeOp& nodeOp) override;
 private:
     Node* firstChild;
@@ -149,8 +154,11 @@ public:
     Node* operator[](int index) const { return nodes[index]; }
     int Length() const { return nodes.size(); }
     void InternalAddNode(Node* node);
+    void InternalSortInDocumentOrder();
 private:
+    static const int hashThreshold = 16;
     std::vector<Node*> nodes;
+    std::unordered_set<Node*> nodeSet;
 };
 
 } } // namespace cmajor::dom
@@ -0,0 +1,45 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/dom/NodeStorage.hpp>
+#include <unordered_set>
+#include <mutex>
+
+namespace cmajor { namespace dom {
+
+//  Documents are parsed and built in parallel, so the name pool is divided into independently locked shards.
+
+const int numNamePoolShards = 16;
+
+class NamePool
+{
+public:
+    const std::u32string* Intern(const std::u32string& name);
+private:
+    struct Shard
+    {
+        std::mutex mtx;
+        std::unordered_set<std::u32string> names;
+    };
+    Shard shards[numNamePoolShards];
+};
+
+const std::u32string* NamePool::Intern(const std::u32string& name)
+{
+    Shard& shard = shards[std::hash<std::u32string>()(name) % numNamePoolShards];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    return &*shard.names.insert(name).first;
+}
+
+NamePool* namePool = nullptr;
+std::once_flag namePoolFlag;
+
+const std::u32string* InternName(const std::u32string& name)
+{
+    std::call_once(namePoolFlag, []() { namePool = new NamePool(); });
+    return namePool->Intern(name);
+}
+
+} } // namespace cmajor::dom
@@ -0,0 +1,18 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#ifndef CMAJOR_DOM_NODE_STORAGE_INCLUDED
+#define CMAJOR_DOM_NODE_STORAGE_INCLUDED
+#include <string>
+
+namespace cmajor { namespace dom {
+
+//  Returns the unique copy of the given name. Interned names live until the end of the program.
+
+const std::u32string* InternName(const std::u32string& name);
+
+} } // namespace cmajor::dom
+
+#endif // CMAJOR_DOM_NODE_STORAGE_INCLUDED
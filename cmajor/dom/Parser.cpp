@@ -7,6 +7,7 @@
 #include <cmajor/dom/Element.hpp>
 #include <cmajor/dom/CharacterData.hpp>
 #include <cmajor/xml/XmlParser.hpp>
+#include <cmajor/xml/XmlSpanParser.hpp>
 #include <cmajor/util/MappedInputFile.hpp>
 #include <cmajor/util/Unicode.hpp>
 #include <cmajor/util/TextUtils.hpp>
@@ -153,10 +154,10 @@ void DomDocumentHandler::StartElement(const std::u32string& namespaceUri, const
 {
     AddTextContent(true);
     elementStack.push(std::move(currentElement));
-    std::map<std::u32string, std::unique_ptr<Attr>> attrs;
+    std::vector<std::unique_ptr<Attr>> attrs;
     for (const Attribute& attr : attributes)
     {
-        attrs[attr.QualifiedName()] = std::unique_ptr<Attr>(new Attr(attr.QualifiedName(), attr.Value()));
+        attrs.push_back(std::unique_ptr<Attr>(new Attr(attr.QualifiedName(), attr.Value())));
     }
     currentElement.reset(new Element(qualifiedName, std::move(attrs)));
     if (!namespaceUri.empty())
@@ -195,8 +196,10 @@ std::unique_ptr<Document> ParseDocument(const std::u32string& content, const std
 
 std::unique_ptr<Document> ReadDocument(const std::string& fileName)
 {
-    std::u32string content = ToUtf32(ReadFile(fileName));
-    return ParseDocument(content, fileName);
+    DomDocumentHandler domDocumentHandler;
+    XmlContentHandlerAdapter adapter(&domDocumentHandler);
+    ParseXmlFileSpans(fileName, &adapter);
+    return domDocumentHandler.GetDocument();
 }
 
 } } // namespace cmajor::dom
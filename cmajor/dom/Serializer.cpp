@@ -0,0 +1,389 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/dom/Serializer.hpp>
+#include <cmajor/dom/Document.hpp>
+#include <cmajor/dom/Element.hpp>
+#include <cmajor/dom/CharacterData.hpp>
+#include <algorithm>
+#include <sstream>
+#include <string.h>
+
+namespace cmajor { namespace dom {
+
+const int bufferSize = 256 * 1024;
+const int maxCharLength = 8;
+
+struct EscapeTables
+{
+    EscapeTables();
+    const char* charData[128];
+    const char* quotAttribute[128];
+    const char* aposAttribute[128];
+    const char* none[128];
+};
+
+EscapeTables::EscapeTables()
+{
+    for (int i = 0; i < 128; ++i)
+    {
+        charData[i] = nullptr;
+        quotAttribute[i] = nullptr;
+        aposAttribute[i] = nullptr;
+        none[i] = nullptr;
+    }
+    charData['<'] = "&lt;";
+    charData['&'] = "&amp;";
+    quotAttribute['<'] = "&lt;";
+    quotAttribute['&'] = "&amp;";
+    quotAttribute['"'] = "&quot;";
+    aposAttribute['<'] = "&lt;";
+    aposAttribute['&'] = "&amp;";
+    aposAttribute['\''] = "&apos;";
+}
+
+const EscapeTables escapeTables;
+
+Serializer::Serializer(std::ostream& stream_) : 
+    stream(stream_), buffer(new char[bufferSize]), pos(buffer), end(buffer + bufferSize), indent(true), indentSize(4), level(0), atBeginningOfLine(true), preserveSpace(false)
+{
+}
+
+Serializer::~Serializer()
+{
+    Flush();
+    delete[] buffer;
+}
+
+void Serializer::Flush()
+{
+    if (pos != buffer)
+    {
+        stream.write(buffer, pos - buffer);
+        pos = buffer;
+    }
+}
+
+void Serializer::Write(Node* node)
+{
+    WriteNode(node);
+}
+
+void Serializer::WriteNode(Node* node)
+{
+    switch (node->GetNodeType())
+    {
+        case NodeType::documentNode:
+        {
+            Document* document = static_cast<Document*>(node);
+            if (!document->XmlVersion().empty() && !document->XmlEncoding().empty())
+            {
+                Put("<?xml version=\"");
+                Put(document->XmlVersion());
+                Put("\" encoding=\"");
+                Put(document->XmlEncoding());
+                Put("\"?>");
+                NewLine();
+            }
+            WriteChildren(document);
+            break;
+        }
+        case NodeType::documentFragmentNode:
+        {
+            WriteChildren(static_cast<ParentNode*>(node));
+            break;
+        }
+        case NodeType::elementNode:
+        {
+            WriteElement(static_cast<Element*>(node));
+            break;
+        }
+        case NodeType::attributeNode:
+        {
+            Attr* attr = static_cast<Attr*>(node);
+            Put(" ");
+            Put(attr->Name());
+            Put("=");
+            PutAttributeValue(attr->Value());
+            break;
+        }
+        case NodeType::textNode:
+        {
+            PutEscaped(static_cast<Text*>(node)->Data(), escapeTables.charData);
+            break;
+        }
+        case NodeType::cdataSectionNode:
+        {
+            Put("<![CDATA[");
+            Put(static_cast<CDataSection*>(node)->Data());
+            Put("]]>");
+            break;
+        }
+        case NodeType::commentNode:
+        {
+            Put("<!-- ");
+            Put(static_cast<Comment*>(node)->Data());
+            Put(" -->");
+            break;
+        }
+        case NodeType::entityReferenceNode:
+        {
+            Put("&");
+            Put(static_cast<EntityReference*>(node)->Data());
+            Put(";");
+            break;
+        }
+        case NodeType::processingInstructionNode:
+        {
+            ProcessingInstruction* processingInstruction = static_cast<ProcessingInstruction*>(node);
+            Put("<?");
+            Put(processingInstruction->Target());
+            Put(" ");
+            Put(processingInstruction->Data());
+            Put("?>");
+            NewLine();
+            break;
+        }
+        case NodeType::documentTypeNode:
+        case NodeType::entityNode:
+        case NodeType::notationNode:
+        {
+            WriteOther(node);
+            break;
+        }
+    }
+}
+
+//  The DOM has no classes of its own for document type, entity and notation nodes, so a node of such a type is written by its own Write(CodeFormatter&).
+
+void Serializer::WriteOther(Node* node)
+{
+    std::ostringstream textStream;
+    CodeFormatter formatter(textStream);
+    formatter.SetIndentSize(indentSize);
+    node->Write(formatter);
+    std::string text = textStream.str();
+    bool endsWithNewLine = !text.empty() && text.back() == '\n';
+    if (endsWithNewLine)
+    {
+        text.pop_back();
+    }
+    if (!text.empty())
+    {
+        Put(text.c_str(), static_cast<int>(text.length()));
+    }
+    if (endsWithNewLine)
+    {
+        NewLine();
+    }
+}
+
+void Serializer::WriteChildren(ParentNode* parent)
+{
+    Node* child = parent->FirstChild();
+    while (child != nullptr)
+    {
+        WriteNode(child);
+        child = child->NextSibling();
+    }
+}
+
+bool HasMultilineContent(Element* element)
+{
+    if (element->FirstChild() != element->LastChild()) return true;
+    Node* child = element->FirstChild();
+    if (child)
+    {
+        if (child->GetNodeType() == NodeType::elementNode || child->GetNodeType() == NodeType::documentNode) return true;
+        if (child->ValueContainsNewLine()) return true;
+    }
+    return false;
+}
+
+void Serializer::WriteElement(Element* element)
+{
+    Put("<");
+    Put(element->Name());
+    WriteAttributes(element);
+    if (element->HasChildNodes())
+    {
+        Put(">");
+        bool prevPreserveSpace = preserveSpace;
+        if (element->HasAttributes() && element->GetAttribute(U"xml:space") == U"preserve")
+        {
+            preserveSpace = true;
+        }
+        bool preserve = preserveSpace || !HasMultilineContent(element);
+        if (!preserve)
+        {
+            NewLine();
+            ++level;
+        }
+        WriteChildren(element);
+        if (!preserve)
+        {
+            --level;
+        }
+        Put("</");
+        Put(element->Name());
+        Put(">");
+        if (!preserve || !prevPreserveSpace)
+        {
+            NewLine();
+        }
+        preserveSpace = prevPreserveSpace;
+    }
+    else
+    {
+        Put("/>");
+        NewLine();
+    }
+}
+
+class AttributeWriter : public NodeOp
+{
+public:
+    AttributeWriter(Serializer& serializer_) : serializer(serializer_) {}
+    void Apply(Node* node) override { serializer.Write(node); }
+private:
+    Serializer& serializer;
+};
+
+void Serializer::WriteAttributes(Element* element)
+{
+    if (element->HasAttributes())
+    {
+        AttributeWriter attributeWriter(*this);
+        element->WalkAttribute(attributeWriter);
+    }
+}
+
+void Serializer::BeginWrite()
+{
+    if (atBeginningOfLine && level != 0 && indent)
+    {
+        int n = level * indentSize;
+        while (n > 0)
+        {
+            if (pos == end)
+            {
+                Flush();
+            }
+            int count = std::min(n, static_cast<int>(end - pos));
+            memset(pos, ' ', count);
+            pos += count;
+            n -= count;
+        }
+        atBeginningOfLine = false;
+    }
+}
+
+void Serializer::NewLine()
+{
+    if (indent)
+    {
+        if (pos == end)
+        {
+            Flush();
+        }
+        *pos++ = '\n';
+        atBeginningOfLine = true;
+    }
+}
+
+void Serializer::Put(const char* s, int length)
+{
+    BeginWrite();
+    if (end - pos < length)
+    {
+        Flush();
+        if (length > bufferSize)
+        {
+            stream.write(s, length);
+            return;
+        }
+    }
+    memcpy(pos, s, length);
+    pos += length;
+}
+
+void Serializer::Put(const char* s)
+{
+    Put(s, strlen(s));
+}
+
+void Serializer::Put(const std::u32string& s)
+{
+    PutEscaped(s, escapeTables.none);
+}
+
+void Serializer::PutEscaped(const std::u32string& s, const char* const* escapes)
+{
+    BeginWrite();
+    for (char32_t c : s)
+    {
+        if (end - pos < maxCharLength)
+        {
+            Flush();
+        }
+        if (c < 0x80)
+        {
+            const char* escape = escapes[c];
+            if (escape)
+            {
+                int n = strlen(escape);
+                memcpy(pos, escape, n);
+                pos += n;
+            }
+            else
+            {
+                *pos++ = static_cast<char>(c);
+            }
+        }
+        else if (c < 0x800)
+        {
+            *pos++ = static_cast<char>(0xC0 | (c >> 6));
+            *pos++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            *pos++ = static_cast<char>(0xE0 | (c >> 12));
+            *pos++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            *pos++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            *pos++ = static_cast<char>(0xF0 | (c >> 18));
+            *pos++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            *pos++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            *pos++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+}
+
+void Serializer::PutAttributeValue(const std::u32string& value)
+{
+    if (value.find('"') != std::u32string::npos && value.find('\'') == std::u32string::npos)
+    {
+        Put("'");
+        PutEscaped(value, escapeTables.aposAttribute);
+        Put("'");
+    }
+    else
+    {
+        Put("\"");
+        PutEscaped(value, escapeTables.quotAttribute);
+        Put("\"");
+    }
+}
+
+void WriteDocument(Node* node, std::ostream& stream, int indentSize)
+{
+    Serializer serializer(stream);
+    serializer.SetIndentSize(indentSize);
+    serializer.Write(node);
+}
+
+} } // namespace cmajor::dom
@@ -0,0 +1,59 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#ifndef CMAJOR_DOM_SERIALIZER_INCLUDED
+#define CMAJOR_DOM_SERIALIZER_INCLUDED
+#include <cmajor/dom/Node.hpp>
+#include <ostream>
+
+namespace cmajor { namespace dom {
+
+class Element;
+
+//  Serializer writes nodes to a stream through a large output buffer. Names and values are converted to UTF-8 and escaped in one pass.
+//  With indentation on, the output is identical to that of Node::Write(CodeFormatter&); with indentation off, no line breaks or indentation are added.
+
+class Serializer
+{
+public:
+    Serializer(std::ostream& stream_);
+    ~Serializer();
+    Serializer(const Serializer&) = delete;
+    Serializer& operator=(const Serializer&) = delete;
+    bool Indent() const { return indent; }
+    void SetIndent(bool indent_) { indent = indent_; }
+    int IndentSize() const { return indentSize; }
+    void SetIndentSize(int indentSize_) { indentSize = indentSize_; }
+    void Write(Node* node);
+    void Flush();
+private:
+    std::ostream& stream;
+    char* buffer;
+    char* pos;
+    char* end;
+    bool indent;
+    int indentSize;
+    int level;
+    bool atBeginningOfLine;
+    bool preserveSpace;
+    void WriteNode(Node* node);
+    void WriteChildren(ParentNode* parent);
+    void WriteElement(Element* element);
+    void WriteAttributes(Element* element);
+    void WriteOther(Node* node);
+    void BeginWrite();
+    void NewLine();
+    void Put(const char* s, int length);
+    void Put(const char* s);
+    void Put(const std::u32string& s);
+    void PutEscaped(const std::u32string& s, const char* const* escapes);
+    void PutAttributeValue(const std::u32string& value);
+};
+
+void WriteDocument(Node* node, std::ostream& stream, int indentSize);
+
+} } // namespace cmajor::dom
+
+#endif // CMAJOR_DOM_SERIALIZER_INCLUDED
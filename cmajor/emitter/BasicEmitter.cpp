@@ -16,8 +16,11 @@
 #include <cmajor/util/TextUtils.hpp>
 #include <cmajor/util/Path.hpp>
 #include <cmajor/util/Util.hpp>
+#include <llvm/CodeGen/ParallelCG.h>
+#include <algorithm>
 #include <mutex>
 #include <fstream>
+#include <thread>
 
 namespace cmajor { namespace emitter {
 
@@ -118,6 +121,10 @@ void BasicEmitter::Visit(BoundCompileUnit& boundCompileUnit)
         SetDICompileUnit(diCompileUnit);
         SetCurrentCompileUnitNode(boundCompileUnit.GetCompileUnitNode());
         PushScope(sourceFile);
+        for (const auto& boundNode : boundCompileUnit.BoundNodes())
+        {
+            SetClassesDefined(boundNode.get());
+        }
     }
     compileUnit = &boundCompileUnit;
     symbolTable = &boundCompileUnit.GetSymbolTable();
@@ -141,6 +148,9 @@ void BasicEmitter::Visit(BoundCompileUnit& boundCompileUnit)
     {
         ReplaceForwardDeclarations();
         diBuilder->finalize();
+        PopScope();
+        SetDIBuilder(nullptr);
+        diBuilder.reset();
     }
     if (GetGlobalFlag(GlobalFlags::emitLlvm))
     {
@@ -154,6 +164,77 @@ void BasicEmitter::Visit(BoundCompileUnit& boundCompileUnit)
     {
         throw std::runtime_error("Emitter: verification of module '" + compileUnitModule->getSourceFileName() + "' failed. " + errorMessage.str());
     }
+    EmitObjectCode(boundCompileUnit);
+    if (GetGlobalFlag(GlobalFlags::emitOptLlvm))
+    {
+        std::string optCommandLine;
+        optCommandLine.append("opt -O").append(std::to_string(GetOptimizationLevel())).append(" ").append(QuotedPath(boundCompileUnit.LLFilePath())).append(" -S -o ");
+        optCommandLine.append(QuotedPath(boundCompileUnit.OptLLFilePath()));
+        System(optCommandLine);
+    }
+}
+
+//  Code for a compile unit whose module has at least twice this many instructions is generated in parallel: 
+//  the module is split into parts of at least this size and each part is compiled to an object file of its own by a thread of its own.
+
+const int minNumInstructionsPerCodeGenPart = 50000;
+
+int GetNumCodeGenParts(llvm::Module& module)
+{
+    int64_t numInstructions = 0;
+    for (llvm::Function& function : module)
+    {
+        for (llvm::BasicBlock& basicBlock : function)
+        {
+            numInstructions += basicBlock.size();
+        }
+    }
+    return static_cast<int>(numInstructions / minNumInstructionsPerCodeGenPart);
+}
+
+//  Compile units and projects are already compiled by several threads at the same time, so the threads that generate object code share one budget.
+//  A thread generating code for a compile unit holds one thread of the budget, and splits the unit into more parts only if the budget has free threads.
+
+class CodeGenThreads
+{
+public:
+    CodeGenThreads(int numParts);
+    CodeGenThreads(const CodeGenThreads&) = delete;
+    CodeGenThreads& operator=(const CodeGenThreads&) = delete;
+    ~CodeGenThreads();
+    int Count() const { return count; }
+private:
+    int count;
+};
+
+std::mutex codeGenThreadMutex;
+int numCodeGenThreadsInUse = 0;
+
+CodeGenThreads::CodeGenThreads(int numParts) : count(1)
+{
+    std::lock_guard<std::mutex> lock(codeGenThreadMutex);
+    int numFreeThreads = static_cast<int>(std::thread::hardware_concurrency()) - numCodeGenThreadsInUse;
+    if (numParts > 1 && numFreeThreads > 1)
+    {
+        count = std::min(numParts, numFreeThreads);
+    }
+    numCodeGenThreadsInUse += count;
+}
+
+CodeGenThreads::~CodeGenThreads()
+{
+    std::lock_guard<std::mutex> lock(codeGenThreadMutex);
+    numCodeGenThreadsInUse -= count;
+}
+
+void BasicEmitter::EmitObjectCode(BoundCompileUnit& boundCompileUnit)
+{
+    CodeGenThreads codeGenThreads(GetNumCodeGenParts(*compileUnitModule));
+    if (codeGenThreads.Count() > 1)
+    {
+        EmitObjectCodeInParallel(boundCompileUnit, codeGenThreads.Count());
+        return;
+    }
     llvm::legacy::PassManager passManager;
     std::error_code errorCode;
     llvm::raw_fd_ostream objectFile(boundCompileUnit.ObjectFilePath(), errorCode, llvm::sys::fs::F_None);
@@ -167,17 +248,45 @@ void BasicEmitter::Visit(BoundCompileUnit& boundCompileUnit)
     {
         throw std::runtime_error("Emitter: could not emit object code file '" + boundCompileUnit.ObjectFilePath() + "': " + errorCode.message());
     }
-    if (GetGlobalFlag(GlobalFlags::emitOptLlvm))
+}
+
+//  The parts are moved to contexts of their own before code is generated for them, so the module cannot be used after this.
+//  The debug info builder refers to the module, so it has been destroyed before this is called.
+//  Local symbols are kept in the same part as their users, so that the parts do not export names that could clash with those of other compile units.
+
+void BasicEmitter::EmitObjectCodeInParallel(BoundCompileUnit& boundCompileUnit, int numParts)
+{
+    std::vector<std::string> objectFilePaths;
+    objectFilePaths.push_back(boundCompileUnit.ObjectFilePath());
+    for (int i = 1; i < numParts; ++i)
     {
-        std::string optCommandLine;
-        optCommandLine.append("opt -O").append(std::to_string(GetOptimizationLevel())).append(" ").append(QuotedPath(boundCompileUnit.LLFilePath())).append(" -S -o ");
-        optCommandLine.append(QuotedPath(boundCompileUnit.OptLLFilePath()));
-        System(optCommandLine);
+        std::string objectFilePath = Path::ChangeExtension(boundCompileUnit.ObjectFilePath(), "." + std::to_string(i) + Path::GetExtension(boundCompileUnit.ObjectFilePath()));
+        objectFilePaths.push_back(objectFilePath);
+        boundCompileUnit.AddObjectFilePath(objectFilePath);
     }
-    if (debugInfo)
+    std::vector<std::unique_ptr<llvm::raw_fd_ostream>> objectFiles;
+    std::vector<llvm::raw_pwrite_stream*> objectFileStreams;
+    std::vector<std::error_code> errorCodes(numParts);
+    for (int i = 0; i < numParts; ++i)
     {
-        PopScope();
-        diBuilder.reset();
+        objectFiles.push_back(std::unique_ptr<llvm::raw_fd_ostream>(new llvm::raw_fd_ostream(objectFilePaths[i], errorCodes[i], llvm::sys::fs::F_None)));
+        if (errorCodes[i])
+        {
+            throw std::runtime_error("Emitter: could not create object code file '" + objectFilePaths[i] + "': " + errorCodes[i].message());
+        }
+        objectFileStreams.push_back(objectFiles.back().get());
+    }
+    EmittingContextImpl* emittingContextImpl = emittingContext.GetEmittingContextImpl();
+    llvm::splitCodeGen(std::move(compileUnitModule), objectFileStreams, {}, [emittingContextImpl]() { return emittingContextImpl->CreateTargetMachine(); },
+        llvm::TargetMachine::CodeGenFileType::CGFT_ObjectFile, true);
+    SetModule(nullptr);
+    for (int i = 0; i < numParts; ++i)
+    {
+        objectFiles[i]->flush();
+        if (objectFiles[i]->has_error())
+        {
+            throw std::runtime_error("Emitter: could not emit object code file '" + objectFilePaths[i] + "': " + objectFiles[i]->error().message());
+        }
     }
 }
 
@@ -243,6 +352,12 @@ void BasicEmitter::Visit(BoundClass& boundClass)
         {
             PushScope(diType);
         }
+        else if (currentClass->GetClassTypeSymbol()->IsPolymorphic() && !IsClassDefined(currentClass->GetClassTypeSymbol()->TypeId()))
+        {
+            llvm::DIType* declaration = currentClass->GetClassTypeSymbol()->CreateDIDeclaration(*this);
+            SetDITypeByTypeId(currentClass->GetClassTypeSymbol()->TypeId(), declaration);
+            PushScope(declaration);
+        }
         else
         {
             llvm::DIType* baseClass = nullptr;
@@ -1507,6 +1622,35 @@ void BasicEmitter::SetLineNumber(int32_t lineNumber)
     }
 }
 
+//  Full debug information of a polymorphic class is emitted only by the compile units that define the class, that is, the units that generate its vmt.
+//  Every object of the class refers to the vmt, so a program that uses the class links one of those units.
+//  Other compile units refer to the class by a declaration having the same identifier.
+//  Other classes may have no code that would cause their defining unit to be linked, so their full debug information is emitted by each unit that uses them.
+
+void BasicEmitter::SetClassesDefined(BoundNode* boundNode)
+{
+    if (boundNode->GetBoundNodeType() == BoundNodeType::boundNamespace)
+    {
+        BoundNamespace* boundNamespace = static_cast<BoundNamespace*>(boundNode);
+        for (const auto& member : boundNamespace->Members())
+        {
+            SetClassesDefined(member.get());
+        }
+    }
+    else if (boundNode->GetBoundNodeType() == BoundNodeType::boundClass)
+    {
+        BoundClass* boundClass = static_cast<BoundClass*>(boundNode);
+        if (!boundClass->IsInlineFunctionContainer())
+        {
+            SetClassDefined(boundClass->GetClassTypeSymbol()->TypeId());
+        }
+        for (const auto& member : boundClass->Members())
+        {
+            SetClassesDefined(member.get());
+        }
+    }
+}
+
 llvm::DIType* BasicEmitter::CreateClassDIType(void* classPtr)
 {
     ClassTypeSymbol* cls = static_cast<ClassTypeSymbol*>(classPtr);
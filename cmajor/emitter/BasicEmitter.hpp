@@ -148,6 +148,9 @@ protected:
     void SetTarget(BoundStatement* labeledStatement);
     void ClearFlags();
     void InsertAllocaIntoEntryBlock(llvm::AllocaInst* allocaInst);
+    void SetClassesDefined(BoundNode* boundNode);
+    void EmitObjectCode(BoundCompileUnit& boundCompileUnit);
+    void EmitObjectCodeInParallel(BoundCompileUnit& boundCompileUnit, int numParts);
 };
 
 } } // namespace cmajor::emitter
@@ -15,6 +15,7 @@ namespace cmajor { namespace emitter {
 
 void GenerateCode(EmittingContext& emittingContext, BoundCompileUnit& boundCompileUnit)
 {
+    BoundNodeArenaScope arenaScope(boundCompileUnit.GetBoundNodeArena());
 #ifdef _WIN32
     WindowsEmitter emitter(emittingContext, boundCompileUnit.GetCompileUnitNode()->FilePath(), boundCompileUnit.GetModule());
 #else
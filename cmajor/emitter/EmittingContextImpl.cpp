@@ -10,7 +10,7 @@ namespace cmajor { namespace emitter {
 
 using namespace cmajor::symbols;
 
-EmittingContextImpl::EmittingContextImpl() : targetTriple(), optimizationLevel(0), targetMachine(), dataLayout()
+EmittingContextImpl::EmittingContextImpl() : targetTriple(), optimizationLevel(0), target(nullptr), targetOptions(), codeGenLevel(llvm::CodeGenOpt::None), targetMachine(), dataLayout()
 {
     llvm::InitializeAllTargetInfos();
     llvm::InitializeAllTargets();
@@ -34,18 +34,14 @@ EmittingContextImpl::EmittingContextImpl() : targetTriple(), optimizationLevel(0
     targetTriple = llvm::sys::getDefaultTargetTriple();
 #endif
     std::string error;
-    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+    target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
     if (!target)
     {
         throw std::runtime_error("EmittingContext: TargetRegistry::lookupTarget failed: " + error);
     }
-    llvm::TargetOptions targetOptions = {};
 #ifdef _WIN32
     targetOptions.ExceptionModel = llvm::ExceptionHandling::WinEH;
 #endif
-    llvm::Optional<llvm::Reloc::Model> relocModel;
-    llvm::CodeModel::Model codeModel = llvm::CodeModel::Large;
-    llvm::CodeGenOpt::Level codeGenLevel = llvm::CodeGenOpt::None;
     optimizationLevel = GetOptimizationLevel();
     switch (optimizationLevel)
     {
@@ -54,8 +50,15 @@ EmittingContextImpl::EmittingContextImpl() : targetTriple(), optimizationLevel(0
         case 2: codeGenLevel = llvm::CodeGenOpt::Default; break;
         case 3: codeGenLevel = llvm::CodeGenOpt::Aggressive; break;
     }
-    targetMachine.reset(target->createTargetMachine(targetTriple, "generic", "", targetOptions, relocModel, codeModel, codeGenLevel));
+    targetMachine = CreateTargetMachine();
     dataLayout.reset(new llvm::DataLayout(targetMachine->createDataLayout()));
 }
 
+std::unique_ptr<llvm::TargetMachine> EmittingContextImpl::CreateTargetMachine() const
+{
+    llvm::Optional<llvm::Reloc::Model> relocModel;
+    llvm::CodeModel::Model codeModel = llvm::CodeModel::Large;
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(targetTriple, "generic", "", targetOptions, relocModel, codeModel, codeGenLevel));
+}
+
 } } // namespace cmajor::emitter
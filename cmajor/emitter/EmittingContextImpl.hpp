@@ -34,10 +34,14 @@ public:
     const std::string& TargetTriple() const { return targetTriple; }
     llvm::DataLayout& DataLayout() { return *dataLayout; }
     llvm::TargetMachine& TargetMachine() { return *targetMachine; }
+    std::unique_ptr<llvm::TargetMachine> CreateTargetMachine() const;
 private:
     llvm::LLVMContext context;
     std::string targetTriple;
     int optimizationLevel;
+    const llvm::Target* target;
+    llvm::TargetOptions targetOptions;
+    llvm::CodeGenOpt::Level codeGenLevel;
     std::unique_ptr<llvm::TargetMachine> targetMachine;
     std::unique_ptr<llvm::DataLayout> dataLayout;
 };
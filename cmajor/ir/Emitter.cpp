@@ -350,4 +350,14 @@ void Emitter::SetImtArrayObjectName(void* symbol, const std::string& imtArrayObj
     imtArrayObjectNameMap[symbol] = imtArrayObjectName;
 }
 
+bool Emitter::IsClassDefined(const boost::uuids::uuid& classTypeId) const
+{
+    return classDefinedSet.find(classTypeId) != classDefinedSet.cend();
+}
+
+void Emitter::SetClassDefined(const boost::uuids::uuid& classTypeId)
+{
+    classDefinedSet.insert(classTypeId);
+}
+
 } } // namespace cmajor::ir
@@ -104,6 +104,8 @@ public:
     void SetVmtObjectName(void* symbol, const std::string& vmtObjectName);
     std::string GetImtArrayObjectName(void* symbol) const;
     void SetImtArrayObjectName(void* symbol, const std::string& imtArrayObjectName);
+    bool IsClassDefined(const boost::uuids::uuid& classTypeId) const;
+    void SetClassDefined(const boost::uuids::uuid& classTypeId);
 private:
     llvm::LLVMContext& context;
     llvm::IRBuilder<> builder;
@@ -137,6 +139,7 @@ private:
     std::unordered_map<void*, std::string> staticObjectNameMap;
     std::unordered_map<void*, std::string> vmtObjectNameMap;
     std::unordered_map<void*, std::string> imtArrayObjectNameMap;
+    std::unordered_set<boost::uuids::uuid, boost::hash<boost::uuids::uuid>> classDefinedSet;
 };
 
 } } // namespace cmajor::ir
@@ -124,3 +124,19 @@ const char* bz2_retval_str(int32_t retVal)
     }
     return "";
 }
+
+uint32_t bz2_compress_block_bound(uint32_t inSize)
+{
+    return inSize + inSize / 100 + 600;
+}
+
+//  Compresses a block as a complete bzip2 stream.
+
+int32_t bz2_compress_block(int32_t compressionLevel, int32_t compressionWorkFactor, void* in, uint32_t inSize, void* out, uint32_t* outSize)
+{
+    char empty = 0;
+    unsigned int destLen = *outSize;
+    int32_t ret = BZ2_bzBuffToBuffCompress((char*)out, &destLen, inSize > 0 ? (char*)in : &empty, inSize, compressionLevel, 0, compressionWorkFactor);
+    *outSize = destLen;
+    return ret;
+}
@@ -17,6 +17,8 @@ void bz2_set_input(void* inChunk, uint32_t inAvail, void* handle);
 int32_t bz2_compress(void* outChunk, uint32_t outChunkSize, uint32_t* have, uint32_t* outAvail, void* handle, int32_t action);
 int32_t bz2_decompress(void* outChunk, uint32_t outChunkSize, uint32_t* have, uint32_t* outAvail, uint32_t* inAvail, void* handle);
 const char* bz2_retval_str(int32_t retVal);
+uint32_t bz2_compress_block_bound(uint32_t inSize);
+int32_t bz2_compress_block(int32_t compressionLevel, int32_t compressionWorkFactor, void* in, uint32_t inSize, void* out, uint32_t* outSize);
 
 #if defined (__cplusplus)
 }
@@ -6,6 +6,14 @@
 #include <cmajor/rt/Compression.hpp>
 #include <cmajor/rt/ZlibInterface.h>
 #include <cmajor/rt/BZ2Interface.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
 
 //  ZLIB:
 
@@ -70,3 +78,532 @@ extern "C" RT_API const char* RtRetvalStrBZip2(int32_t retVal)
 {
     return bz2_retval_str(retVal);
 }
+
+namespace cmajor { namespace rt {
+
+const int32_t zOk = 0;
+const int32_t zStreamEnd = 1;
+const int32_t zStreamError = -2;
+const int32_t zMemError = -4;
+const int32_t bzOk = 0;
+const int32_t bzStreamEnd = 4;
+const int32_t bzSequenceError = -1;
+const int32_t bzParamError = -2;
+const int32_t bzMemError = -3;
+
+struct CompressionBlock
+{
+    CompressionBlock() : index(0), inputSize(0), check(0), last(false), done(false) {}
+    int64_t index;
+    int64_t inputSize;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> dictionary;
+    std::vector<uint8_t> output;
+    uint32_t check;
+    bool last;
+    bool done;
+};
+
+//  Compresses blocks of input on a set of worker threads and hands out the compressed blocks in input order.
+//  The number of blocks that are queued or being compressed is limited, so Write waits for the workers when they fall behind.
+//  The workers call the virtual CompressBlock, so a derived class must call Stop in its destructor to join them before its own members are destroyed.
+
+class ParallelCompressor
+{
+public:
+    ParallelCompressor(int32_t numThreads_, int64_t blockSize_, int64_t dictionarySize_, int32_t okCode_, int32_t streamEndCode_, int32_t sequenceErrorCode_,
+        int32_t memErrorCode_);
+    ParallelCompressor(const ParallelCompressor&) = delete;
+    ParallelCompressor& operator=(const ParallelCompressor&) = delete;
+    virtual ~ParallelCompressor();
+    void Start();
+    void Stop();
+    int32_t Write(const uint8_t* data, int64_t size);
+    int32_t Finish();
+    int32_t Read(uint8_t* outChunk, int64_t outChunkSize, int64_t* have, bool wait);
+protected:
+    virtual int32_t CompressBlock(CompressionBlock* block) = 0;
+    virtual void MakeHeader(std::vector<uint8_t>& header) {}
+    virtual void BlockRead(CompressionBlock* block) {}
+    virtual void MakeTrailer(std::vector<uint8_t>& trailer) {}
+private:
+    int32_t numThreads;
+    int64_t blockSize;
+    int64_t dictionarySize;
+    int32_t okCode;
+    int32_t streamEndCode;
+    int32_t sequenceErrorCode;
+    int32_t memErrorCode;
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable blockQueued;
+    std::condition_variable blockDone;
+    std::deque<std::unique_ptr<CompressionBlock>> blocks;
+    std::deque<CompressionBlock*> queue;
+    int numQueuedBlocks;
+    int64_t nextBlockIndex;
+    std::vector<uint8_t> pending;
+    std::vector<uint8_t> tail;
+    std::vector<uint8_t> output;
+    int64_t outputPos;
+    bool headerRead;
+    bool trailerRead;
+    bool finished;
+    bool exiting;
+    int32_t error;
+    int32_t SubmitBlock(bool last);
+    void Run();
+};
+
+ParallelCompressor::ParallelCompressor(int32_t numThreads_, int64_t blockSize_, int64_t dictionarySize_, int32_t okCode_, int32_t streamEndCode_, int32_t sequenceErrorCode_, int32_t memErrorCode_) :
+    numThreads(numThreads_), blockSize(blockSize_), dictionarySize(dictionarySize_), okCode(okCode_), streamEndCode(streamEndCode_), sequenceErrorCode(sequenceErrorCode_),
+    memErrorCode(memErrorCode_), numQueuedBlocks(0), nextBlockIndex(0), outputPos(0), headerRead(false), trailerRead(false), finished(false), exiting(false), error(okCode_)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1, int32_t(std::thread::hardware_concurrency()));
+    }
+}
+
+ParallelCompressor::~ParallelCompressor()
+{
+    Stop();
+}
+
+void ParallelCompressor::Start()
+{
+    for (int32_t i = 0; i < numThreads; ++i)
+    {
+        threads.push_back(std::thread{ &ParallelCompressor::Run, this });
+    }
+}
+
+void ParallelCompressor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        exiting = true;
+    }
+    blockQueued.notify_all();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+}
+
+void ParallelCompressor::Run()
+{
+    while (true)
+    {
+        CompressionBlock* block = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            blockQueued.wait(lock, [this]{ return exiting || !queue.empty(); });
+            if (exiting) return;
+            block = queue.front();
+            queue.pop_front();
+        }
+        int32_t ret = okCode;
+        try
+        {
+            ret = CompressBlock(block);
+        }
+        catch (const std::bad_alloc&)
+        {
+            ret = memErrorCode;
+        }
+        block->input.clear();
+        block->input.shrink_to_fit();
+        block->dictionary.clear();
+        block->dictionary.shrink_to_fit();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            block->done = true;
+            --numQueuedBlocks;
+            if (ret < 0 && error == okCode)
+            {
+                error = ret;
+            }
+        }
+        blockDone.notify_all();
+    }
+}
+
+int32_t ParallelCompressor::SubmitBlock(bool last)
+{
+    std::unique_ptr<CompressionBlock> block(new CompressionBlock());
+    block->index = nextBlockIndex++;
+    block->last = last;
+    block->inputSize = pending.size();
+    block->input.swap(pending);
+    if (dictionarySize > 0)
+    {
+        block->dictionary = tail;
+        int64_t n = std::min(dictionarySize, block->inputSize);
+        if (n == dictionarySize)
+        {
+            tail.assign(block->input.end() - n, block->input.end());
+        }
+        else
+        {
+            tail.insert(tail.end(), block->input.begin(), block->input.end());
+            if (int64_t(tail.size()) > dictionarySize)
+            {
+                tail.erase(tail.begin(), tail.end() - dictionarySize);
+            }
+        }
+    }
+    pending.reserve(blockSize);
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        blockDone.wait(lock, [this]{ return numQueuedBlocks < 2 * numThreads || error != okCode; });
+        if (error != okCode) return error;
+        queue.push_back(block.get());
+        blocks.push_back(std::move(block));
+        ++numQueuedBlocks;
+    }
+    blockQueued.notify_one();
+    return okCode;
+}
+
+int32_t ParallelCompressor::Write(const uint8_t* data, int64_t size)
+{
+    if (finished) return sequenceErrorCode;
+    while (size > 0)
+    {
+        int64_t n = std::min(size, blockSize - int64_t(pending.size()));
+        pending.insert(pending.end(), data, data + n);
+        data += n;
+        size -= n;
+        if (int64_t(pending.size()) == blockSize)
+        {
+            int32_t ret = SubmitBlock(false);
+            if (ret != okCode) return ret;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    return error;
+}
+
+int32_t ParallelCompressor::Finish()
+{
+    if (finished) return sequenceErrorCode;
+    finished = true;
+    return SubmitBlock(true);
+}
+
+int32_t ParallelCompressor::Read(uint8_t* outChunk, int64_t outChunkSize, int64_t* have, bool wait)
+{
+    *have = 0;
+    while (*have < outChunkSize)
+    {
+        if (outputPos < int64_t(output.size()))
+        {
+            int64_t n = std::min(outChunkSize - *have, int64_t(output.size()) - outputPos);
+            std::copy(output.begin() + outputPos, output.begin() + outputPos + n, outChunk + *have);
+            outputPos += n;
+            *have += n;
+            continue;
+        }
+        output.clear();
+        outputPos = 0;
+        if (!headerRead)
+        {
+            MakeHeader(output);
+            headerRead = true;
+            continue;
+        }
+        std::unique_ptr<CompressionBlock> block;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (error != okCode) return error;
+            if (!blocks.empty() && blocks.front()->done)
+            {
+                block = std::move(blocks.front());
+                blocks.pop_front();
+            }
+            else if (!blocks.empty() || !finished)
+            {
+                if (*have > 0 || !wait || blocks.empty()) return okCode;
+                blockDone.wait(lock, [this]{ return blocks.front()->done || error != okCode; });
+                continue;
+            }
+        }
+        if (block)
+        {
+            BlockRead(block.get());
+            output.swap(block->output);
+        }
+        else if (!trailerRead)
+        {
+            MakeTrailer(output);
+            trailerRead = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (*have == 0 && trailerRead)
+    {
+        return streamEndCode;
+    }
+    return okCode;
+}
+
+//  Produces a zlib or gzip stream: the blocks are compressed as raw deflate data using the end of the preceding block as a dictionary, 
+//  and the block checksums are combined in order for the trailer.
+
+class ParallelZlibCompressor : public ParallelCompressor
+{
+public:
+    ParallelZlibCompressor(int32_t level_, int32_t format_, int32_t numThreads_, int64_t blockSize_);
+    ~ParallelZlibCompressor();
+protected:
+    int32_t CompressBlock(CompressionBlock* block) override;
+    void MakeHeader(std::vector<uint8_t>& header) override;
+    void BlockRead(CompressionBlock* block) override;
+    void MakeTrailer(std::vector<uint8_t>& trailer) override;
+private:
+    int32_t level;
+    int32_t format;
+    uint32_t check;
+    int64_t totalSize;
+};
+
+const int32_t zlibFormat = 0;
+const int32_t gzipFormat = 1;
+const int64_t defaultDeflateBlockSize = 128 * 1024;
+const int64_t deflateDictionarySize = 32 * 1024;
+
+ParallelZlibCompressor::ParallelZlibCompressor(int32_t level_, int32_t format_, int32_t numThreads_, int64_t blockSize_) :
+    ParallelCompressor(numThreads_, blockSize_ > 0 ? blockSize_ : defaultDeflateBlockSize, deflateDictionarySize, zOk, zStreamEnd, zStreamError, zMemError),
+    level(level_), format(format_), check(0), totalSize(0)
+{
+}
+
+ParallelZlibCompressor::~ParallelZlibCompressor()
+{
+    Stop();
+}
+
+int32_t ParallelZlibCompressor::CompressBlock(CompressionBlock* block)
+{
+    uint32_t outSize = zlib_deflate_block_bound(uint32_t(block->inputSize));
+    block->output.resize(outSize);
+    int32_t ret = zlib_deflate_block(level, block->dictionary.data(), uint32_t(block->dictionary.size()), block->input.data(), uint32_t(block->inputSize), 
+        block->output.data(), &outSize, block->last);
+    block->output.resize(outSize);
+    if (format == gzipFormat)
+    {
+        block->check = zlib_crc32(block->input.data(), uint32_t(block->inputSize));
+    }
+    else
+    {
+        block->check = zlib_adler32(block->input.data(), uint32_t(block->inputSize));
+    }
+    return ret;
+}
+
+void ParallelZlibCompressor::MakeHeader(std::vector<uint8_t>& header)
+{
+    if (format == gzipFormat)
+    {
+        uint8_t extraFlags = level == 9 ? 2 : level == 1 ? 4 : 0;
+        uint8_t gzipHeader[] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, extraFlags, 255 };
+        header.insert(header.end(), gzipHeader, gzipHeader + sizeof(gzipHeader));
+    }
+    else
+    {
+        int levelFlags = level == -1 || level == 6 ? 2 : level >= 7 ? 3 : level >= 2 ? 1 : 0;
+        unsigned int zlibHeader = (0x78 << 8) | (levelFlags << 6);
+        zlibHeader += 31 - zlibHeader % 31;
+        header.push_back(uint8_t(zlibHeader >> 8));
+        header.push_back(uint8_t(zlibHeader));
+    }
+}
+
+void ParallelZlibCompressor::BlockRead(CompressionBlock* block)
+{
+    if (block->index == 0)
+    {
+        check = block->check;
+    }
+    else if (format == gzipFormat)
+    {
+        check = zlib_crc32_combine(check, block->check, block->inputSize);
+    }
+    else
+    {
+        check = zlib_adler32_combine(check, block->check, block->inputSize);
+    }
+    totalSize += block->inputSize;
+}
+
+void ParallelZlibCompressor::MakeTrailer(std::vector<uint8_t>& trailer)
+{
+    if (format == gzipFormat)
+    {
+        uint32_t size = uint32_t(totalSize);
+        for (int i = 0; i < 4; ++i)
+        {
+            trailer.push_back(uint8_t(check >> (8 * i)));
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            trailer.push_back(uint8_t(size >> (8 * i)));
+        }
+    }
+    else
+    {
+        for (int i = 3; i >= 0; --i)
+        {
+            trailer.push_back(uint8_t(check >> (8 * i)));
+        }
+    }
+}
+
+class ParallelBZip2Compressor : public ParallelCompressor
+{
+public:
+    ParallelBZip2Compressor(int32_t compressionLevel_, int32_t compressionWorkFactor_, int32_t numThreads_, int64_t blockSize_);
+    ~ParallelBZip2Compressor();
+protected:
+    int32_t CompressBlock(CompressionBlock* block) override;
+private:
+    int32_t compressionLevel;
+    int32_t compressionWorkFactor;
+};
+
+ParallelBZip2Compressor::ParallelBZip2Compressor(int32_t compressionLevel_, int32_t compressionWorkFactor_, int32_t numThreads_, int64_t blockSize_) :
+    ParallelCompressor(numThreads_, blockSize_ > 0 ? blockSize_ : compressionLevel_ * int64_t(100000), 0, bzOk, bzStreamEnd, bzSequenceError, bzMemError),
+    compressionLevel(compressionLevel_), compressionWorkFactor(compressionWorkFactor_)
+{
+}
+
+ParallelBZip2Compressor::~ParallelBZip2Compressor()
+{
+    Stop();
+}
+
+int32_t ParallelBZip2Compressor::CompressBlock(CompressionBlock* block)
+{
+    if (block->inputSize == 0 && block->index > 0)
+    {
+        return bzOk;
+    }
+    uint32_t outSize = bz2_compress_block_bound(uint32_t(block->inputSize));
+    block->output.resize(outSize);
+    int32_t ret = bz2_compress_block(compressionLevel, compressionWorkFactor, block->input.data(), uint32_t(block->inputSize), block->output.data(), &outSize);
+    block->output.resize(outSize);
+    return ret;
+}
+
+} } // namespace cmajor::rt
+
+using namespace cmajor::rt;
+
+extern "C" RT_API int32_t RtInitParallelZlib(int32_t level, int32_t format, int32_t numThreads, int64_t blockSize, void** handle)
+{
+    if (!handle) return zMemError;
+    *handle = nullptr;
+    if (level < -1 || level > 9 || (format != zlibFormat && format != gzipFormat) || blockSize < 0 || blockSize > 0x7FFFFFFF) return zStreamError;
+    try
+    {
+        std::unique_ptr<ParallelZlibCompressor> compressor(new ParallelZlibCompressor(level, format, numThreads, blockSize));
+        compressor->Start();
+        *handle = compressor.release();
+        return zOk;
+    }
+    catch (const std::exception&)
+    {
+        return zMemError;
+    }
+}
+
+extern "C" RT_API void RtDoneParallelZlib(void* handle)
+{
+    delete static_cast<ParallelZlibCompressor*>(handle);
+}
+
+extern "C" RT_API int32_t RtWriteParallelZlib(void* data, int64_t size, void* handle)
+{
+    try
+    {
+        return static_cast<ParallelZlibCompressor*>(handle)->Write(static_cast<const uint8_t*>(data), size);
+    }
+    catch (const std::exception&)
+    {
+        return zMemError;
+    }
+}
+
+extern "C" RT_API int32_t RtFinishParallelZlib(void* handle)
+{
+    try
+    {
+        return static_cast<ParallelZlibCompressor*>(handle)->Finish();
+    }
+    catch (const std::exception&)
+    {
+        return zMemError;
+    }
+}
+
+extern "C" RT_API int32_t RtReadParallelZlib(void* outChunk, int64_t outChunkSize, int64_t* have, int32_t wait, void* handle)
+{
+    return static_cast<ParallelZlibCompressor*>(handle)->Read(static_cast<uint8_t*>(outChunk), outChunkSize, have, wait != 0);
+}
+
+extern "C" RT_API int32_t RtInitParallelBZip2(int32_t compressionLevel, int32_t compressionWorkFactor, int32_t numThreads, int64_t blockSize, void** handle)
+{
+    if (!handle) return bzMemError;
+    *handle = nullptr;
+    if (compressionLevel < 1 || compressionLevel > 9 || compressionWorkFactor < 0 || compressionWorkFactor > 250 || blockSize < 0 || blockSize > 0x7FFFFFFF) return bzParamError;
+    try
+    {
+        std::unique_ptr<ParallelBZip2Compressor> compressor(new ParallelBZip2Compressor(compressionLevel, compressionWorkFactor, numThreads, blockSize));
+        compressor->Start();
+        *handle = compressor.release();
+        return bzOk;
+    }
+    catch (const std::exception&)
+    {
+        return bzMemError;
+    }
+}
+
+extern "C" RT_API void RtDoneParallelBZip2(void* handle)
+{
+    delete static_cast<ParallelBZip2Compressor*>(handle);
+}
+
+extern "C" RT_API int32_t RtWriteParallelBZip2(void* data, int64_t size, void* handle)
+{
+    try
+    {
+        return static_cast<ParallelBZip2Compressor*>(handle)->Write(static_cast<const uint8_t*>(data), size);
+    }
+    catch (const std::exception&)
+    {
+        return bzMemError;
+    }
+}
+
+extern "C" RT_API int32_t RtFinishParallelBZip2(void* handle)
+{
+    try
+    {
+        return static_cast<ParallelBZip2Compressor*>(handle)->Finish();
+    }
+    catch (const std::exception&)
+    {
+        return bzMemError;
+    }
+}
+
+extern "C" RT_API int32_t RtReadParallelBZip2(void* outChunk, int64_t outChunkSize, int64_t* have, int32_t wait, void* handle)
+{
+    return static_cast<ParallelBZip2Compressor*>(handle)->Read(static_cast<uint8_t*>(outChunk), outChunkSize, have, wait != 0);
+}
@@ -26,5 +26,25 @@ extern "C" RT_API int32_t RtCompressBZip2(void* outChunk, uint32_t outChunkSize,
 extern "C" RT_API int32_t RtDecompressBZip2(void* outChunk, uint32_t outChunkSize, uint32_t* have, uint32_t* outAvail, uint32_t* inAvail, void* handle);
 extern "C" RT_API const char* RtRetvalStrBZip2(int32_t retVal);
 
+//  Parallel block compression:
+//  Input is split into blocks that are compressed independently by a set of threads.
+//  Write and Finish hand input to the compressor, Read returns the compressed output in order.
+//  If wait is zero, Read returns only output that is ready, otherwise it waits until some output is ready.
+//  Read returns the stream end code of the library when all output has been read.
+//  Zlib output is a single zlib (format 0) or gzip (format 1) stream.
+//  BZip2 output is a sequence of bzip2 streams, one for each block, that standard bzip2 decompressors accept as a single file.
+
+extern "C" RT_API int32_t RtInitParallelZlib(int32_t level, int32_t format, int32_t numThreads, int64_t blockSize, void** handle);
+extern "C" RT_API void RtDoneParallelZlib(void* handle);
+extern "C" RT_API int32_t RtWriteParallelZlib(void* data, int64_t size, void* handle);
+extern "C" RT_API int32_t RtFinishParallelZlib(void* handle);
+extern "C" RT_API int32_t RtReadParallelZlib(void* outChunk, int64_t outChunkSize, int64_t* have, int32_t wait, void* handle);
+
+extern "C" RT_API int32_t RtInitParallelBZip2(int32_t compressionLevel, int32_t compressionWorkFactor, int32_t numThreads, int64_t blockSize, void** handle);
+extern "C" RT_API void RtDoneParallelBZip2(void* handle);
+extern "C" RT_API int32_t RtWriteParallelBZip2(void* data, int64_t size, void* handle);
+extern "C" RT_API int32_t RtFinishParallelBZip2(void* handle);
+extern "C" RT_API int32_t RtReadParallelBZip2(void* outChunk, int64_t outChunkSize, int64_t* have, int32_t wait, void* handle);
+
 
 #endif // CMAJOR_RT_COMPRESSION_INCLUDED
@@ -0,0 +1,617 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/rt/EventLoop.hpp>
+#include <cmajor/rt/Error.hpp>
+#include <cmajor/util/Error.hpp>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <Windows.h>
+#else
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace cmajor { namespace rt {
+
+using namespace cmajor::util;
+
+int64_t SteadyNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int NanosecsToWaitMillisecs(int64_t nanosecs)
+{
+    if (nanosecs < 0)
+    {
+        return -1;
+    }
+    int64_t millisecs = (nanosecs + 999999) / 1000000;
+    if (millisecs > INT32_MAX)
+    {
+        return INT32_MAX;
+    }
+    return static_cast<int>(millisecs);
+}
+
+struct Timer
+{
+    Timer() : due(0), period(0), userData(0) {}
+    Timer(int64_t due_, int64_t period_, int64_t userData_) : due(due_), period(period_), userData(userData_) {}
+    int64_t due;
+    int64_t period;
+    int64_t userData;
+};
+
+struct TimerEntry
+{
+    TimerEntry(int64_t due_, int32_t timerId_) : due(due_), timerId(timerId_) {}
+    int64_t due;
+    int32_t timerId;
+};
+
+inline bool operator>(const TimerEntry& left, const TimerEntry& right)
+{
+    return left.due > right.due;
+}
+
+#ifdef _WIN32
+
+struct Registration
+{
+    Registration() : socket(INVALID_SOCKET), events(SocketEvents::none), userData(0) {}
+    Registration(SOCKET socket_, SocketEvents events_, int64_t userData_) : socket(socket_), events(events_), userData(userData_) {}
+    SOCKET socket;
+    SocketEvents events;
+    int64_t userData;
+};
+
+#endif
+
+class EventLoop
+{
+public:
+    EventLoop();
+    ~EventLoop();
+    int32_t Open();
+    int32_t RegisterSocket(int32_t socketHandle, SocketEvents events, int64_t userData, bool modify);
+    int32_t UnregisterSocket(int32_t socketHandle);
+    int32_t AddTimer(int64_t delayNanosecs, int64_t periodNanosecs, int64_t userData);
+    int32_t CancelTimer(int32_t timerId);
+    int32_t WaitEvents(int64_t* userData, int32_t* events, int32_t maxEvents, int64_t timeoutNanosecs);
+private:
+    std::mutex mtx;
+    std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>> timerQueue;
+    std::unordered_map<int32_t, Timer> timers;
+    int32_t nextTimerId;
+#ifdef _WIN32
+    std::unordered_map<int32_t, Registration> registrations;
+    std::vector<WSAPOLLFD> pollFds;
+    std::vector<int32_t> pollHandles;
+#else
+    int epollFd;
+    std::vector<epoll_event> epollEvents;
+#endif
+    int64_t NextTimerDue();
+    int32_t CollectExpiredTimers(int64_t* userData, int32_t* events, int32_t count, int32_t maxEvents);
+};
+
+#ifdef _WIN32
+
+EventLoop::EventLoop() : nextTimerId(1)
+{
+}
+
+EventLoop::~EventLoop()
+{
+}
+
+int32_t EventLoop::Open()
+{
+    return 0;
+}
+
+int32_t EventLoop::RegisterSocket(int32_t socketHandle, SocketEvents events, int64_t userData, bool modify)
+{
+    int64_t nativeSocket = GetNativeSocket(socketHandle);
+    if (nativeSocket == -1)
+    {
+        return InstallError("invalid socket handle " + std::to_string(socketHandle));
+    }
+    if ((events & SocketEvents::edgeTriggered) != SocketEvents::none)
+    {
+        return InstallError("edge-triggered socket events not supported on Windows");
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = registrations.find(socketHandle);
+    if (modify && it == registrations.cend())
+    {
+        return InstallError("socket handle " + std::to_string(socketHandle) + " not registered");
+    }
+    else if (!modify && it != registrations.cend())
+    {
+        return InstallError("socket handle " + std::to_string(socketHandle) + " already registered");
+    }
+    registrations[socketHandle] = Registration(static_cast<SOCKET>(nativeSocket), events, userData);
+    return 0;
+}
+
+int32_t EventLoop::UnregisterSocket(int32_t socketHandle)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (registrations.erase(socketHandle) == 0)
+    {
+        return InstallError("socket handle " + std::to_string(socketHandle) + " not registered");
+    }
+    return 0;
+}
+
+#else
+
+EventLoop::EventLoop() : nextTimerId(1), epollFd(-1)
+{
+}
+
+EventLoop::~EventLoop()
+{
+    if (epollFd != -1)
+    {
+        close(epollFd);
+    }
+}
+
+int32_t EventLoop::Open()
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1)
+    {
+        return InstallError(std::string("epoll_create1 failed: ") + strerror(errno));
+    }
+    return 0;
+}
+
+uint32_t ToEpollEvents(SocketEvents events)
+{
+    uint32_t epollEvents = 0;
+    if ((events & SocketEvents::read) != SocketEvents::none)
+    {
+        epollEvents = epollEvents | EPOLLIN | EPOLLRDHUP;
+    }
+    if ((events & SocketEvents::write) != SocketEvents::none)
+    {
+        epollEvents = epollEvents | EPOLLOUT;
+    }
+    if ((events & SocketEvents::oneShot) != SocketEvents::none)
+    {
+        epollEvents = epollEvents | EPOLLONESHOT;
+    }
+    if ((events & SocketEvents::edgeTriggered) != SocketEvents::none)
+    {
+        epollEvents = epollEvents | EPOLLET;
+    }
+    return epollEvents;
+}
+
+SocketEvents FromEpollEvents(uint32_t epollEvents)
+{
+    SocketEvents events = SocketEvents::none;
+    if ((epollEvents & EPOLLIN) != 0)
+    {
+        events = events | SocketEvents::read;
+    }
+    if ((epollEvents & EPOLLOUT) != 0)
+    {
+        events = events | SocketEvents::write;
+    }
+    if ((epollEvents & EPOLLERR) != 0)
+    {
+        events = events | SocketEvents::error;
+    }
+    if ((epollEvents & (EPOLLHUP | EPOLLRDHUP)) != 0)
+    {
+        events = events | SocketEvents::hangup;
+    }
+    return events;
+}
+
+int32_t EventLoop::RegisterSocket(int32_t socketHandle, SocketEvents events, int64_t userData, bool modify)
+{
+    int64_t nativeSocket = GetNativeSocket(socketHandle);
+    if (nativeSocket == -1)
+    {
+        return InstallError("invalid socket handle " + std::to_string(socketHandle));
+    }
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = ToEpollEvents(events);
+    event.data.u64 = static_cast<uint64_t>(userData);
+    if (epoll_ctl(epollFd, modify ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, static_cast<int>(nativeSocket), &event) != 0)
+    {
+        return InstallError(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+    return 0;
+}
+
+int32_t EventLoop::UnregisterSocket(int32_t socketHandle)
+{
+    int64_t nativeSocket = GetNativeSocket(socketHandle);
+    if (nativeSocket == -1)
+    {
+        return InstallError("invalid socket handle " + std::to_string(socketHandle));
+    }
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    if (epoll_ctl(epollFd, EPOLL_CTL_DEL, static_cast<int>(nativeSocket), &event) != 0)
+    {
+        return InstallError(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+    return 0;
+}
+
+#endif
+
+int32_t EventLoop::AddTimer(int64_t delayNanosecs, int64_t periodNanosecs, int64_t userData)
+{
+    if (delayNanosecs < 0 || periodNanosecs < 0)
+    {
+        return InstallError("timer delay and period must be nonnegative");
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    int32_t timerId = nextTimerId++;
+    int64_t due = SteadyNow() + delayNanosecs;
+    timers[timerId] = Timer(due, periodNanosecs, userData);
+    timerQueue.push(TimerEntry(due, timerId));
+    return timerId;
+}
+
+int32_t EventLoop::CancelTimer(int32_t timerId)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (timers.erase(timerId) == 0)
+    {
+        return InstallError("invalid timer id " + std::to_string(timerId));
+    }
+    return 0;
+}
+
+int64_t EventLoop::NextTimerDue()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    while (!timerQueue.empty())
+    {
+        const TimerEntry& top = timerQueue.top();
+        auto it = timers.find(top.timerId);
+        if (it != timers.cend() && it->second.due == top.due)
+        {
+            return top.due;
+        }
+        timerQueue.pop();
+    }
+    return -1;
+}
+
+int32_t EventLoop::CollectExpiredTimers(int64_t* userData, int32_t* events, int32_t count, int32_t maxEvents)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    int64_t now = SteadyNow();
+    while (count < maxEvents && !timerQueue.empty() && timerQueue.top().due <= now)
+    {
+        TimerEntry entry = timerQueue.top();
+        timerQueue.pop();
+        auto it = timers.find(entry.timerId);
+        if (it == timers.cend() || it->second.due != entry.due)
+        {
+            continue;
+        }
+        Timer& timer = it->second;
+        userData[count] = timer.userData;
+        events[count] = int32_t(SocketEvents::timer);
+        ++count;
+        if (timer.period > 0)
+        {
+            timer.due = timer.due + timer.period;
+            if (timer.due <= now)
+            {
+                timer.due = now + timer.period;
+            }
+            timerQueue.push(TimerEntry(timer.due, entry.timerId));
+        }
+        else
+        {
+            timers.erase(it);
+        }
+    }
+    return count;
+}
+
+int32_t EventLoop::WaitEvents(int64_t* userData, int32_t* events, int32_t maxEvents, int64_t timeoutNanosecs)
+{
+    if (maxEvents <= 0)
+    {
+        return InstallError("maxEvents must be positive");
+    }
+    int64_t waitNanosecs = timeoutNanosecs;
+    int64_t nextDue = NextTimerDue();
+    if (nextDue != -1)
+    {
+        int64_t untilDue = std::max(nextDue - SteadyNow(), int64_t(0));
+        if (waitNanosecs < 0 || untilDue < waitNanosecs)
+        {
+            waitNanosecs = untilDue;
+        }
+    }
+    int waitMillisecs = NanosecsToWaitMillisecs(waitNanosecs);
+    int32_t count = 0;
+#ifdef _WIN32
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pollFds.clear();
+        pollHandles.clear();
+        for (const auto& p : registrations)
+        {
+            const Registration& registration = p.second;
+            if (registration.events == SocketEvents::none)
+            {
+                continue;
+            }
+            WSAPOLLFD fd;
+            fd.fd = registration.socket;
+            fd.events = 0;
+            fd.revents = 0;
+            if ((registration.events & SocketEvents::read) != SocketEvents::none)
+            {
+                fd.events = fd.events | POLLRDNORM;
+            }
+            if ((registration.events & SocketEvents::write) != SocketEvents::none)
+            {
+                fd.events = fd.events | POLLWRNORM;
+            }
+            pollFds.push_back(fd);
+            pollHandles.push_back(p.first);
+        }
+    }
+    if (pollFds.empty())
+    {
+        if (waitMillisecs < 0)
+        {
+            return InstallError("nothing to wait for: no sockets or timers registered");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(waitMillisecs));
+    }
+    else
+    {
+        int result = WSAPoll(pollFds.data(), static_cast<ULONG>(pollFds.size()), waitMillisecs);
+        if (result == SOCKET_ERROR)
+        {
+            return InstallError("WSAPoll failed with error code " + std::to_string(WSAGetLastError()));
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        for (std::size_t i = 0; i < pollFds.size() && count < maxEvents; ++i)
+        {
+            const WSAPOLLFD& fd = pollFds[i];
+            if (fd.revents == 0)
+            {
+                continue;
+            }
+            auto it = registrations.find(pollHandles[i]);
+            if (it == registrations.cend())
+            {
+                continue;
+            }
+            Registration& registration = it->second;
+            SocketEvents ready = SocketEvents::none;
+            if ((fd.revents & POLLRDNORM) != 0)
+            {
+                ready = ready | SocketEvents::read;
+            }
+            if ((fd.revents & POLLWRNORM) != 0)
+            {
+                ready = ready | SocketEvents::write;
+            }
+            if ((fd.revents & POLLERR) != 0)
+            {
+                ready = ready | SocketEvents::error;
+            }
+            if ((fd.revents & POLLHUP) != 0)
+            {
+                ready = ready | SocketEvents::hangup;
+            }
+            userData[count] = registration.userData;
+            events[count] = int32_t(ready);
+            ++count;
+            if ((registration.events & SocketEvents::oneShot) != SocketEvents::none)
+            {
+                registration.events = SocketEvents::none;
+            }
+        }
+    }
+#else
+    if (epollEvents.size() < static_cast<std::size_t>(maxEvents))
+    {
+        epollEvents.resize(maxEvents);
+    }
+    int result = epoll_wait(epollFd, epollEvents.data(), maxEvents, waitMillisecs);
+    if (result == -1)
+    {
+        if (errno != EINTR)
+        {
+            return InstallError(std::string("epoll_wait failed: ") + strerror(errno));
+        }
+        result = 0;
+    }
+    for (int i = 0; i < result; ++i)
+    {
+        const epoll_event& event = epollEvents[i];
+        userData[count] = static_cast<int64_t>(event.data.u64);
+        events[count] = int32_t(FromEpollEvents(event.events));
+        ++count;
+    }
+#endif
+    return CollectExpiredTimers(userData, events, count, maxEvents);
+}
+
+class EventLoopTable
+{
+public:
+    static void Init();
+    static void Done();
+    static EventLoopTable& Instance() { Assert(instance, "event loop table not initialized"); return *instance; }
+    int32_t CreateEventLoop();
+    int32_t DestroyEventLoop(int32_t eventLoopHandle);
+    std::shared_ptr<EventLoop> GetEventLoop(int32_t eventLoopHandle);
+private:
+    static std::unique_ptr<EventLoopTable> instance;
+    std::unordered_map<int32_t, std::shared_ptr<EventLoop>> eventLoopMap;
+    int32_t nextEventLoopHandle;
+    std::mutex mtx;
+    EventLoopTable();
+};
+
+std::unique_ptr<EventLoopTable> EventLoopTable::instance;
+
+void EventLoopTable::Init()
+{
+    instance.reset(new EventLoopTable());
+}
+
+void EventLoopTable::Done()
+{
+    instance.reset();
+}
+
+EventLoopTable::EventLoopTable() : nextEventLoopHandle(1)
+{
+}
+
+int32_t EventLoopTable::CreateEventLoop()
+{
+    std::shared_ptr<EventLoop> eventLoop(new EventLoop());
+    int32_t result = eventLoop->Open();
+    if (result < 0)
+    {
+        return result;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    int32_t eventLoopHandle = nextEventLoopHandle++;
+    eventLoopMap[eventLoopHandle] = std::move(eventLoop);
+    return eventLoopHandle;
+}
+
+int32_t EventLoopTable::DestroyEventLoop(int32_t eventLoopHandle)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (eventLoopMap.erase(eventLoopHandle) == 0)
+    {
+        return InstallError("invalid event loop handle " + std::to_string(eventLoopHandle));
+    }
+    return 0;
+}
+
+//  The returned pointer keeps the event loop alive while it is in use, even if RtDestroyEventLoop removes it from the table concurrently.
+
+std::shared_ptr<EventLoop> EventLoopTable::GetEventLoop(int32_t eventLoopHandle)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = eventLoopMap.find(eventLoopHandle);
+    if (it != eventLoopMap.cend())
+    {
+        return it->second;
+    }
+    return std::shared_ptr<EventLoop>();
+}
+
+void InitEventLoop()
+{
+    EventLoopTable::Init();
+}
+
+void DoneEventLoop()
+{
+    EventLoopTable::Done();
+}
+
+} }  // namespace cmajor::rt
+
+extern "C" RT_API int32_t RtCreateEventLoop()
+{
+    return cmajor::rt::EventLoopTable::Instance().CreateEventLoop();
+}
+
+extern "C" RT_API int32_t RtDestroyEventLoop(int32_t eventLoopHandle)
+{
+    return cmajor::rt::EventLoopTable::Instance().DestroyEventLoop(eventLoopHandle);
+}
+
+extern "C" RT_API int32_t RtRegisterSocket(int32_t eventLoopHandle, int32_t socketHandle, SocketEvents events, int64_t userData)
+{
+    std::shared_ptr<cmajor::rt::EventLoop> eventLoop = cmajor::rt::EventLoopTable::Instance().GetEventLoop(eventLoopHandle);
+    if (!eventLoop)
+    {
+        return cmajor::rt::InstallError("invalid event loop handle " + std::to_string(eventLoopHandle));
+    }
+    return eventLoop->RegisterSocket(socketHandle, events, userData, false);
+}
+
+extern "C" RT_API int32_t RtModifySocket(int32_t eventLoopHandle, int32_t socketHandle, SocketEvents events, int64_t userData)
+{
+    std::shared_ptr<cmajor::rt::EventLoop> eventLoop = cmajor::rt::EventLoopTable::Instance().GetEventLoop(eventLoopHandle);
+    if (!eventLoop)
+    {
+        return cmajor::rt::InstallError("invalid event loop handle " + std::to_string(eventLoopHandle));
+    }
+    return eventLoop->RegisterSocket(socketHandle, events, userData, true);
+}
+
+extern "C" RT_API int32_t RtUnregisterSocket(int32_t eventLoopHandle, int32_t socketHandle)
+{
+    std::shared_ptr<cmajor::rt::EventLoop> eventLoop = cmajor::rt::EventLoopTable::Instance().GetEventLoop(eventLoopHandle);
+    if (!eventLoop)
+    {
+        return cmajor::rt::InstallError("invalid event loop handle " + std::to_string(eventLoopHandle));
+    }
+    return eventLoop->UnregisterSocket(socketHandle);
+}
+
+extern "C" RT_API int32_t RtAddTimer(int32_t eventLoopHandle, int64_t delayNanosecs, int64_t periodNanosecs, int64_t userData)
+{
+    std::shared_ptr<cmajor::rt::EventLoop> eventLoop = cmajor::rt::EventLoopTable::Instance().GetEventLoop(eventLoopHandle);
+    if (!eventLoop)
+    {
+        return cmajor::rt::InstallError("invalid event loop handle " + std::to_string(eventLoopHandle));
+    }
+    return eventLoop->AddTimer(delayNanosecs, periodNanosecs, userData);
+}
+
+extern "C" RT_API int32_t RtCancelTimer(int32_t eventLoopHandle, int32_t timerId)
+{
+    std::shared_ptr<cmajor::rt::EventLoop> eventLoop = cmajor::rt::EventLoopTable::Instance().GetEventLoop(eventLoopHandle);
+    if (!eventLoop)
+    {
+        return cmajor::rt::InstallError("invalid event loop handle " + std::to_string(eventLoopHandle));
+    }
+    return eventLoop->CancelTimer(timerId);
+}
+
+extern "C" RT_API int32_t RtWaitEvents(int32_t eventLoopHandle, int64_t* userData, int32_t* events, int32_t maxEvents, int64_t timeoutNanosecs)
+{
+    std::shared_ptr<cmajor::rt::EventLoop> eventLoop = cmajor::rt::EventLoopTable::Instance().GetEventLoop(eventLoopHandle);
+    if (!eventLoop)
+    {
+        return cmajor::rt::InstallError("invalid event loop handle " + std::to_string(eventLoopHandle));
+    }
+    return eventLoop->WaitEvents(userData, events, maxEvents, timeoutNanosecs);
+}
@@ -0,0 +1,34 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#ifndef CMAJOR_RT_EVENT_LOOP_INCLUDED
+#define CMAJOR_RT_EVENT_LOOP_INCLUDED
+#include <cmajor/rt/RtApi.hpp>
+#include <cmajor/rt/Socket.hpp>
+#include <stdint.h>
+
+// An event loop multiplexes readiness of non-blocking sockets and expiration of timers.
+// On Linux it is backed by epoll, on Windows by WSAPoll.
+// Edge-triggered registrations are supported only by the epoll backend; on Windows registering a socket with SocketEvents::edgeTriggered fails.
+// RtWaitEvents fills userData[i] and events[i] for at most maxEvents ready sockets and expired timers and returns their count.
+// A negative timeout waits indefinitely.
+
+extern "C" RT_API int32_t RtCreateEventLoop();
+extern "C" RT_API int32_t RtDestroyEventLoop(int32_t eventLoopHandle);
+extern "C" RT_API int32_t RtRegisterSocket(int32_t eventLoopHandle, int32_t socketHandle, SocketEvents events, int64_t userData);
+extern "C" RT_API int32_t RtModifySocket(int32_t eventLoopHandle, int32_t socketHandle, SocketEvents events, int64_t userData);
+extern "C" RT_API int32_t RtUnregisterSocket(int32_t eventLoopHandle, int32_t socketHandle);
+extern "C" RT_API int32_t RtAddTimer(int32_t eventLoopHandle, int64_t delayNanosecs, int64_t periodNanosecs, int64_t userData);
+extern "C" RT_API int32_t RtCancelTimer(int32_t eventLoopHandle, int32_t timerId);
+extern "C" RT_API int32_t RtWaitEvents(int32_t eventLoopHandle, int64_t* userData, int32_t* events, int32_t maxEvents, int64_t timeoutNanosecs);
+
+namespace cmajor { namespace rt {
+
+void InitEventLoop();
+void DoneEventLoop();
+
+} }  // namespace cmajor::rt
+
+#endif // CMAJOR_RT_EVENT_LOOP_INCLUDED
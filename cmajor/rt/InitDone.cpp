@@ -22,6 +22,7 @@
 #include <cmajor/rt/CommandLine.hpp>
 #endif
 #include <cmajor/rt/Socket.hpp>
+#include <cmajor/rt/EventLoop.hpp>
 #include <cmajor/rt/Environment.hpp>
 #include <csignal>
 
@@ -61,6 +62,7 @@ void Init(int64_t numberOfPolymorphicClassIds, const uint64_t* polymorphicClassI
     InitConditionVariable();
     InitThread();
     InitSocket();
+    InitEventLoop();
     InitEnvironment();
     InitStatics();
     InitClasses(numberOfPolymorphicClassIds, polymorphicClassIdArray, numberOfStaticClassIds, staticClassIdArray);
@@ -77,6 +79,7 @@ void Done()
     DoneClasses();
     DoneStatics();
     DoneEnvironment();
+    DoneEventLoop();
     DoneSocket();
     DoneThread();
     DoneConditionVariable();
@@ -8,20 +8,125 @@
 #include <cmajor/util/Error.hpp>
 #include <cmajor/util/Unicode.hpp>
 #include <boost/filesystem.hpp>
+#include <algorithm>
 #include <atomic>
 #include <mutex>
+#include <unordered_map>
 #ifdef _WIN32
 #include <io.h>
 #include <fcntl.h>
+#include <Windows.h>
 #else 
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
 #endif
 
 namespace cmajor { namespace rt {
 
 using namespace cmajor::unicode;
 
+// Converts UTF-8 console output to UTF-16 without allocating: complete code points are encoded to a fixed buffer that is flushed when full.
+
+class Utf16ConsoleWriter
+{
+public:
+    Utf16ConsoleWriter();
+    void Write(FILE* file, const uint8_t* buffer, int64_t count);
+    void Flush(FILE* file);
+    std::mutex& Mtx() { return mtx; }
+private:
+    static const int bufferSize = 1024;
+    Utf8ToUtf32Engine engine;
+    char16_t buffer[bufferSize];
+    int bufferCount;
+    std::mutex mtx;
+};
+
+Utf16ConsoleWriter::Utf16ConsoleWriter() : engine(), bufferCount(0)
+{
+}
+
+void Utf16ConsoleWriter::Write(FILE* file, const uint8_t* buffer, int64_t count)
+{
+    const uint8_t* e = buffer + count;
+    for (const uint8_t* p = buffer; p != e; ++p)
+    {
+        engine.Put(*p);
+        if (engine.ResulReady())
+        {
+            uint32_t u = static_cast<uint32_t>(engine.Result());
+            if (u > 0x10FFFFu)
+            {
+                throw UnicodeException("invalid UTF-32 code point");
+            }
+            if (bufferCount > bufferSize - 2)
+            {
+                Flush(file);
+            }
+            if (u < 0x10000u)
+            {
+                if (u >= 0xD800u && u <= 0xDFFFu)
+                {
+                    throw UnicodeException("invalid UTF-32 code point (reserved for UTF-16)");
+                }
+                this->buffer[bufferCount++] = static_cast<char16_t>(u);
+            }
+            else
+            {
+                uint32_t uprime = u - 0x10000u;
+                this->buffer[bufferCount++] = static_cast<char16_t>(0xD800u | (uprime >> 10u));
+                this->buffer[bufferCount++] = static_cast<char16_t>(0xDC00u | (uprime & 0x3FFu));
+            }
+        }
+    }
+}
+
+void Utf16ConsoleWriter::Flush(FILE* file)
+{
+    if (bufferCount > 0)
+    {
+        int count = bufferCount;
+        bufferCount = 0;
+        if (int(std::fwrite(buffer, sizeof(char16_t), count, file)) != count)
+        {
+            throw FileSystemError(std::string("could not write to console: ") + strerror(errno));
+        }
+    }
+}
+
+// Locks a stream for a sequence of writes so that they are not interleaved with writes of other threads.
+
+class FileLock
+{
+public:
+    FileLock(FILE* file_) : file(file_)
+    {
+#ifdef _WIN32
+        _lock_file(file);
+#else
+        flockfile(file);
+#endif
+    }
+    ~FileLock()
+    {
+#ifdef _WIN32
+        _unlock_file(file);
+#else
+        funlockfile(file);
+#endif
+    }
+private:
+    FILE* file;
+};
+
+// File handles index a two-level table: a fixed array of segment pointers and segments of file entries allocated on demand.
+// Segments are never freed or moved while the table exists, so looking up a handle needs no lock.
+
 class FileTable
 {
 public:
@@ -32,6 +137,7 @@ public:
     int32_t OpenFile(const char* filePath, OpenMode openMode);
     void CloseFile(int32_t fileHandle);
     void WriteFile(int32_t fileHandle, const uint8_t* buffer, int64_t count);
+    void WriteFileV(int32_t fileHandle, const uint8_t** buffers, const int64_t* counts, int32_t bufferCount);
     void WriteByte(int32_t fileHandle, int8_t x);
     int64_t ReadFile(int32_t fileHandle, uint8_t* buffer, int64_t bufferSize);
     int32_t ReadByte(int32_t fileHandle);
@@ -40,21 +146,33 @@ public:
     void FlushStdoutAndStderr();
 private:
     static std::unique_ptr<FileTable> instance;
-    const int32_t maxNoLockFileHandles = 256;
-    std::vector<FILE*> files;
-    std::vector<std::string> filePaths;
-    std::unordered_map<int32_t, FILE*> fileMap;
-    std::unordered_map<int32_t, std::string> filePathMap;
-    Utf8ToUtf32Engine stdoutUtf8ToUtf32Engine;
-    Utf8ToUtf32Engine stderrUtf8ToUtf32Engine;
+    static const int32_t segmentShift = 10;
+    static const int32_t segmentSize = 1 << segmentShift;
+    static const int32_t maxSegments = 4096;
+    struct FileEntry
+    {
+        FileEntry() : file(nullptr) {}
+        std::atomic<FILE*> file;
+        std::string filePath;
+    };
+    struct Segment
+    {
+        FileEntry entries[segmentSize];
+    };
+    std::atomic<Segment*> segments[maxSegments];
+    Utf16ConsoleWriter stdoutWriter;
+    Utf16ConsoleWriter stderrWriter;
     std::atomic<int32_t> nextFileHandle;
     std::atomic<int32_t> nextLineId;
-    std::mutex mtx;
     bool stdinInUtf16Mode;
     std::string stdinBuf;
     bool stdoutInUtf16Mode;
     bool stderrInUtf16Mode;
     FileTable();
+    FileEntry* GetEntry(int32_t fileHandle, bool create);
+    FILE* GetFile(int32_t fileHandle);
+    std::string GetFilePath(int32_t fileHandle);
+    Utf16ConsoleWriter* GetConsoleWriter(int32_t fileHandle);
 };
 
 std::unique_ptr<FileTable> FileTable::instance;
@@ -69,13 +187,15 @@ void FileTable::Done()
     instance.reset();
 }
 
-FileTable::FileTable() : stdinInUtf16Mode(false), stdoutInUtf16Mode(false), stderrInUtf16Mode(false), nextFileHandle(3), nextLineId(1)
+FileTable::FileTable() : nextFileHandle(3), nextLineId(1), stdinInUtf16Mode(false), stdoutInUtf16Mode(false), stderrInUtf16Mode(false)
 {
-    files.resize(maxNoLockFileHandles);
-    filePaths.resize(maxNoLockFileHandles);
-    files[0] = stdin;
-    files[1] = stdout;
-    files[2] = stderr;
+    for (int32_t i = 0; i < maxSegments; ++i)
+    {
+        segments[i].store(nullptr, std::memory_order_relaxed);
+    }
+    GetEntry(0, true)->file.store(stdin, std::memory_order_release);
+    GetEntry(1, true)->file.store(stdout, std::memory_order_release);
+    GetEntry(2, true)->file.store(stderr, std::memory_order_release);
     std::fflush(stdout);
     std::fflush(stderr);
 #ifdef _WIN32
@@ -115,6 +235,83 @@ FileTable::~FileTable()
         _setmode(2, _O_TEXT);
     }
 #endif
+    for (int32_t i = 0; i < maxSegments; ++i)
+    {
+        delete segments[i].load(std::memory_order_acquire);
+    }
+}
+
+FileTable::FileEntry* FileTable::GetEntry(int32_t fileHandle, bool create)
+{
+    int32_t segmentIndex = fileHandle >> segmentShift;
+    if (segmentIndex >= maxSegments)
+    {
+        if (create)
+        {
+            throw FileSystemError("too many file handles");
+        }
+        return nullptr;
+    }
+    Segment* segment = segments[segmentIndex].load(std::memory_order_acquire);
+    if (!segment)
+    {
+        if (!create)
+        {
+            return nullptr;
+        }
+        Segment* newSegment = new Segment();
+        if (segments[segmentIndex].compare_exchange_strong(segment, newSegment, std::memory_order_acq_rel))
+        {
+            segment = newSegment;
+        }
+        else
+        {
+            delete newSegment;
+        }
+    }
+    return &segment->entries[fileHandle & (segmentSize - 1)];
+}
+
+FILE* FileTable::GetFile(int32_t fileHandle)
+{
+    if (fileHandle < 0)
+    {
+        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
+    }
+    FileEntry* entry = GetEntry(fileHandle, false);
+    FILE* file = nullptr;
+    if (entry)
+    {
+        file = entry->file.load(std::memory_order_acquire);
+    }
+    if (!file)
+    {
+        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
+    }
+    return file;
+}
+
+std::string FileTable::GetFilePath(int32_t fileHandle)
+{
+    FileEntry* entry = GetEntry(fileHandle, false);
+    if (entry)
+    {
+        return entry->filePath;
+    }
+    return std::string();
+}
+
+Utf16ConsoleWriter* FileTable::GetConsoleWriter(int32_t fileHandle)
+{
+    if (fileHandle == 1 && stdoutInUtf16Mode)
+    {
+        return &stdoutWriter;
+    }
+    else if (fileHandle == 2 && stderrInUtf16Mode)
+    {
+        return &stderrWriter;
+    }
+    return nullptr;
 }
 
 int32_t FileTable::OpenFile(const char* filePath, OpenMode openMode)
@@ -175,44 +372,32 @@ int32_t FileTable::OpenFile(const char* filePath, OpenMode openMode)
         throw FileSystemError("could not open file '" + std::string(filePath) + "': " + strerror(errno));
     }
     int32_t fileHandle = nextFileHandle++;
-    if (fileHandle < maxNoLockFileHandles)
+    FileEntry* entry = nullptr;
+    try
     {
-        files[fileHandle] = file;
-        filePaths[fileHandle] = filePath;
+        entry = GetEntry(fileHandle, true);
     }
-    else
+    catch (...)
     {
-        std::lock_guard<std::mutex> lock(mtx);
-        fileMap[fileHandle] = file;
-        filePathMap[fileHandle] = filePath;
+        std::fclose(file);
+        throw;
     }
+    entry->filePath = filePath;
+    entry->file.store(file, std::memory_order_release);
     return fileHandle;
 }
 
 void FileTable::CloseFile(int32_t fileHandle)
 {
-    FILE* file = nullptr;
-    std::string filePath;
     if (fileHandle < 0)
     {
         throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
     }
-    else if (fileHandle < maxNoLockFileHandles)
-    {
-        file = files[fileHandle];
-    }
-    else
+    FileEntry* entry = GetEntry(fileHandle, false);
+    FILE* file = nullptr;
+    if (entry)
     {
-        std::lock_guard<std::mutex> lock(mtx);
-        auto it = fileMap.find(fileHandle);
-        if (it != fileMap.cend())
-        {
-            file = it->second;
-        }
-        else
-        {
-            throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-        }
+        file = entry->file.exchange(nullptr, std::memory_order_acq_rel);
     }
     if (!file)
     {
@@ -221,189 +406,75 @@ void FileTable::CloseFile(int32_t fileHandle)
     int result = fclose(file);
     if (result != 0)
     {
-        std::string filePath;
-        if (fileHandle < maxNoLockFileHandles)
-        {
-            filePath = filePaths[fileHandle];
-        }
-        else
-        {
-            filePath = filePathMap[fileHandle];
-        }
-        throw FileSystemError("could not close file '" + filePath + "': " + strerror(errno));
+        throw FileSystemError("could not close file '" + entry->filePath + "': " + strerror(errno));
     }
 }
 
 void FileTable::WriteFile(int32_t fileHandle, const uint8_t* buffer, int64_t count)
 {
-    FILE* file = nullptr;
-    if (fileHandle < 0)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
-    else if (fileHandle < maxNoLockFileHandles)
+    FILE* file = GetFile(fileHandle);
+    Utf16ConsoleWriter* consoleWriter = GetConsoleWriter(fileHandle);
+    if (consoleWriter)
     {
-        file = files[fileHandle];
+        std::lock_guard<std::mutex> lock(consoleWriter->Mtx());
+        consoleWriter->Write(file, buffer, count);
+        consoleWriter->Flush(file);
     }
     else
     {
-        std::lock_guard<std::mutex> lock(mtx);
-        auto it = fileMap.find(fileHandle);
-        if (it != fileMap.cend())
-        {
-            file = it->second;
-        }
-        else
+        int64_t result = int64_t(std::fwrite(buffer, 1, count, file));
+        if (result != count)
         {
-            throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
+            throw FileSystemError("could not write to '" + GetFilePath(fileHandle) + "': " + strerror(errno));
         }
     }
-    if (!file)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
-    int32_t result = 0;
-    if (fileHandle == 1 && stdoutInUtf16Mode || fileHandle == 2 && stderrInUtf16Mode)
+}
+
+void FileTable::WriteFileV(int32_t fileHandle, const uint8_t** buffers, const int64_t* counts, int32_t bufferCount)
+{
+    FILE* file = GetFile(fileHandle);
+    Utf16ConsoleWriter* consoleWriter = GetConsoleWriter(fileHandle);
+    if (consoleWriter)
     {
-        std::u32string utf32Chars;
-        Utf8ToUtf32Engine* engine = nullptr;
-        if (fileHandle == 1)
-        {
-            engine = &stdoutUtf8ToUtf32Engine;
-        }
-        else if (fileHandle == 2)
-        {
-            engine = &stderrUtf8ToUtf32Engine;
-        }
-        else
-        {
-            throw std::runtime_error("internal error: unicode conversion engine not set");
-        }
-        const uint8_t* e = buffer + count;
-        for (const uint8_t* p = buffer; p != e; ++p)
-        {
-            engine->Put(*p);
-            if (engine->ResulReady())
-            {
-                utf32Chars.append(1, engine->Result());
-            }
-        }
-        std::u16string utf16Chars(ToUtf16(utf32Chars));
-        if (!utf16Chars.empty())
-        {
-            result = int32_t(std::fwrite(utf16Chars.c_str(), sizeof(char16_t), utf16Chars.length(), file));
-            count = utf16Chars.length();
-        }
-        else
+        std::lock_guard<std::mutex> lock(consoleWriter->Mtx());
+        for (int32_t i = 0; i < bufferCount; ++i)
         {
-            result = 0;
-            count = 0;
+            consoleWriter->Write(file, buffers[i], counts[i]);
         }
+        consoleWriter->Flush(file);
     }
     else
     {
-        result = int32_t(std::fwrite(buffer, 1, count, file));
-    }
-    if (result != count)
-    {
-        std::string filePath;
-        if (fileHandle < maxNoLockFileHandles)
-        {
-            filePath = filePaths[fileHandle];
-        }
-        else
+        FileLock lock(file);
+        for (int32_t i = 0; i < bufferCount; ++i)
         {
-            filePath = filePathMap[fileHandle];
+            int64_t result = int64_t(std::fwrite(buffers[i], 1, counts[i], file));
+            if (result != counts[i])
+            {
+                throw FileSystemError("could not write to '" + GetFilePath(fileHandle) + "': " + strerror(errno));
+            }
         }
-        throw FileSystemError("could not write to '" + filePath + "': " + strerror(errno));
     }
 }
 
 void FileTable::WriteByte(int32_t fileHandle, int8_t x)
 {
-    FILE* file = nullptr;
-    if (fileHandle < 0)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
-    else if (fileHandle < maxNoLockFileHandles)
-    {
-        file = files[fileHandle];
-    }
-    else
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        auto it = fileMap.find(fileHandle);
-        if (it != fileMap.cend())
-        {
-            file = it->second;
-        }
-        else
-        {
-            throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-        }
-    }
-    if (!file)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
-    int32_t result = 0;
-    if (fileHandle == 1 && stdoutInUtf16Mode || fileHandle == 2 && stderrInUtf16Mode)
+    FILE* file = GetFile(fileHandle);
+    Utf16ConsoleWriter* consoleWriter = GetConsoleWriter(fileHandle);
+    if (consoleWriter)
     {
-        std::u32string utf32Chars;
-        Utf8ToUtf32Engine* engine = nullptr;
-        if (fileHandle == 1)
-        {
-            engine = &stdoutUtf8ToUtf32Engine;
-        }
-        else if (fileHandle == 2)
-        {
-            engine = &stderrUtf8ToUtf32Engine;
-        }
-        else
-        {
-            throw std::runtime_error("internal error: unicode conversion engine not set");
-        }
-        engine->Put(x);
-        if (engine->ResulReady())
-        {
-            utf32Chars.append(1, engine->Result());
-        }
-        if (!utf32Chars.empty())
-        {
-            std::u16string utf16Chars(ToUtf16(utf32Chars));
-            result = int32_t(std::fwrite(utf16Chars.c_str(), sizeof(char16_t), utf16Chars.length(), file));
-            if (result != utf16Chars.length())
-            {
-                std::string filePath;
-                if (fileHandle < maxNoLockFileHandles)
-                {
-                    filePath = filePaths[fileHandle];
-                }
-                else
-                {
-                    filePath = filePathMap[fileHandle];
-                }
-                throw FileSystemError("could not write to '" + filePath + "': " + strerror(errno));
-            }
-        }
+        std::lock_guard<std::mutex> lock(consoleWriter->Mtx());
+        uint8_t b = static_cast<uint8_t>(x);
+        consoleWriter->Write(file, &b, 1);
+        consoleWriter->Flush(file);
     }
     else
     {
-        result = std::fputc(x, file);
-    }
-    if (result == EOF)
-    {
-        std::string filePath;
-        if (fileHandle < maxNoLockFileHandles)
-        {
-            filePath = filePaths[fileHandle];
-        }
-        else
+        int32_t result = std::fputc(x, file);
+        if (result == EOF)
         {
-            filePath = filePathMap[fileHandle];
+            throw FileSystemError("could not write to '" + GetFilePath(fileHandle) + "': " + strerror(errno));
         }
-        throw FileSystemError("could not write to '" + filePath + "': " + strerror(errno));
     }
 }
 
@@ -413,32 +484,7 @@ int64_t FileTable::ReadFile(int32_t fileHandle, uint8_t* buffer, int64_t bufferS
     {
         FlushStdoutAndStderr();
     }
-    FILE* file = nullptr;
-    if (fileHandle < 0)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
-    else if (fileHandle < maxNoLockFileHandles)
-    {
-        file = files[fileHandle];
-    }
-    else
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        auto it = fileMap.find(fileHandle);
-        if (it != fileMap.cend())
-        {
-            file = it->second;
-        }
-        else
-        {
-            throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-        }
-    }
-    if (!file)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
+    FILE* file = GetFile(fileHandle);
     int64_t result = 0;
     int64_t count = 0;
     if (fileHandle == 0 && stdinInUtf16Mode)
@@ -478,16 +524,7 @@ int64_t FileTable::ReadFile(int32_t fileHandle, uint8_t* buffer, int64_t bufferS
     {
         if (std::ferror(file) != 0)
         {
-            std::string filePath;
-            if (fileHandle < maxNoLockFileHandles)
-            {
-                filePath = filePaths[fileHandle];
-            }
-            else
-            {
-                filePath = filePathMap[fileHandle];
-            }
-            throw FileSystemError("could not read from '" + filePath + "': " + strerror(errno));
+            throw FileSystemError("could not read from '" + GetFilePath(fileHandle) + "': " + strerror(errno));
         }
     }
     return result;
@@ -499,32 +536,7 @@ int32_t FileTable::ReadByte(int32_t fileHandle)
     {
         FlushStdoutAndStderr();
     }
-    FILE* file = nullptr;
-    if (fileHandle < 0)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
-    else if (fileHandle < maxNoLockFileHandles)
-    {
-        file = files[fileHandle];
-    }
-    else
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        auto it = fileMap.find(fileHandle);
-        if (it != fileMap.cend())
-        {
-            file = it->second;
-        }
-        else
-        {
-            throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-        }
-    }
-    if (!file)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
+    FILE* file = GetFile(fileHandle);
     int32_t result = 0; 
     if (fileHandle == 0 && stdinInUtf16Mode)
     {
@@ -535,16 +547,7 @@ int32_t FileTable::ReadByte(int32_t fileHandle)
             {
                 if (std::ferror(file) != 0)
                 {
-                    std::string filePath;
-                    if (fileHandle < maxNoLockFileHandles)
-                    {
-                        filePath = filePaths[fileHandle];
-                    }
-                    else
-                    {
-                        filePath = filePathMap[fileHandle];
-                    }
-                    throw FileSystemError("could not read from '" + filePath + "': " + strerror(errno));
+                    throw FileSystemError("could not read from '" + GetFilePath(fileHandle) + "': " + strerror(errno));
                 }
                 else
                 {
@@ -571,16 +574,7 @@ int32_t FileTable::ReadByte(int32_t fileHandle)
         {
             if (std::ferror(file) != 0)
             {
-                std::string filePath;
-                if (fileHandle < maxNoLockFileHandles)
-                {
-                    filePath = filePaths[fileHandle];
-                }
-                else
-                {
-                    filePath = filePathMap[fileHandle];
-                }
-                throw FileSystemError("could not read from '" + filePath + "': " + strerror(errno));
+                throw FileSystemError("could not read from '" + GetFilePath(fileHandle) + "': " + strerror(errno));
             }
             else
             {
@@ -593,34 +587,9 @@ int32_t FileTable::ReadByte(int32_t fileHandle)
 
 void FileTable::SeekFile(int32_t fileHandle, int64_t pos, Origin origin)
 {
-    FILE* file = nullptr;
-    if (fileHandle < 0)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
-    else if (fileHandle < maxNoLockFileHandles)
-    {
-        file = files[fileHandle];
-    }
-    else
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        auto it = fileMap.find(fileHandle);
-        if (it != fileMap.cend())
-        {
-            file = it->second;
-        }
-        else
-        {
-            throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-        }
-    }
-    if (!file)
-    {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
-    }
-    int o = 0;
-    switch (origin)
+    FILE* file = GetFile(fileHandle);
+    int o = 0;
+    switch (origin)
     {
         case Origin::seekSet: o = SEEK_SET; break;
         case Origin::seekCur: o = SEEK_CUR; break;
@@ -633,72 +602,445 @@ void FileTable::SeekFile(int32_t fileHandle, int64_t pos, Origin origin)
 #endif
     if (result != 0)
     {
-        std::string filePath;
-        if (fileHandle < maxNoLockFileHandles)
-        {
-            filePath = filePaths[fileHandle];
-        }
-        else
-        {
-            filePath = filePathMap[fileHandle];
-        }
-        throw FileSystemError("could not seek '" + filePath + "': " + strerror(errno));
+        throw FileSystemError("could not seek '" + GetFilePath(fileHandle) + "': " + strerror(errno));
     }
 }
 
 int64_t FileTable::TellFile(int32_t fileHandle)
 {
-    FILE* file = nullptr;
-    if (fileHandle < 0)
+    FILE* file = GetFile(fileHandle);
+#ifdef _WIN32
+    int64_t result = _ftelli64(file);
+#else
+    int64_t result = ftell(file);
+#endif
+    if (result == -1)
     {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
+        throw FileSystemError("could not tell file position of  '" + GetFilePath(fileHandle) + "': " + strerror(errno));
     }
-    else if (fileHandle < maxNoLockFileHandles)
+    return result;
+}
+
+void FileTable::FlushStdoutAndStderr()
+{
+    std::fflush(stdout);
+    std::fflush(stderr);
+}
+
+struct Mapping
+{
+    Mapping() : data(nullptr), size(0), access(MapAccess::readOnly)
+#ifdef _WIN32
+        , fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL)
+#else
+        , fd(-1)
+#endif
     {
-        file = files[fileHandle];
     }
-    else
+    uint8_t* data;
+    int64_t size;
+    MapAccess access;
+    std::string filePath;
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#else
+    int fd;
+#endif
+};
+
+#ifdef _WIN32
+
+std::string GetLastWindowsErrorMessage()
+{
+    char buf[1024];
+    FormatMessageA(FORMAT_MESSAGE_FROM_SYSTEM, NULL, GetLastError(), 0, buf, sizeof(buf), NULL);
+    return std::string(buf);
+}
+
+void OpenMapping(Mapping& mapping, int64_t requestedSize)
+{
+    bool readWrite = mapping.access == MapAccess::readWrite;
+    mapping.fileHandle = CreateFileA(mapping.filePath.c_str(), readWrite ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, NULL,
+        readWrite ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mapping.fileHandle == INVALID_HANDLE_VALUE)
+    {
+        throw FileSystemError("could not open file '" + mapping.filePath + "' for mapping: " + GetLastWindowsErrorMessage());
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(mapping.fileHandle, &fileSize))
+    {
+        CloseHandle(mapping.fileHandle);
+        throw FileSystemError("could not get size of file '" + mapping.filePath + "': " + GetLastWindowsErrorMessage());
+    }
+    mapping.size = fileSize.QuadPart;
+    if (readWrite && requestedSize > mapping.size)
+    {
+        mapping.size = requestedSize;
+    }
+    if (mapping.size == 0)
+    {
+        return;
+    }
+    LARGE_INTEGER mappingSize;
+    mappingSize.QuadPart = mapping.size;
+    mapping.mappingHandle = CreateFileMappingA(mapping.fileHandle, NULL, readWrite ? PAGE_READWRITE : PAGE_READONLY, mappingSize.HighPart, mappingSize.LowPart, NULL);
+    if (mapping.mappingHandle == NULL)
+    {
+        CloseHandle(mapping.fileHandle);
+        throw FileSystemError("could not create mapping for file '" + mapping.filePath + "': " + GetLastWindowsErrorMessage());
+    }
+    mapping.data = static_cast<uint8_t*>(MapViewOfFile(mapping.mappingHandle, readWrite ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+    if (!mapping.data)
+    {
+        CloseHandle(mapping.mappingHandle);
+        CloseHandle(mapping.fileHandle);
+        throw FileSystemError("could not map file '" + mapping.filePath + "': " + GetLastWindowsErrorMessage());
+    }
+}
+
+void CloseMapping(Mapping& mapping)
+{
+    if (mapping.data)
+    {
+        UnmapViewOfFile(mapping.data);
+    }
+    if (mapping.mappingHandle != NULL)
+    {
+        CloseHandle(mapping.mappingHandle);
+    }
+    if (mapping.fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(mapping.fileHandle);
+    }
+}
+
+void AdviseMapping(Mapping& mapping, int64_t offset, int64_t length, AccessAdvice advice)
+{
+    if (advice == AccessAdvice::willNeed && mapping.data)
     {
-        std::lock_guard<std::mutex> lock(mtx);
-        auto it = fileMap.find(fileHandle);
-        if (it != fileMap.cend())
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = mapping.data + offset;
+        range.NumberOfBytes = static_cast<SIZE_T>(length);
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+}
+
+void FlushMapping(Mapping& mapping)
+{
+    if (mapping.data && mapping.access == MapAccess::readWrite)
+    {
+        if (!FlushViewOfFile(mapping.data, 0) || !FlushFileBuffers(mapping.fileHandle))
         {
-            file = it->second;
+            throw FileSystemError("could not flush mapped file '" + mapping.filePath + "': " + GetLastWindowsErrorMessage());
         }
-        else
+    }
+}
+
+#else
+
+void OpenMapping(Mapping& mapping, int64_t requestedSize)
+{
+    bool readWrite = mapping.access == MapAccess::readWrite;
+    mapping.fd = open(mapping.filePath.c_str(), readWrite ? (O_RDWR | O_CREAT) : O_RDONLY, 0666);
+    if (mapping.fd == -1)
+    {
+        throw FileSystemError("could not open file '" + mapping.filePath + "' for mapping: " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(mapping.fd, &st) == -1)
+    {
+        std::string errorMessage = strerror(errno);
+        close(mapping.fd);
+        throw FileSystemError("could not get size of file '" + mapping.filePath + "': " + errorMessage);
+    }
+    mapping.size = st.st_size;
+    if (readWrite && requestedSize > mapping.size)
+    {
+        if (ftruncate(mapping.fd, requestedSize) == -1)
         {
-            throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
+            std::string errorMessage = strerror(errno);
+            close(mapping.fd);
+            throw FileSystemError("could not extend file '" + mapping.filePath + "': " + errorMessage);
         }
+        mapping.size = requestedSize;
     }
-    if (!file)
+    if (mapping.size == 0)
     {
-        throw FileSystemError("invalid file handle " + std::to_string(fileHandle));
+        return;
     }
-#ifdef _WIN32
-    int64_t result = _ftelli64(file);
-#else
-    int64_t result = ftell(file);
+    void* data = mmap(nullptr, mapping.size, readWrite ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, mapping.fd, 0);
+    if (data == MAP_FAILED)
+    {
+        std::string errorMessage = strerror(errno);
+        close(mapping.fd);
+        throw FileSystemError("could not map file '" + mapping.filePath + "': " + errorMessage);
+    }
+    mapping.data = static_cast<uint8_t*>(data);
+}
+
+void CloseMapping(Mapping& mapping)
+{
+    if (mapping.data)
+    {
+        munmap(mapping.data, mapping.size);
+    }
+    if (mapping.fd != -1)
+    {
+        close(mapping.fd);
+    }
+}
+
+void AdviseMapping(Mapping& mapping, int64_t offset, int64_t length, AccessAdvice advice)
+{
+    if (!mapping.data)
+    {
+        return;
+    }
+    int adv = MADV_NORMAL;
+    switch (advice)
+    {
+        case AccessAdvice::normal: adv = MADV_NORMAL; break;
+        case AccessAdvice::sequential: adv = MADV_SEQUENTIAL; break;
+        case AccessAdvice::random: adv = MADV_RANDOM; break;
+        case AccessAdvice::willNeed: adv = MADV_WILLNEED; break;
+        case AccessAdvice::dontNeed: adv = MADV_DONTNEED; break;
+    }
+    int64_t pageSize = sysconf(_SC_PAGESIZE);
+    int64_t start = (offset / pageSize) * pageSize;
+    if (madvise(mapping.data + start, length + (offset - start), adv) == -1)
+    {
+        throw FileSystemError("could not advise mapped file '" + mapping.filePath + "': " + strerror(errno));
+    }
+}
+
+void FlushMapping(Mapping& mapping)
+{
+    if (mapping.data && mapping.access == MapAccess::readWrite)
+    {
+        if (msync(mapping.data, mapping.size, MS_SYNC) == -1)
+        {
+            throw FileSystemError("could not flush mapped file '" + mapping.filePath + "': " + strerror(errno));
+        }
+    }
+}
+
 #endif
-    if (result == -1)
+
+class MappedFileTable
+{
+public:
+    ~MappedFileTable();
+    static void Init();
+    static void Done();
+    static MappedFileTable& Instance() { Assert(instance, "mapped file table not initialized"); return *instance; }
+    int32_t MapFile(const char* filePath, MapAccess access, uint8_t** data, int64_t* size);
+    void UnmapFile(int32_t mappingHandle);
+    void AdviseMappedFile(int32_t mappingHandle, int64_t offset, int64_t length, AccessAdvice advice);
+    void FlushMappedFile(int32_t mappingHandle);
+private:
+    static std::unique_ptr<MappedFileTable> instance;
+    std::unordered_map<int32_t, Mapping> mappingMap;
+    int32_t nextMappingHandle;
+    std::mutex mtx;
+    MappedFileTable();
+    Mapping& GetMapping(int32_t mappingHandle);
+};
+
+std::unique_ptr<MappedFileTable> MappedFileTable::instance;
+
+void MappedFileTable::Init()
+{
+    instance.reset(new MappedFileTable());
+}
+
+void MappedFileTable::Done()
+{
+    instance.reset();
+}
+
+MappedFileTable::MappedFileTable() : nextMappingHandle(1)
+{
+}
+
+MappedFileTable::~MappedFileTable()
+{
+    for (auto& p : mappingMap)
     {
-        std::string filePath;
-        if (fileHandle < maxNoLockFileHandles)
+        CloseMapping(p.second);
+    }
+}
+
+Mapping& MappedFileTable::GetMapping(int32_t mappingHandle)
+{
+    auto it = mappingMap.find(mappingHandle);
+    if (it == mappingMap.cend())
+    {
+        throw FileSystemError("invalid mapping handle " + std::to_string(mappingHandle));
+    }
+    return it->second;
+}
+
+int32_t MappedFileTable::MapFile(const char* filePath, MapAccess access, uint8_t** data, int64_t* size)
+{
+    Mapping mapping;
+    mapping.filePath = filePath;
+    mapping.access = access;
+    OpenMapping(mapping, *size);
+    *data = mapping.data;
+    *size = mapping.size;
+    std::lock_guard<std::mutex> lock(mtx);
+    int32_t mappingHandle = nextMappingHandle++;
+    mappingMap[mappingHandle] = mapping;
+    return mappingHandle;
+}
+
+void MappedFileTable::UnmapFile(int32_t mappingHandle)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Mapping& mapping = GetMapping(mappingHandle);
+    CloseMapping(mapping);
+    mappingMap.erase(mappingHandle);
+}
+
+void MappedFileTable::AdviseMappedFile(int32_t mappingHandle, int64_t offset, int64_t length, AccessAdvice advice)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Mapping& mapping = GetMapping(mappingHandle);
+    if (offset < 0 || length < 0 || offset + length > mapping.size)
+    {
+        throw FileSystemError("advised range is outside of mapped file '" + mapping.filePath + "'");
+    }
+    AdviseMapping(mapping, offset, length, advice);
+}
+
+void MappedFileTable::FlushMappedFile(int32_t mappingHandle)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Mapping& mapping = GetMapping(mappingHandle);
+    FlushMapping(mapping);
+}
+
+#ifndef _WIN32
+
+int64_t CopyFileContents(int sourceFd, int targetFd, int64_t size)
+{
+    int64_t copied = 0;
+    bool useCopyFileRange = true;
+    bool useSendFile = true;
+    std::unique_ptr<char[]> buffer;
+    const int64_t bufferSize = 64 * 1024;
+    while (copied < size)
+    {
+        int64_t count = size - copied;
+        ssize_t result = -1;
+        if (useCopyFileRange)
         {
-            filePath = filePaths[fileHandle];
+            result = copy_file_range(sourceFd, nullptr, targetFd, nullptr, count, 0);
+            if (result == -1)
+            {
+                if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)
+                {
+                    useCopyFileRange = false;
+                    continue;
+                }
+                throw FileSystemError(std::string("copy_file_range failed: ") + strerror(errno));
+            }
+        }
+        else if (useSendFile)
+        {
+            result = sendfile(targetFd, sourceFd, nullptr, count);
+            if (result == -1)
+            {
+                if (errno == ENOSYS || errno == EINVAL)
+                {
+                    useSendFile = false;
+                    continue;
+                }
+                throw FileSystemError(std::string("sendfile failed: ") + strerror(errno));
+            }
         }
         else
         {
-            filePath = filePathMap[fileHandle];
+            if (!buffer)
+            {
+                buffer.reset(new char[bufferSize]);
+            }
+            result = read(sourceFd, buffer.get(), std::min(count, bufferSize));
+            if (result == -1)
+            {
+                throw FileSystemError(std::string("read failed: ") + strerror(errno));
+            }
+            ssize_t written = 0;
+            while (written < result)
+            {
+                ssize_t w = write(targetFd, buffer.get() + written, result - written);
+                if (w == -1)
+                {
+                    throw FileSystemError(std::string("write failed: ") + strerror(errno));
+                }
+                written += w;
+            }
+        }
+        if (result == 0)
+        {
+            break;
         }
-        throw FileSystemError("could not tell file position of  '" + filePath + "': " + strerror(errno));
+        copied += result;
     }
-    return result;
+    return copied;
 }
 
-void FileTable::FlushStdoutAndStderr()
+#endif
+
+int64_t CopyFileRange(const char* sourceFilePath, const char* targetFilePath)
 {
-    std::fflush(stdout);
-    std::fflush(stderr);
+#ifdef _WIN32
+    boost::system::error_code ec;
+    boost::filesystem::copy_file(sourceFilePath, targetFilePath, boost::filesystem::copy_option::overwrite_if_exists, ec);
+    if (ec)
+    {
+        throw FileSystemError("could not copy file '" + std::string(sourceFilePath) + "' to '" + std::string(targetFilePath) + "': " + ec.message());
+    }
+    return static_cast<int64_t>(boost::filesystem::file_size(targetFilePath));
+#else
+    int sourceFd = open(sourceFilePath, O_RDONLY);
+    if (sourceFd == -1)
+    {
+        throw FileSystemError("could not open file '" + std::string(sourceFilePath) + "': " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(sourceFd, &st) == -1)
+    {
+        std::string errorMessage = strerror(errno);
+        close(sourceFd);
+        throw FileSystemError("could not get size of file '" + std::string(sourceFilePath) + "': " + errorMessage);
+    }
+    int targetFd = open(targetFilePath, O_WRONLY | O_CREAT | O_TRUNC, st.st_mode & 0777);
+    if (targetFd == -1)
+    {
+        std::string errorMessage = strerror(errno);
+        close(sourceFd);
+        throw FileSystemError("could not create file '" + std::string(targetFilePath) + "': " + errorMessage);
+    }
+    int64_t copied = 0;
+    try
+    {
+        copied = CopyFileContents(sourceFd, targetFd, st.st_size);
+    }
+    catch (const FileSystemError& ex)
+    {
+        close(sourceFd);
+        close(targetFd);
+        throw FileSystemError("could not copy file '" + std::string(sourceFilePath) + "' to '" + std::string(targetFilePath) + "': " + ex.what());
+    }
+    close(sourceFd);
+    if (close(targetFd) == -1)
+    {
+        throw FileSystemError("could not close file '" + std::string(targetFilePath) + "': " + strerror(errno));
+    }
+    return copied;
+#endif
 }
 
 FileSystemError::FileSystemError(const std::string& message_) : std::runtime_error(message_)
@@ -708,10 +1050,12 @@ FileSystemError::FileSystemError(const std::string& message_) : std::runtime_err
 void InitIo()
 {
     FileTable::Init();
+    MappedFileTable::Init();
 }
 
 void DoneIo()
 {
+    MappedFileTable::Done();
     FileTable::Done();
 }
 
@@ -759,6 +1103,23 @@ extern "C" RT_API int32_t RtWrite(int32_t fileHandle, const uint8_t* buffer, int
     }
 }
 
+extern "C" RT_API int32_t RtWriteV(int32_t fileHandle, const uint8_t** buffers, const int64_t* counts, int32_t bufferCount)
+{
+    try
+    {
+        cmajor::rt::FileTable::Instance().WriteFileV(fileHandle, buffers, counts, bufferCount);
+        return 0;
+    }
+    catch (const cmajor::rt::FileSystemError& ex)
+    {
+        return cmajor::rt::InstallError(ex.what());
+    }
+    catch (const cmajor::unicode::UnicodeException& ex)
+    {
+        return cmajor::rt::InstallError(ex.what());
+    }
+}
+
 extern "C" RT_API int32_t RtWriteByte(int32_t fileHandle, uint8_t x)
 {
     try
@@ -894,3 +1255,66 @@ extern "C" RT_API int32_t RtCopyFile(const char* sourceFilePath, const char* tar
     }
     return 0;
 }
+
+extern "C" RT_API int32_t RtMapFile(const char* filePath, MapAccess access, uint8_t** data, int64_t* size)
+{
+    try
+    {
+        return cmajor::rt::MappedFileTable::Instance().MapFile(filePath, access, data, size);
+    }
+    catch (const cmajor::rt::FileSystemError& ex)
+    {
+        return cmajor::rt::InstallError(ex.what());
+    }
+}
+
+extern "C" RT_API int32_t RtUnmapFile(int32_t mappingHandle)
+{
+    try
+    {
+        cmajor::rt::MappedFileTable::Instance().UnmapFile(mappingHandle);
+        return 0;
+    }
+    catch (const cmajor::rt::FileSystemError& ex)
+    {
+        return cmajor::rt::InstallError(ex.what());
+    }
+}
+
+extern "C" RT_API int32_t RtAdviseMappedFile(int32_t mappingHandle, int64_t offset, int64_t length, AccessAdvice advice)
+{
+    try
+    {
+        cmajor::rt::MappedFileTable::Instance().AdviseMappedFile(mappingHandle, offset, length, advice);
+        return 0;
+    }
+    catch (const cmajor::rt::FileSystemError& ex)
+    {
+        return cmajor::rt::InstallError(ex.what());
+    }
+}
+
+extern "C" RT_API int32_t RtFlushMappedFile(int32_t mappingHandle)
+{
+    try
+    {
+        cmajor::rt::MappedFileTable::Instance().FlushMappedFile(mappingHandle);
+        return 0;
+    }
+    catch (const cmajor::rt::FileSystemError& ex)
+    {
+        return cmajor::rt::InstallError(ex.what());
+    }
+}
+
+extern "C" RT_API int64_t RtCopyFileRange(const char* sourceFilePath, const char* targetFilePath)
+{
+    try
+    {
+        return cmajor::rt::CopyFileRange(sourceFilePath, targetFilePath);
+    }
+    catch (const cmajor::rt::FileSystemError& ex)
+    {
+        return cmajor::rt::InstallError(ex.what());
+    }
+}
@@ -26,6 +26,16 @@ enum class Origin : uint8_t
     seekSet, seekCur, seekEnd
 };
 
+enum class MapAccess : uint8_t
+{
+    readOnly = 0, readWrite = 1
+};
+
+enum class AccessAdvice : uint8_t
+{
+    normal = 0, sequential = 1, random = 2, willNeed = 3, dontNeed = 4
+};
+
 inline OpenMode operator&(OpenMode left, OpenMode right)
 {
     return OpenMode(uint8_t(left) & uint8_t(right));
@@ -39,6 +49,7 @@ inline OpenMode operator|(OpenMode left, OpenMode right)
 extern "C" RT_API int32_t RtOpen(const char* filePath, OpenMode openMode);
 extern "C" RT_API int32_t RtClose(int32_t fileHandle);
 extern "C" RT_API int32_t RtWrite(int32_t fileHandle, const uint8_t* buffer, int64_t count);
+extern "C" RT_API int32_t RtWriteV(int32_t fileHandle, const uint8_t** buffers, const int64_t* counts, int32_t bufferCount);
 extern "C" RT_API int32_t RtWriteByte(int32_t fileHandle, uint8_t x);
 extern "C" RT_API int64_t RtRead(int32_t fileHandle, uint8_t* buffer, int64_t bufferSize);
 extern "C" RT_API int32_t RtReadByte(int32_t fileHandle);
@@ -50,6 +61,15 @@ extern "C" RT_API int32_t RtGetFileSize(const char* filePath, uint64_t* fileSize
 extern "C" RT_API int32_t RtRemoveFile(const char* filePath);
 extern "C" RT_API int32_t RtCopyFile(const char* sourceFilePath, const char* targetFilePath);
 
+// Maps a file into memory. For read-write mappings a nonzero *size larger than the file size extends the file first.
+// Returns a mapping handle and sets *data and *size to the mapped memory, or returns a negative error id.
+extern "C" RT_API int32_t RtMapFile(const char* filePath, MapAccess access, uint8_t** data, int64_t* size);
+extern "C" RT_API int32_t RtUnmapFile(int32_t mappingHandle);
+extern "C" RT_API int32_t RtAdviseMappedFile(int32_t mappingHandle, int64_t offset, int64_t length, AccessAdvice advice);
+extern "C" RT_API int32_t RtFlushMappedFile(int32_t mappingHandle);
+// Copies a file inside the kernel (copy_file_range or sendfile) when possible. Returns the number of bytes copied or a negative error id.
+extern "C" RT_API int64_t RtCopyFileRange(const char* sourceFilePath, const char* targetFilePath);
+
 namespace cmajor { namespace rt {
 
 class FileSystemError : public std::runtime_error
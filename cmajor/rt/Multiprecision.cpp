@@ -57,6 +57,17 @@ extern "C" RT_API void RtFreeBigIntStr(int32_t bigIntStrHandle)
     cmajor::rt::DisposeString(bigIntStrHandle);
 }
 
+extern "C" RT_API int64_t RtGetBigIntStrSize(void* bigInt, int32_t base)
+{
+    return get_mpz_str_size(bigInt, base);
+}
+
+extern "C" RT_API int64_t RtGetBigIntStrBuffer(void* bigInt, int32_t base, char* buffer, int64_t bufferSize)
+{
+    if (bufferSize < get_mpz_str_size(bigInt, base)) return -1;
+    return get_mpz_str_buf(bigInt, base, buffer);
+}
+
 extern "C" RT_API void RtNegBigInt(void* result, void* bigInt)
 {
     neg_mpz(result, bigInt);
@@ -191,6 +202,17 @@ extern "C" RT_API void RtFreeBigRationalStr(int32_t bigRationalStrHandle)
     cmajor::rt::DisposeString(bigRationalStrHandle);
 }
 
+extern "C" RT_API int64_t RtGetBigRationalStrSize(void* bigRational, int32_t base)
+{
+    return get_mpq_str_size(bigRational, base);
+}
+
+extern "C" RT_API int64_t RtGetBigRationalStrBuffer(void* bigRational, int32_t base, char* buffer, int64_t bufferSize)
+{
+    if (bufferSize < get_mpq_str_size(bigRational, base)) return -1;
+    return get_mpq_str_buf(bigRational, base, buffer);
+}
+
 extern "C" RT_API void RtSetBigRationalBigInt(void* bigRational, void* bigInt)
 {
     set_mpq_z(bigRational, bigInt);
@@ -335,6 +357,17 @@ extern "C" RT_API void RtFreeBigFloatStr(int32_t bigFloatStrHandle)
     cmajor::rt::DisposeString(bigFloatStrHandle);
 }
 
+extern "C" RT_API int64_t RtGetBigFloatStrSize(void* bigFloat, int32_t base, uint32_t numDigits)
+{
+    return get_mpf_str_size(bigFloat, base, numDigits);
+}
+
+extern "C" RT_API int64_t RtGetBigFloatStrBuffer(void* bigFloat, int32_t base, uint32_t numDigits, int64_t* exponent, char* buffer, int64_t bufferSize)
+{
+    if (bufferSize < get_mpf_str_size(bigFloat, base, numDigits)) return -1;
+    return get_mpf_str_buf(bigFloat, base, numDigits, exponent, buffer);
+}
+
 extern "C" RT_API void RtAddBigFloat(void* target, void* left, void* right)
 {
     add_mpf(target, left, right);
@@ -8,6 +8,10 @@
 #include <cmajor/rt/RtApi.hpp>
 #include <stdint.h>
 
+//  The result or target of an operation may be the same object as an operand, so operations can be done in place reusing the memory of the target.
+//  RtGetXStrSize returns the size of a buffer that is large enough for the string representation of a number including the terminating zero.
+//  RtGetXStrBuffer writes the string representation to the buffer and returns its length, or -1 if the buffer is too small.
+
 //  Integer functions:
 
 extern "C" RT_API void* RtCreateBigInt();
@@ -18,6 +22,8 @@ extern "C" RT_API int32_t RtAssignBigIntStr(void* bigInt, const char* str, int32
 extern "C" RT_API int32_t RtGetBigIntStrHandle(void* bigInt, int32_t base);
 extern "C" RT_API const char* RtGetBigIntStr(int32_t bigIntStrHandle);
 extern "C" RT_API void RtFreeBigIntStr(int32_t bigIntStrHandle);
+extern "C" RT_API int64_t RtGetBigIntStrSize(void* bigInt, int32_t base);
+extern "C" RT_API int64_t RtGetBigIntStrBuffer(void* bigInt, int32_t base, char* buffer, int64_t bufferSize);
 extern "C" RT_API void RtNegBigInt(void* result, void* bigInt);
 extern "C" RT_API void RtAbsBigInt(void* result, void* bigInt);
 extern "C" RT_API void RtAddBigInt(void* result, void* left, void* right);
@@ -47,6 +53,8 @@ extern "C" RT_API void RtSetBigRationalUInt(void* bigRational, uint32_t numerato
 extern "C" RT_API int32_t RtGetBigRationalStrHandle(void* bigRational, int32_t base);
 extern "C" RT_API const char* RtGetBigRationalStr(int32_t bigRationalStrHandle);
 extern "C" RT_API void RtFreeBigRationalStr(int32_t bigRationalStrHandle);
+extern "C" RT_API int64_t RtGetBigRationalStrSize(void* bigRational, int32_t base);
+extern "C" RT_API int64_t RtGetBigRationalStrBuffer(void* bigRational, int32_t base, char* buffer, int64_t bufferSize);
 extern "C" RT_API void RtSetBigRationalBigInt(void* bigRational, void* bigInt);
 extern "C" RT_API void RtAddBigRational(void* target, void* left, void* right);
 extern "C" RT_API void RtSubBigRational(void* target, void* left, void* right);
@@ -78,6 +86,8 @@ extern "C" RT_API int32_t RtSetBigFloatStr(void* left, const char* str, int32_t
 extern "C" RT_API int32_t RtGetBigFloatStrHandle(void* bigFloat, int32_t base, uint32_t numDigits, int64_t* exponent);
 extern "C" RT_API const char* RtGetBigFloatStr(int32_t bigFloatStrHandle);
 extern "C" RT_API void RtFreeBigFloatStr(int32_t bigFloatStrHandle);
+extern "C" RT_API int64_t RtGetBigFloatStrSize(void* bigFloat, int32_t base, uint32_t numDigits);
+extern "C" RT_API int64_t RtGetBigFloatStrBuffer(void* bigFloat, int32_t base, uint32_t numDigits, int64_t* exponent, char* buffer, int64_t bufferSize);
 extern "C" RT_API void RtAddBigFloat(void* target, void* left, void* right);
 extern "C" RT_API void RtSubBigFloat(void* target, void* left, void* right);
 extern "C" RT_API void RtMulBigFloat(void* target, void* left, void* right);
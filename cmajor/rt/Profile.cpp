@@ -9,11 +9,26 @@
 #include <cmajor/util/Path.hpp>
 #include <cmajor/util/Unicode.hpp>
 #include <cmajor/util/BinaryWriter.hpp>
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <chrono>
 #include <mutex>
 #include <fstream>
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include <queue>
+#include <thread>
+#include <condition_variable>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#endif
 
 namespace cmajor {namespace rt {
 
@@ -27,31 +42,266 @@ enum class TimePointKind : uint8_t
 
 struct FunctionProfileData
 {
-    FunctionProfileData(TimePointKind kind_, const boost::uuids::uuid& functionId_) : 
-        timePoint(std::chrono::high_resolution_clock::now()), functionId(functionId_), kind(kind_) {}
-    std::chrono::high_resolution_clock::time_point timePoint;
-    boost::uuids::uuid functionId;
+    void* functionId;
+    int64_t timePoint;
     TimePointKind kind;
 };
 
+// A fixed-size buffer of profile events of one thread. Full buffers are handed to the writer thread that encodes them to the profile data file
+// and returns them to the free list.
+
+struct EventChunk
+{
+    static const int32_t capacity = 4096;
+    EventChunk() : threadIndex(0), count(0) {}
+    uint32_t threadIndex;
+    int32_t count;
+    FunctionProfileData events[capacity];
+};
+
+// The current chunk of a thread is accessed under the mutex of the thread, so that the profiler can take the chunks of running threads when it stops.
+// The mutex of a thread is always locked before the mutex of the profiler. After the profiler has stopped, the events of the thread are discarded.
+
+struct ThreadEventData
+{
+    ThreadEventData(uint32_t threadIndex_, bool stopped_) : threadIndex(threadIndex_), chunk(nullptr), stopped(stopped_) {}
+    uint32_t threadIndex;
+    EventChunk* chunk;
+    bool stopped;
+    std::mutex mtx;
+};
+
+// Profile data file format: the magic number and version followed by records. A function record assigns the next function index to a function id.
+// A chunk record contains the events of one thread: for each event the function index shifted left by one or'ed with the event kind,
+// and the time in nanoseconds since the previous event of the same thread, both as ULEB128.
+
+const uint32_t profileDataMagic = 0x434D5046;
+const uint8_t profileDataVersion = 2;
+const uint8_t functionRecord = 0;
+const uint8_t chunkRecord = 1;
+const uint8_t endRecord = 2;
+const int32_t maxChunksInFlight = 16;
+
+// Samples of one thread aggregated by distinct call stack. All storage is allocated up front, so recording a sample does not allocate
+// and is safe to do from a signal handler. Samples that do not fit are counted as dropped.
+
+class SampleTable
+{
+public:
+    SampleTable();
+    void Record(void* const* stack, int32_t depth);
+    template<typename Fn>
+    void ForEachStack(Fn fn) const
+    {
+        for (int32_t i = 0; i < tableSize; ++i)
+        {
+            const Entry& entry = entries[i];
+            if (entry.count != 0)
+            {
+                fn(&pool[entry.offset], entry.depth, entry.count);
+            }
+        }
+    }
+    uint64_t DroppedSamples() const { return droppedSamples; }
+private:
+    static const int32_t tableSize = 1 << 14;
+    static const int32_t maxEntries = tableSize / 4 * 3;
+    static const int32_t poolSize = 1 << 18;
+    struct Entry
+    {
+        Entry() : hash(0), offset(0), depth(0), count(0) {}
+        uint64_t hash;
+        int32_t offset;
+        int32_t depth;
+        uint64_t count;
+    };
+    std::unique_ptr<Entry[]> entries;
+    std::unique_ptr<void*[]> pool;
+    int32_t poolTop;
+    int32_t entryCount;
+    uint64_t droppedSamples;
+};
+
+SampleTable::SampleTable() : entries(new Entry[tableSize]), pool(new void*[poolSize]), poolTop(0), entryCount(0), droppedSamples(0)
+{
+}
+
+void SampleTable::Record(void* const* stack, int32_t depth)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (int32_t i = 0; i < depth; ++i)
+    {
+        hash = (hash ^ reinterpret_cast<uintptr_t>(stack[i])) * 1099511628211ull;
+    }
+    int32_t index = int32_t(hash & (tableSize - 1));
+    while (entries[index].count != 0)
+    {
+        Entry& entry = entries[index];
+        if (entry.hash == hash && entry.depth == depth && std::equal(stack, stack + depth, &pool[entry.offset]))
+        {
+            ++entry.count;
+            return;
+        }
+        index = (index + 1) & (tableSize - 1);
+    }
+    if (entryCount == maxEntries || poolTop + depth > poolSize)
+    {
+        ++droppedSamples;
+        return;
+    }
+    Entry& entry = entries[index];
+    entry.hash = hash;
+    entry.offset = poolTop;
+    entry.depth = depth;
+    std::copy(stack, stack + depth, &pool[poolTop]);
+    poolTop += depth;
+    ++entryCount;
+    entry.count = 1;
+}
+
+// Shadow call stack of one thread. The instrumented function entry and exit only push and pop a function id; the timer takes a sample of the stack.
+// The stack is a ring buffer indexed by depth, so when the call depth exceeds the size of the buffer the innermost frames are kept and the outermost are overwritten.
+// Frames below the lost depth have been overwritten and are left out of the samples until the stack has unwound below them.
+
+struct ThreadSampleData
+{
+    static const int32_t maxStackDepth = 256;
+    static_assert((maxStackDepth & (maxStackDepth - 1)) == 0, "maxStackDepth must be a power of two");
+    ThreadSampleData() : depth(0), lostDepth(0)
+    {
+#ifdef _WIN32
+        thread = nullptr;
+#endif
+    }
+    void Push(void* functionId)
+    {
+        int32_t d = depth.load(std::memory_order_relaxed);
+        if (d >= maxStackDepth && d - maxStackDepth + 1 > lostDepth.load(std::memory_order_relaxed))
+        {
+            lostDepth.store(d - maxStackDepth + 1, std::memory_order_relaxed);
+        }
+        stack[d & (maxStackDepth - 1)] = functionId;
+        std::atomic_signal_fence(std::memory_order_release);
+        depth.store(d + 1, std::memory_order_relaxed);
+    }
+    void Pop()
+    {
+        int32_t d = depth.load(std::memory_order_relaxed) - 1;
+        depth.store(d, std::memory_order_relaxed);
+        if (d < lostDepth.load(std::memory_order_relaxed))
+        {
+            lostDepth.store(d, std::memory_order_relaxed);
+        }
+    }
+    void Sample()
+    {
+        int32_t d = depth.load(std::memory_order_relaxed);
+        int32_t start = lostDepth.load(std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_acquire);
+        if (d <= start)
+        {
+            return;
+        }
+        if (d > maxStackDepth)
+        {
+            void* innermost[maxStackDepth];
+            int32_t n = d - start;
+            for (int32_t i = 0; i < n; ++i)
+            {
+                innermost[i] = stack[(start + i) & (maxStackDepth - 1)];
+            }
+            samples.Record(innermost, n);
+        }
+        else
+        {
+            samples.Record(stack + start, d - start);
+        }
+    }
+    void* stack[maxStackDepth];
+    std::atomic<int32_t> depth;
+    std::atomic<int32_t> lostDepth;
+    SampleTable samples;
+#ifdef _WIN32
+    HANDLE thread;
+#endif
+};
+
+enum class ProfilingMode : uint8_t
+{
+    events = 0, sampling = 1
+};
+
 class Profiler
 {
 public:
     static void Init();
     static void Done();
     static Profiler& Instance() { return *instance; }
-    void StartFunction(const boost::uuids::uuid& functionId);
-    void EndFunction(const boost::uuids::uuid& functionId);
-    std::vector<FunctionProfileData>* CreateFunctionProfileData();
-    void WriteData();
+    ProfilingMode Mode() const { return mode; }
+    void AddEvent(void* functionId, TimePointKind kind);
+    void StartSampledFunction(void* functionId);
+    void EndSampledFunction();
+    ThreadEventData* CreateThreadEventData();
+    EventChunk* AcquireChunk(uint32_t threadIndex);
+    void ReleaseChunk(EventChunk* chunk);
+    void SubmitChunk(EventChunk* chunk);
+    void StartWriter();
+    void StopWriter();
+    ThreadSampleData* CreateThreadSampleData();
+    void StartSampling();
+    void StopSampling();
+    void WriteSampleData();
 private:
     static std::unique_ptr<Profiler> instance;
-    std::vector<std::unique_ptr<std::vector<FunctionProfileData>>> profileData;
+    ProfilingMode mode;
+    int32_t samplingIntervalUs;
+    std::chrono::steady_clock::time_point startTime;
+    std::vector<std::unique_ptr<ThreadEventData>> threadEventData;
+    std::vector<std::unique_ptr<EventChunk>> chunks;
+    std::vector<EventChunk*> freeChunks;
+    std::queue<EventChunk*> fullChunks;
+    std::condition_variable chunkFreed;
+    std::condition_variable chunkFull;
+    std::thread writerThread;
+    bool stopping;
+    bool writerStopped;
+    std::unique_ptr<BinaryWriter> writer;
+    std::unordered_map<void*, uint32_t> functionIndexMap;
+    std::vector<int64_t> lastTimePoints;
+    std::vector<std::unique_ptr<ThreadSampleData>> sampleData;
     std::mutex mtx;
+    void RunWriter();
+    void WriteChunk(EventChunk* chunk);
+#ifdef _WIN32
+    std::thread samplerThread;
+    std::condition_variable stopSampling;
+    bool samplingStopped;
+    void RunSampler();
+#endif
+    Profiler();
 };
 
 std::unique_ptr<Profiler> Profiler::instance;
 
+const int32_t defaultSamplingIntervalUs = 1000;
+
+Profiler::Profiler() : mode(ProfilingMode::events), samplingIntervalUs(defaultSamplingIntervalUs), startTime(std::chrono::steady_clock::now()), stopping(false), writerStopped(false)
+{
+#ifdef _WIN32
+    samplingStopped = false;
+#endif
+    const char* samplingInterval = getenv("CMAJOR_PROFILE_SAMPLING_INTERVAL");
+    if (samplingInterval && *samplingInterval)
+    {
+        mode = ProfilingMode::sampling;
+        int32_t interval = atoi(samplingInterval);
+        if (interval > 0)
+        {
+            samplingIntervalUs = interval;
+        }
+    }
+}
+
 void Profiler::Init()
 {
     instance.reset(new Profiler());
@@ -62,67 +312,379 @@ void Profiler::Done()
     instance.reset();
 }
 
-std::vector<FunctionProfileData>* Profiler::CreateFunctionProfileData()
+ThreadEventData* Profiler::CreateThreadEventData()
 {
     std::lock_guard<std::mutex> lock(mtx);
-    profileData.push_back(std::unique_ptr<std::vector<FunctionProfileData>>(new std::vector<FunctionProfileData>));
-    return profileData.back().get();
+    threadEventData.push_back(std::unique_ptr<ThreadEventData>(new ThreadEventData(uint32_t(threadEventData.size()), stopping)));
+    return threadEventData.back().get();
 }
 
-void Profiler::WriteData()
+EventChunk* Profiler::AcquireChunk(uint32_t threadIndex)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (freeChunks.empty())
+    {
+        if (int32_t(chunks.size()) < maxChunksInFlight + int32_t(threadEventData.size()))
+        {
+            chunks.push_back(std::unique_ptr<EventChunk>(new EventChunk()));
+            freeChunks.push_back(chunks.back().get());
+        }
+        else
+        {
+            chunkFreed.wait(lock);
+        }
+    }
+    EventChunk* chunk = freeChunks.back();
+    freeChunks.pop_back();
+    chunk->threadIndex = threadIndex;
+    chunk->count = 0;
+    return chunk;
+}
+
+void Profiler::ReleaseChunk(EventChunk* chunk)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        freeChunks.push_back(chunk);
+    }
+    chunkFreed.notify_all();
+}
+
+void Profiler::SubmitChunk(EventChunk* chunk)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        fullChunks.push(chunk);
+    }
+    chunkFull.notify_one();
+}
+
+void Profiler::StartWriter()
 {
     std::string executablePath = GetFullPath(GetPathToExecutable());
     std::string profileDataFilePath = Path::Combine(Path::GetDirectoryName(executablePath), "cmprof.bin");
-    BinaryWriter writer(profileDataFilePath);
-    uint64_t n = 0;
-    for (const std::unique_ptr<std::vector<FunctionProfileData>>& profileDataVec : profileData)
+    writer.reset(new BinaryWriter(profileDataFilePath));
+    writer->Write(profileDataMagic);
+    writer->Write(profileDataVersion);
+    writerThread = std::thread([this]{ RunWriter(); });
+}
+
+void Profiler::StopWriter()
+{
+    std::vector<ThreadEventData*> threads;
     {
-        n += profileDataVec->size();
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+        for (const std::unique_ptr<ThreadEventData>& data : threadEventData)
+        {
+            threads.push_back(data.get());
+        }
+    }
+    for (ThreadEventData* data : threads)
+    {
+        std::lock_guard<std::mutex> dataLock(data->mtx);
+        data->stopped = true;
+        if (data->chunk)
+        {
+            if (data->chunk->count > 0)
+            {
+                SubmitChunk(data->chunk);
+            }
+            else
+            {
+                ReleaseChunk(data->chunk);
+            }
+            data->chunk = nullptr;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        writerStopped = true;
+    }
+    chunkFull.notify_one();
+    writerThread.join();
+    writer->Write(endRecord);
+    writer.reset();
+}
+
+void Profiler::RunWriter()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+        chunkFull.wait(lock, [this]{ return !fullChunks.empty() || writerStopped; });
+        if (fullChunks.empty())
+        {
+            return;
+        }
+        EventChunk* chunk = fullChunks.front();
+        fullChunks.pop();
+        lock.unlock();
+        WriteChunk(chunk);
+        lock.lock();
+        freeChunks.push_back(chunk);
+        chunkFreed.notify_all();
     }
-    writer.Write(n);
-    for (const std::unique_ptr<std::vector<FunctionProfileData>>& profileDataVec : profileData)
+}
+
+void Profiler::WriteChunk(EventChunk* chunk)
+{
+    for (int32_t i = 0; i < chunk->count; ++i)
     {
-        for (const FunctionProfileData& functionProfileData : *profileDataVec)
+        void* functionId = chunk->events[i].functionId;
+        if (functionIndexMap.find(functionId) == functionIndexMap.cend())
         {
-            writer.Write(functionProfileData.functionId);
-            writer.Write(functionProfileData.timePoint.time_since_epoch().count());
-            writer.Write(static_cast<uint8_t>(functionProfileData.kind));
+            functionIndexMap[functionId] = uint32_t(functionIndexMap.size());
+            writer->Write(functionRecord);
+            writer->Write(*reinterpret_cast<boost::uuids::uuid*>(functionId));
         }
     }
+    if (chunk->threadIndex >= lastTimePoints.size())
+    {
+        lastTimePoints.resize(chunk->threadIndex + 1, 0);
+    }
+    int64_t lastTimePoint = lastTimePoints[chunk->threadIndex];
+    writer->Write(chunkRecord);
+    writer->WriteULEB128UInt(chunk->threadIndex);
+    writer->WriteULEB128UInt(uint32_t(chunk->count));
+    for (int32_t i = 0; i < chunk->count; ++i)
+    {
+        const FunctionProfileData& event = chunk->events[i];
+        writer->WriteULEB128UInt((functionIndexMap[event.functionId] << 1) | uint32_t(event.kind));
+        writer->WriteULEB128ULong(uint64_t(event.timePoint - lastTimePoint));
+        lastTimePoint = event.timePoint;
+    }
+    lastTimePoints[chunk->threadIndex] = lastTimePoint;
 }
 
 #ifdef _WIN32
-__declspec(thread) std::vector<FunctionProfileData>* functionProfileData = nullptr;
+__declspec(thread) ThreadEventData* currentThreadEventData = nullptr;
+__declspec(thread) ThreadSampleData* threadSampleData = nullptr;
+#else
+__thread ThreadEventData* currentThreadEventData = nullptr;
+__thread ThreadSampleData* threadSampleData = nullptr;
+#endif
+
+ThreadSampleData* Profiler::CreateThreadSampleData()
+{
+    std::unique_ptr<ThreadSampleData> data(new ThreadSampleData());
+#ifdef _WIN32
+    DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &data->thread, THREAD_SUSPEND_RESUME | THREAD_QUERY_INFORMATION, FALSE, 0);
+#endif
+    std::lock_guard<std::mutex> lock(mtx);
+    sampleData.push_back(std::move(data));
+    return sampleData.back().get();
+}
+
+void Profiler::StartSampledFunction(void* functionId)
+{
+    if (!threadSampleData)
+    {
+        threadSampleData = CreateThreadSampleData();
+    }
+    threadSampleData->Push(functionId);
+}
+
+void Profiler::EndSampledFunction()
+{
+    if (threadSampleData)
+    {
+        threadSampleData->Pop();
+    }
+}
+
+#ifdef _WIN32
+
+void Profiler::RunSampler()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stopSampling.wait_for(lock, std::chrono::microseconds(samplingIntervalUs), [this]{ return samplingStopped; }))
+    {
+        for (const std::unique_ptr<ThreadSampleData>& data : sampleData)
+        {
+            if (data->thread && SuspendThread(data->thread) != DWORD(-1))
+            {
+                data->Sample();
+                ResumeThread(data->thread);
+            }
+        }
+    }
+}
+
+void Profiler::StartSampling()
+{
+    samplerThread = std::thread([this]{ RunSampler(); });
+}
+
+void Profiler::StopSampling()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        samplingStopped = true;
+    }
+    stopSampling.notify_one();
+    samplerThread.join();
+    for (const std::unique_ptr<ThreadSampleData>& data : sampleData)
+    {
+        if (data->thread)
+        {
+            CloseHandle(data->thread);
+            data->thread = nullptr;
+        }
+    }
+}
+
 #else
-__thread std::vector<FunctionProfileData>* functionProfileData = nullptr;
+
+void ProfilingSignalHandler(int sig)
+{
+    ThreadSampleData* data = threadSampleData;
+    if (data)
+    {
+        data->Sample();
+    }
+}
+
+void Profiler::StartSampling()
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = ProfilingSignalHandler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+    struct itimerval timer;
+    timer.it_interval.tv_sec = samplingIntervalUs / 1000000;
+    timer.it_interval.tv_usec = samplingIntervalUs % 1000000;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+void Profiler::StopSampling()
+{
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    signal(SIGPROF, SIG_IGN);
+}
+
 #endif
 
-void Profiler::StartFunction(const boost::uuids::uuid& functionId)
+void Profiler::WriteSampleData()
 {
-    if (!functionProfileData)
+    std::string executablePath = GetFullPath(GetPathToExecutable());
+    std::string sampleDataFilePath = Path::Combine(Path::GetDirectoryName(executablePath), "cmprof.samples.bin");
+    std::unordered_map<void*, uint32_t> functionIndexMap;
+    std::vector<void*> functionIds;
+    std::map<std::vector<uint32_t>, uint64_t> stackCounts;
+    uint64_t droppedSamples = 0;
+    for (const std::unique_ptr<ThreadSampleData>& data : sampleData)
     {
-        functionProfileData = CreateFunctionProfileData();
+        data->samples.ForEachStack([&](void* const* stack, int32_t depth, uint64_t count)
+        {
+            std::vector<uint32_t> indices;
+            for (int32_t i = 0; i < depth; ++i)
+            {
+                auto it = functionIndexMap.find(stack[i]);
+                if (it != functionIndexMap.cend())
+                {
+                    indices.push_back(it->second);
+                }
+                else
+                {
+                    uint32_t index = uint32_t(functionIds.size());
+                    functionIndexMap[stack[i]] = index;
+                    functionIds.push_back(stack[i]);
+                    indices.push_back(index);
+                }
+            }
+            stackCounts[indices] += count;
+        });
+        droppedSamples += data->samples.DroppedSamples();
     }
-    functionProfileData->push_back(FunctionProfileData(TimePointKind::start, functionId));
+    BinaryWriter writer(sampleDataFilePath);
+    writer.Write(uint32_t(samplingIntervalUs));
+    writer.Write(uint32_t(functionIds.size()));
+    for (void* functionId : functionIds)
+    {
+        writer.Write(*reinterpret_cast<boost::uuids::uuid*>(functionId));
+    }
+    writer.Write(uint64_t(stackCounts.size()));
+    for (const auto& p : stackCounts)
+    {
+        writer.Write(p.second);
+        writer.Write(uint32_t(p.first.size()));
+        for (uint32_t index : p.first)
+        {
+            writer.Write(index);
+        }
+    }
+    writer.Write(droppedSamples);
 }
 
-void Profiler::EndFunction(const boost::uuids::uuid& functionId)
+void Profiler::AddEvent(void* functionId, TimePointKind kind)
 {
-    if (!functionProfileData)
+    int64_t timePoint = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    ThreadEventData* data = currentThreadEventData;
+    if (!data)
+    {
+        data = CreateThreadEventData();
+        currentThreadEventData = data;
+    }
+    std::unique_lock<std::mutex> dataLock(data->mtx);
+    if (data->stopped)
+    {
+        return;
+    }
+    EventChunk* chunk = data->chunk;
+    if (!chunk)
+    {
+        dataLock.unlock();
+        chunk = AcquireChunk(data->threadIndex);
+        dataLock.lock();
+        if (data->stopped)
+        {
+            dataLock.unlock();
+            ReleaseChunk(chunk);
+            return;
+        }
+        data->chunk = chunk;
+    }
+    FunctionProfileData& event = chunk->events[chunk->count++];
+    event.functionId = functionId;
+    event.timePoint = timePoint;
+    event.kind = kind;
+    if (chunk->count == EventChunk::capacity)
     {
-        functionProfileData = CreateFunctionProfileData();
+        data->chunk = nullptr;
+        SubmitChunk(chunk);
     }
-    functionProfileData->push_back(FunctionProfileData(TimePointKind::end, functionId));
 }
 
 void InitProfiler()
 {
     Profiler::Init();
+    if (Profiler::Instance().Mode() == ProfilingMode::sampling)
+    {
+        Profiler::Instance().StartSampling();
+    }
+    else
+    {
+        Profiler::Instance().StartWriter();
+    }
 }
 
 void DoneProfiler()
 {
-    Profiler::Instance().WriteData();
+    if (Profiler::Instance().Mode() == ProfilingMode::sampling)
+    {
+        Profiler::Instance().StopSampling();
+        Profiler::Instance().WriteSampleData();
+    }
+    else
+    {
+        Profiler::Instance().StopWriter();
+    }
     Profiler::Done();
 }
 
@@ -143,12 +705,22 @@ extern "C" RT_API void RtEndProfiling()
 
 extern "C" RT_API void RtProfileStartFunction(void* functionId)
 {
-    boost::uuids::uuid* funId = reinterpret_cast<boost::uuids::uuid*>(functionId);
-    cmajor::rt::Profiler::Instance().StartFunction(*funId);
+    cmajor::rt::Profiler& profiler = cmajor::rt::Profiler::Instance();
+    if (profiler.Mode() == cmajor::rt::ProfilingMode::sampling)
+    {
+        profiler.StartSampledFunction(functionId);
+        return;
+    }
+    profiler.AddEvent(functionId, cmajor::rt::TimePointKind::start);
 }
 
 extern "C" RT_API void RtProfileEndFunction(void* functionId)
 {
-    boost::uuids::uuid* funId = reinterpret_cast<boost::uuids::uuid*>(functionId);
-    cmajor::rt::Profiler::Instance().EndFunction(*funId);
+    cmajor::rt::Profiler& profiler = cmajor::rt::Profiler::Instance();
+    if (profiler.Mode() == cmajor::rt::ProfilingMode::sampling)
+    {
+        profiler.EndSampledFunction();
+        return;
+    }
+    profiler.AddEvent(functionId, cmajor::rt::TimePointKind::end);
 }
@@ -9,6 +9,7 @@
 #include <cmajor/rt/InitDone.hpp>
 #include <cmajor/util/Error.hpp>
 #include <cmajor/util/TextUtils.hpp>
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <atomic>
@@ -25,6 +26,9 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/sendfile.h>
 #include <string.h>
 #define SOCKET int
 #define SD_RECEIVE SHUT_RD
@@ -40,10 +44,13 @@ using namespace cmajor::util;
 
 struct SocketData
 {
-    SocketData() : socket(INVALID_SOCKET), session(), xcred(), tlsSession(false) {}
-    SocketData(SOCKET socket_) : socket(socket_), session(), xcred(), tlsSession(false) {}
+    SocketData() : socket(INVALID_SOCKET), tlsSession(false), nonBlocking(false), connectPending(false), handshakePending(false), session(), xcred() {}
+    SocketData(SOCKET socket_) : socket(socket_), tlsSession(false), nonBlocking(false), connectPending(false), handshakePending(false), session(), xcred() {}
     SOCKET socket;
     bool tlsSession;
+    bool nonBlocking;
+    bool connectPending;
+    bool handshakePending;
     gnutls_session_t session;
     gnutls_certificate_credentials_t xcred;
 };
@@ -64,6 +71,13 @@ public:
     int32_t ConnectSocket(const std::string& node, const std::string& service, ConnectOptions options);
     int32_t SendSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags);
     int32_t ReceiveSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags);
+    int32_t SetSocketNonBlocking(int32_t socketHandle, bool nonBlocking);
+    int32_t TryAcceptSocket(int32_t socketHandle, bool* wouldBlock);
+    int32_t HandshakeSocket(int32_t socketHandle);
+    int32_t TrySendSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags, bool* wouldBlock);
+    int32_t TryReceiveSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags, bool* wouldBlock);
+    int64_t SendFile(int32_t socketHandle, const char* filePath, int64_t offset, int64_t count);
+    int64_t GetNativeSocket(int32_t socketHandle);
 private:
     static std::unique_ptr<SocketTable> instance;
     const int32_t maxNoLockSocketHandles = 256;
@@ -72,6 +86,8 @@ private:
     std::atomic<int32_t> nextSocketHandle;
     std::mutex mtx;
     SocketTable();
+    SocketData* GetSocketData(int32_t socketHandle);
+    int32_t InstallSocket(std::unique_ptr<SocketData>&& socketData);
 };
 
 std::unique_ptr<SocketTable> SocketTable::instance;
@@ -100,6 +116,40 @@ int GetLastSocketError()
     return WSAGetLastError();
 }
 
+bool SetNonBlockingMode(SOCKET s, bool nonBlocking)
+{
+    u_long mode = nonBlocking ? 1 : 0;
+    return ioctlsocket(s, FIONBIO, &mode) == 0;
+}
+
+bool WouldBlock(int errorCode)
+{
+    return errorCode == WSAEWOULDBLOCK;
+}
+
+bool ConnectInProgress(int errorCode)
+{
+    return errorCode == WSAEWOULDBLOCK || errorCode == WSAEINPROGRESS;
+}
+
+bool PollSocket(SOCKET s, short events)
+{
+    WSAPOLLFD fd;
+    fd.fd = s;
+    fd.events = events;
+    fd.revents = 0;
+    return WSAPoll(&fd, 1, 0) > 0;
+}
+
+void WaitForWritable(SOCKET s)
+{
+    WSAPOLLFD fd;
+    fd.fd = s;
+    fd.events = POLLWRNORM;
+    fd.revents = 0;
+    WSAPoll(&fd, 1, -1);
+}
+
 #else
 
 std::string GetSocketErrorMessage(int errorCode)
@@ -112,6 +162,52 @@ int GetLastSocketError()
     return errno;
 }
 
+bool SetNonBlockingMode(SOCKET s, bool nonBlocking)
+{
+    int flags = fcntl(s, F_GETFL, 0);
+    if (flags == -1)
+    {
+        return false;
+    }
+    if (nonBlocking)
+    {
+        flags = flags | O_NONBLOCK;
+    }
+    else
+    {
+        flags = flags & ~O_NONBLOCK;
+    }
+    return fcntl(s, F_SETFL, flags) == 0;
+}
+
+bool WouldBlock(int errorCode)
+{
+    return errorCode == EAGAIN || errorCode == EWOULDBLOCK || errorCode == EINTR;
+}
+
+bool ConnectInProgress(int errorCode)
+{
+    return errorCode == EINPROGRESS || errorCode == EINTR;
+}
+
+bool PollSocket(SOCKET s, short events)
+{
+    struct pollfd fd;
+    fd.fd = s;
+    fd.events = events;
+    fd.revents = 0;
+    return poll(&fd, 1, 0) > 0;
+}
+
+void WaitForWritable(SOCKET s)
+{
+    struct pollfd fd;
+    fd.fd = s;
+    fd.events = POLLOUT;
+    fd.revents = 0;
+    poll(&fd, 1, -1);
+}
+
 #endif
 
 SocketTable::SocketTable() : nextSocketHandle(1)
@@ -145,6 +241,43 @@ SocketTable::~SocketTable()
 #endif
 }
 
+SocketData* SocketTable::GetSocketData(int32_t socketHandle)
+{
+    if (socketHandle <= 0)
+    {
+        return nullptr;
+    }
+    else if (socketHandle < maxNoLockSocketHandles)
+    {
+        return sockets[socketHandle].get();
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = socketMap.find(socketHandle);
+        if (it != socketMap.cend())
+        {
+            return it->second.get();
+        }
+        return nullptr;
+    }
+}
+
+int32_t SocketTable::InstallSocket(std::unique_ptr<SocketData>&& socketData)
+{
+    int32_t socketHandle = nextSocketHandle++;
+    if (socketHandle < maxNoLockSocketHandles)
+    {
+        sockets[socketHandle] = std::move(socketData);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        socketMap[socketHandle] = std::move(socketData);
+    }
+    return socketHandle;
+}
+
 int32_t SocketTable::CreateSocket()
 {
     SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
@@ -578,48 +711,42 @@ int32_t SocketTable::ConnectSocket(const std::string& node, const std::string& s
             {
                 continue;
             }
+            bool nonBlocking = (options & ConnectOptions::nonBlocking) != ConnectOptions::none;
+            bool connectPending = false;
+            if (nonBlocking && !SetNonBlockingMode(s, true))
+            {
+                freeaddrinfo(res);
+                int errorCode = GetLastSocketError();
+                std::string errorMessage = GetSocketErrorMessage(errorCode);
+                return InstallError(errorMessage);
+            }
             int result = connect(s, rp->ai_addr, (int)rp->ai_addrlen);
+            if (result != 0 && nonBlocking && ConnectInProgress(GetLastSocketError()))
+            {
+                connectPending = true;
+                result = 0;
+            }
             if (result == 0)
             {
                 freeaddrinfo(res);
-                int32_t connectedSocketHandle = nextSocketHandle++;
-                if (connectedSocketHandle < maxNoLockSocketHandles)
+                socketData->socket = s;
+                socketData->nonBlocking = nonBlocking;
+                socketData->connectPending = connectPending;
+                SocketData* connectedSocketData = socketData.get();
+                int32_t connectedSocketHandle = InstallSocket(std::move(socketData));
+                if (createTlsSession)
                 {
-                    if (createTlsSession)
+                    gnutls_transport_set_int(connectedSocketData->session, s);
+                    gnutls_handshake_set_timeout(connectedSocketData->session, GNUTLS_DEFAULT_HANDSHAKE_TIMEOUT);
+                    if (nonBlocking)
                     {
-                        socketData->socket = s;
-                        sockets[connectedSocketHandle] = std::move(socketData);
-                        gnutls_transport_set_int(sockets[connectedSocketHandle]->session, s);
-                        gnutls_handshake_set_timeout(sockets[connectedSocketHandle]->session, GNUTLS_DEFAULT_HANDSHAKE_TIMEOUT);
-                        do
-                        {
-                            result = gnutls_handshake(sockets[connectedSocketHandle]->session);
-                        } 
-                        while (result < 0 && gnutls_error_is_fatal(result) == 0);
-                        if (result < 0)
-                        {
-                            std::string errorMessage = "gnutls_handshake failed with error code " + ToString(result) + " : " + gnutls_strerror(result);
-                            return InstallError(errorMessage);
-                        }
-                        sockets[connectedSocketHandle]->tlsSession = true;
+                        connectedSocketData->handshakePending = true;
                     }
                     else
                     {
-                        sockets[connectedSocketHandle] = std::unique_ptr<SocketData>(new SocketData(s));
-                    }
-                }
-                else
-                {
-                    std::lock_guard<std::mutex> lock(mtx);
-                    if (createTlsSession)
-                    {
-                        socketData->socket = s;
-                        socketMap[connectedSocketHandle] = std::move(socketData);
-                        gnutls_transport_set_int(socketMap[connectedSocketHandle]->session, s);
-                        gnutls_handshake_set_timeout(socketMap[connectedSocketHandle]->session, GNUTLS_DEFAULT_HANDSHAKE_TIMEOUT);
                         do
                         {
-                            result = gnutls_handshake(socketMap[connectedSocketHandle]->session);
+                            result = gnutls_handshake(connectedSocketData->session);
                         } 
                         while (result < 0 && gnutls_error_is_fatal(result) == 0);
                         if (result < 0)
@@ -627,12 +754,8 @@ int32_t SocketTable::ConnectSocket(const std::string& node, const std::string& s
                             std::string errorMessage = "gnutls_handshake failed with error code " + ToString(result) + " : " + gnutls_strerror(result);
                             return InstallError(errorMessage);
                         }
-                        socketMap[connectedSocketHandle]->tlsSession = true;
-                    }
-                    else
-                    {
-                        socketMap[connectedSocketHandle] = std::unique_ptr<SocketData>(new SocketData(s));
                     }
+                    connectedSocketData->tlsSession = true;
                 }
                 return connectedSocketHandle;
             }
@@ -787,6 +910,308 @@ int32_t SocketTable::ReceiveSocket(int32_t socketHandle, uint8_t* buf, int32_t l
     return result;
 }
 
+int32_t SocketTable::SetSocketNonBlocking(int32_t socketHandle, bool nonBlocking)
+{
+    SocketData* socketData = GetSocketData(socketHandle);
+    if (!socketData || socketData->socket == INVALID_SOCKET)
+    {
+        return InstallError("invalid socket handle " + std::to_string(socketHandle));
+    }
+    if (!SetNonBlockingMode(socketData->socket, nonBlocking))
+    {
+        int errorCode = GetLastSocketError();
+        std::string errorMessage = GetSocketErrorMessage(errorCode);
+        return InstallError(errorMessage);
+    }
+    socketData->nonBlocking = nonBlocking;
+    return 0;
+}
+
+int32_t SocketTable::TryAcceptSocket(int32_t socketHandle, bool* wouldBlock)
+{
+    *wouldBlock = false;
+    SocketData* socketData = GetSocketData(socketHandle);
+    if (!socketData || socketData->socket == INVALID_SOCKET)
+    {
+        return InstallError("invalid socket handle " + std::to_string(socketHandle));
+    }
+    SOCKET a = accept(socketData->socket, NULL, NULL);
+    if (a == INVALID_SOCKET)
+    {
+        int errorCode = GetLastSocketError();
+        if (WouldBlock(errorCode))
+        {
+            *wouldBlock = true;
+            return 0;
+        }
+        std::string errorMessage = GetSocketErrorMessage(errorCode);
+        return InstallError(errorMessage);
+    }
+    std::unique_ptr<SocketData> acceptedSocketData(new SocketData(a));
+    if (socketData->nonBlocking)
+    {
+        if (!SetNonBlockingMode(a, true))
+        {
+            int errorCode = GetLastSocketError();
+            std::string errorMessage = GetSocketErrorMessage(errorCode);
+#ifdef _WIN32
+            closesocket(a);
+#else
+            close(a);
+#endif
+            return InstallError(errorMessage);
+        }
+        acceptedSocketData->nonBlocking = true;
+    }
+    return InstallSocket(std::move(acceptedSocketData));
+}
+
+int32_t SocketTable::HandshakeSocket(int32_t socketHandle)
+{
+    SocketData* socketData = GetSocketData(socketHandle);
+    if (!socketData || socketData->socket == INVALID_SOCKET)
+    {
+        return InstallError("invalid socket handle " + std::to_string(socketHandle));
+    }
+    if (socketData->connectPending)
+    {
+#ifdef _WIN32
+        if (!PollSocket(socketData->socket, POLLWRNORM))
+#else
+        if (!PollSocket(socketData->socket, POLLOUT))
+#endif
+        {
+            return int32_t(SocketEvents::write);
+        }
+        int errorCode = 0;
+        socklen_t errorCodeLen = sizeof(errorCode);
+        if (getsockopt(socketData->socket, SOL_SOCKET, SO_ERROR, (char*)&errorCode, &errorCodeLen) != 0)
+        {
+            errorCode = GetLastSocketError();
+        }
+        if (errorCode != 0)
+        {
+            std::string errorMessage = GetSocketErrorMessage(errorCode);
+            return InstallError(errorMessage);
+        }
+        socketData->connectPending = false;
+    }
+    if (socketData->handshakePending)
+    {
+        int result = gnutls_handshake(socketData->session);
+        if (result < 0)
+        {
+            if (gnutls_error_is_fatal(result) == 0)
+            {
+                if (gnutls_record_get_direction(socketData->session) == 1)
+                {
+                    return int32_t(SocketEvents::write);
+                }
+                else
+                {
+                    return int32_t(SocketEvents::read);
+                }
+            }
+            std::string errorMessage = "gnutls_handshake failed with error code " + ToString(result) + " : " + gnutls_strerror(result);
+            return InstallError(errorMessage);
+        }
+        socketData->handshakePending = false;
+    }
+    return 0;
+}
+
+int32_t SocketTable::TrySendSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags, bool* wouldBlock)
+{
+    *wouldBlock = false;
+    SocketData* socketData = GetSocketData(socketHandle);
+    if (!socketData || socketData->socket == INVALID_SOCKET)
+    {
+        return InstallError("invalid socket handle " + std::to_string(socketHandle));
+    }
+    if (socketData->connectPending || socketData->handshakePending)
+    {
+        return InstallError("socket handle " + std::to_string(socketHandle) + " is not connected: call RtHandshakeSocket until it returns zero");
+    }
+    int32_t result = 0;
+    if (socketData->tlsSession)
+    {
+        result = gnutls_record_send(socketData->session, reinterpret_cast<const void*>(buf), len);
+        if (result < 0)
+        {
+            if (result == GNUTLS_E_AGAIN || result == GNUTLS_E_INTERRUPTED)
+            {
+                *wouldBlock = true;
+                return 0;
+            }
+            std::string errorMessage = "gnutls_record_send failed with error code " + ToString(result) + " : " + gnutls_strerror(result);
+            return InstallError(errorMessage);
+        }
+    }
+    else
+    {
+#ifdef MSG_NOSIGNAL
+        flags = flags | MSG_NOSIGNAL;
+#endif
+        result = send(socketData->socket, (const char*)buf, len, flags);
+        if (result < 0)
+        {
+            int errorCode = GetLastSocketError();
+            if (WouldBlock(errorCode))
+            {
+                *wouldBlock = true;
+                return 0;
+            }
+            std::string errorMessage = GetSocketErrorMessage(errorCode);
+            return InstallError(errorMessage);
+        }
+    }
+    return result;
+}
+
+int32_t SocketTable::TryReceiveSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags, bool* wouldBlock)
+{
+    *wouldBlock = false;
+    SocketData* socketData = GetSocketData(socketHandle);
+    if (!socketData || socketData->socket == INVALID_SOCKET)
+    {
+        return InstallError("invalid socket handle " + std::to_string(socketHandle));
+    }
+    if (socketData->connectPending || socketData->handshakePending)
+    {
+        return InstallError("socket handle " + std::to_string(socketHandle) + " is not connected: call RtHandshakeSocket until it returns zero");
+    }
+    int32_t result = 0;
+    if (socketData->tlsSession)
+    {
+        result = gnutls_record_recv(socketData->session, reinterpret_cast<void*>(buf), len);
+        if (result < 0)
+        {
+            if (result == GNUTLS_E_AGAIN || result == GNUTLS_E_INTERRUPTED)
+            {
+                *wouldBlock = true;
+                return 0;
+            }
+            std::string errorMessage = "gnutls_record_recv failed with error code " + ToString(result) + " : " + gnutls_strerror(result);
+            return InstallError(errorMessage);
+        }
+    }
+    else
+    {
+        result = recv(socketData->socket, (char*)buf, len, flags);
+        if (result < 0)
+        {
+            int errorCode = GetLastSocketError();
+            if (WouldBlock(errorCode))
+            {
+                *wouldBlock = true;
+                return 0;
+            }
+            std::string errorMessage = GetSocketErrorMessage(errorCode);
+            return InstallError(errorMessage);
+        }
+    }
+    return result;
+}
+
+int64_t SocketTable::SendFile(int32_t socketHandle, const char* filePath, int64_t offset, int64_t count)
+{
+    SocketData* socketData = GetSocketData(socketHandle);
+    if (!socketData || socketData->socket == INVALID_SOCKET)
+    {
+        return InstallError("invalid socket handle " + std::to_string(socketHandle));
+    }
+    FILE* file = std::fopen(filePath, "rb");
+    if (!file)
+    {
+        return InstallError("could not open file '" + std::string(filePath) + "': " + strerror(errno));
+    }
+    int64_t sent = 0;
+#ifndef _WIN32
+    if (!socketData->tlsSession)
+    {
+        off_t fileOffset = offset;
+        while (sent < count)
+        {
+            ssize_t result = sendfile(socketData->socket, fileno(file), &fileOffset, count - sent);
+            if (result == -1)
+            {
+                int errorCode = GetLastSocketError();
+                if (WouldBlock(errorCode) && socketData->nonBlocking)
+                {
+                    break;
+                }
+                std::fclose(file);
+                return InstallError(GetSocketErrorMessage(errorCode));
+            }
+            else if (result == 0)
+            {
+                break;
+            }
+            sent += result;
+        }
+        std::fclose(file);
+        return sent;
+    }
+#endif
+    const int64_t bufferSize = 64 * 1024;
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[bufferSize]);
+#ifdef _WIN32
+    int seekResult = _fseeki64(file, offset, SEEK_SET);
+#else
+    int seekResult = fseeko(file, offset, SEEK_SET);
+#endif
+    if (seekResult != 0)
+    {
+        std::fclose(file);
+        return InstallError("could not seek file '" + std::string(filePath) + "': " + strerror(errno));
+    }
+    while (sent < count)
+    {
+        int32_t n = static_cast<int32_t>(std::fread(buffer.get(), 1, std::min(bufferSize, count - sent), file));
+        if (n == 0)
+        {
+            break;
+        }
+        int32_t written = 0;
+        while (written < n)
+        {
+            bool wouldBlock = false;
+            int32_t result = TrySendSocket(socketHandle, buffer.get() + written, n - written, 0, &wouldBlock);
+            if (result < 0)
+            {
+                std::fclose(file);
+                return result;
+            }
+            if (wouldBlock)
+            {
+                //  The data read from the file is already consumed, so wait until the socket can take it instead of retrying at once.
+                //  A TLS session must be retried with the same data after a would-block.
+                WaitForWritable(socketData->socket);
+                continue;
+            }
+            written += result;
+        }
+        sent += n;
+    }
+    std::fclose(file);
+    return sent;
+}
+
+int64_t SocketTable::GetNativeSocket(int32_t socketHandle)
+{
+    SocketData* socketData = GetSocketData(socketHandle);
+    if (!socketData || socketData->socket == INVALID_SOCKET)
+    {
+        return -1;
+    }
+    return static_cast<int64_t>(socketData->socket);
+}
+
+int64_t GetNativeSocket(int32_t socketHandle)
+{
+    return SocketTable::Instance().GetNativeSocket(socketHandle);
+}
+
 void InitSocket()
 {
     SocketTable::Init();
@@ -843,3 +1268,33 @@ extern "C" RT_API int32_t RtReceiveSocket(int32_t socketHandle, uint8_t* buf, in
 {
     return cmajor::rt::SocketTable::Instance().ReceiveSocket(socketHandle, buf, len, flags);
 }
+
+extern "C" RT_API int32_t RtSetSocketNonBlocking(int32_t socketHandle, bool nonBlocking)
+{
+    return cmajor::rt::SocketTable::Instance().SetSocketNonBlocking(socketHandle, nonBlocking);
+}
+
+extern "C" RT_API int32_t RtTryAcceptSocket(int32_t socketHandle, bool* wouldBlock)
+{
+    return cmajor::rt::SocketTable::Instance().TryAcceptSocket(socketHandle, wouldBlock);
+}
+
+extern "C" RT_API int32_t RtHandshakeSocket(int32_t socketHandle)
+{
+    return cmajor::rt::SocketTable::Instance().HandshakeSocket(socketHandle);
+}
+
+extern "C" RT_API int32_t RtTrySendSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags, bool* wouldBlock)
+{
+    return cmajor::rt::SocketTable::Instance().TrySendSocket(socketHandle, buf, len, flags, wouldBlock);
+}
+
+extern "C" RT_API int32_t RtTryReceiveSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags, bool* wouldBlock)
+{
+    return cmajor::rt::SocketTable::Instance().TryReceiveSocket(socketHandle, buf, len, flags, wouldBlock);
+}
+
+extern "C" RT_API int64_t RtSendFileSocket(int32_t socketHandle, const char* filePath, int64_t offset, int64_t count)
+{
+    return cmajor::rt::SocketTable::Instance().SendFile(socketHandle, filePath, offset, count);
+}
@@ -15,9 +15,24 @@ enum class ShutdownMode : int32_t
 
 enum class ConnectOptions : int32_t
 {
-    none = 0, useTls = 1 << 0
+    none = 0, useTls = 1 << 0, nonBlocking = 1 << 1
 };
 
+enum class SocketEvents : int32_t
+{
+    none = 0, read = 1 << 0, write = 1 << 1, error = 1 << 2, hangup = 1 << 3, timer = 1 << 4, oneShot = 1 << 5, edgeTriggered = 1 << 6
+};
+
+inline SocketEvents operator&(SocketEvents left, SocketEvents right)
+{
+    return SocketEvents(int32_t(left) & int32_t(right));
+}
+
+inline SocketEvents operator|(SocketEvents left, SocketEvents right)
+{
+    return SocketEvents(int32_t(left) | int32_t(right));
+}
+
 inline ConnectOptions operator&(ConnectOptions left, ConnectOptions right)
 {
     return ConnectOptions(int32_t(left) & int32_t(right));
@@ -37,9 +52,16 @@ extern "C" RT_API int32_t RtShutdownSocket(int32_t socketHandle, ShutdownMode mo
 extern "C" RT_API int32_t RtConnectSocket(const char* node, const char* service, ConnectOptions options);
 extern "C" RT_API int32_t RtSendSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags);
 extern "C" RT_API int32_t RtReceiveSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags);
+extern "C" RT_API int32_t RtSetSocketNonBlocking(int32_t socketHandle, bool nonBlocking);
+extern "C" RT_API int32_t RtTryAcceptSocket(int32_t socketHandle, bool* wouldBlock);
+extern "C" RT_API int32_t RtHandshakeSocket(int32_t socketHandle);
+extern "C" RT_API int32_t RtTrySendSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags, bool* wouldBlock);
+extern "C" RT_API int32_t RtTryReceiveSocket(int32_t socketHandle, uint8_t* buf, int32_t len, int32_t flags, bool* wouldBlock);
+extern "C" RT_API int64_t RtSendFileSocket(int32_t socketHandle, const char* filePath, int64_t offset, int64_t count);
 
 namespace cmajor { namespace rt {
 
+int64_t GetNativeSocket(int32_t socketHandle);
 void InitSocket();
 void DoneSocket();
 
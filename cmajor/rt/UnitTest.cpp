@@ -7,7 +7,7 @@
 #include <cmajor/rt/InitDone.hpp>
 #include <cmajor/dom/Document.hpp>
 #include <cmajor/dom/Element.hpp>
-#include <cmajor/util/CodeFormatter.hpp>
+#include <cmajor/dom/Serializer.hpp>
 #include <cmajor/util/Unicode.hpp>
 #include <fstream>
 #include <memory>
@@ -100,9 +100,9 @@ void UnitTestEngine::EndUnitTest(const char* testName, int32_t exitCode)
         testElement->SetAttribute(U"exception", ToUtf32(exceptionStr));
     }
     document.AppendChild(std::unique_ptr<cmajor::dom::Node>(testElement.release()));
-    cmajor::util::CodeFormatter formatter(testXmlFile);
-    formatter.SetIndentSize(2);
-    document.Write(formatter);
+    cmajor::dom::Serializer serializer(testXmlFile);
+    serializer.SetIndentSize(2);
+    serializer.Write(&document);
 }
 
 void UnitTestEngine::SetUnitTestAssertionResult(int32_t assertionIndex, bool assertionResult, int32_t line)
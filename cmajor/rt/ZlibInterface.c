@@ -116,3 +116,69 @@ const char* zlib_retval_str(int32_t retVal)
     }
     return "";
 }
+
+uint32_t zlib_deflate_block_bound(uint32_t inSize)
+{
+    return compressBound(inSize) + 16;
+}
+
+//  Compresses a block as raw deflate data. If last is zero, the block is ended by a sync flush, so the output ends on a byte boundary and 
+//  the outputs of consecutive blocks can be concatenated. The dictionary contains the preceding uncompressed data, if any.
+
+int32_t zlib_deflate_block(int32_t level, void* dictionary, uint32_t dictionarySize, void* in, uint32_t inSize, void* out, uint32_t* outSize, int32_t last)
+{
+    z_stream strm;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    int ret = deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (ret != Z_OK)
+    {
+        return ret;
+    }
+    if (dictionarySize > 0)
+    {
+        ret = deflateSetDictionary(&strm, dictionary, dictionarySize);
+        if (ret != Z_OK)
+        {
+            deflateEnd(&strm);
+            return ret;
+        }
+    }
+    strm.next_in = in;
+    strm.avail_in = inSize;
+    strm.next_out = out;
+    strm.avail_out = *outSize;
+    ret = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+    *outSize = *outSize - strm.avail_out;
+    deflateEnd(&strm);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (strm.avail_in != 0 || (last && ret != Z_STREAM_END))
+    {
+        return Z_BUF_ERROR;
+    }
+    return Z_OK;
+}
+
+uint32_t zlib_crc32(void* data, uint32_t size)
+{
+    return crc32(crc32(0, Z_NULL, 0), data, size);
+}
+
+uint32_t zlib_crc32_combine(uint32_t crc1, uint32_t crc2, int64_t size2)
+{
+    return crc32_combine(crc1, crc2, size2);
+}
+
+uint32_t zlib_adler32(void* data, uint32_t size)
+{
+    return adler32(adler32(0, Z_NULL, 0), data, size);
+}
+
+uint32_t zlib_adler32_combine(uint32_t adler1, uint32_t adler2, int64_t size2)
+{
+    return adler32_combine(adler1, adler2, size2);
+}
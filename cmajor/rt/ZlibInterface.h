@@ -17,6 +17,12 @@ void zlib_set_input(void* inChunk, uint32_t inAvail, void* handle);
 int32_t zlib_deflate(void* outChunk, uint32_t outChunkSize, uint32_t* have, uint32_t* outAvail, void* handle, int32_t flush);
 int32_t zlib_inflate(void* outChunk, uint32_t outChunkSize, uint32_t* have, uint32_t* outAvail, uint32_t* inAvail, void* handle);
 const char* zlib_retval_str(int32_t retVal);
+uint32_t zlib_deflate_block_bound(uint32_t inSize);
+int32_t zlib_deflate_block(int32_t level, void* dictionary, uint32_t dictionarySize, void* in, uint32_t inSize, void* out, uint32_t* outSize, int32_t last);
+uint32_t zlib_crc32(void* data, uint32_t size);
+uint32_t zlib_crc32_combine(uint32_t crc1, uint32_t crc2, int64_t size2);
+uint32_t zlib_adler32(void* data, uint32_t size);
+uint32_t zlib_adler32_combine(uint32_t adler1, uint32_t adler2, int64_t size2);
 
 #ifdef __cplusplus
 }
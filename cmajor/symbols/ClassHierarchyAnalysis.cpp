@@ -0,0 +1,126 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/symbols/ClassHierarchyAnalysis.hpp>
+#include <cmajor/symbols/SymbolTable.hpp>
+#include <cmajor/symbols/ClassTypeSymbol.hpp>
+#include <cmajor/symbols/InterfaceTypeSymbol.hpp>
+#include <cmajor/symbols/FunctionSymbol.hpp>
+#include <algorithm>
+
+namespace cmajor { namespace symbols {
+
+ClassHierarchyAnalysis::ClassHierarchyAnalysis(SymbolTable& symbolTable)
+{
+    for (ClassTypeSymbol* cls : symbolTable.PolymorphicClasses())
+    {
+        if (cls->IsClassTemplate() || cls->IsPrototypeTemplateSpecialization()) continue;
+        auto it = classMap.find(cls->TypeId());
+        if (it != classMap.cend()) continue; // a copy of a class template specialization read from another module
+        classMap[cls->TypeId()] = cls;
+        if (cls->BaseClass())
+        {
+            derivedClassMap[cls->BaseClass()->TypeId()].push_back(cls);
+        }
+        int n = cls->ImplementedInterfaces().size();
+        for (int i = 0; i < n; ++i)
+        {
+            implementingClassMap[cls->ImplementedInterfaces()[i]->TypeId()].push_back(std::make_pair(cls, i));
+        }
+    }
+}
+
+//  A function can be called directly only if its definition is known to be present in some object file of the program.
+//  Inline functions, members of class template specializations and generated functions may be emitted only to the compile units that use them,
+//  so a virtual call to them is left as it is.
+
+bool ClassHierarchyAnalysis::AddTarget(std::vector<FunctionSymbol*>& targets, FunctionSymbol* target)
+{
+    if (!target || target->IsAbstract() || target->IsInline() || target->HasLinkOnceOdrLinkage() || target->IsTemplateSpecialization() || target->IsGeneratedFunction()) return false;
+    if (target->Parent() && target->Parent()->GetSymbolType() == SymbolType::classTemplateSpecializationSymbol) return false;
+    for (FunctionSymbol* prev : targets)
+    {
+        if (prev->MangledName() == target->MangledName()) return true;
+    }
+    if (targets.size() >= maxDevirtualizedTargets) return false;
+    targets.push_back(target);
+    return true;
+}
+
+const std::vector<FunctionSymbol*>& ClassHierarchyAnalysis::GetVirtualCallTargets(ClassTypeSymbol* classType, FunctionSymbol* virtualFunction)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    TargetKey key(classType->TypeId(), virtualFunction->VmtIndex());
+    auto it = virtualCallTargetMap.find(key);
+    if (it != virtualCallTargetMap.cend())
+    {
+        return it->second;
+    }
+    std::vector<FunctionSymbol*>& targets = virtualCallTargetMap[key];
+    if (classMap.find(classType->TypeId()) == classMap.cend() || virtualFunction->VmtIndex() < 0)
+    {
+        return targets;
+    }
+    std::unordered_map<std::u32string, int> numReachingClasses;
+    std::vector<ClassTypeSymbol*> classes;
+    classes.push_back(classMap[classType->TypeId()]);
+    while (!classes.empty())
+    {
+        ClassTypeSymbol* cls = classes.back();
+        classes.pop_back();
+        auto dit = derivedClassMap.find(cls->TypeId());
+        if (dit != derivedClassMap.cend())
+        {
+            classes.insert(classes.end(), dit->second.begin(), dit->second.end());
+        }
+        if (cls->IsAbstract()) continue;
+        const std::vector<FunctionSymbol*>& vmt = cls->Vmt();
+        if (virtualFunction->VmtIndex() >= vmt.size() || !AddTarget(targets, vmt[virtualFunction->VmtIndex()]))
+        {
+            targets.clear();
+            return targets;
+        }
+        ++numReachingClasses[vmt[virtualFunction->VmtIndex()]->MangledName()];
+    }
+    std::sort(targets.begin(), targets.end(), [&](FunctionSymbol* left, FunctionSymbol* right) 
+    {
+        int l = numReachingClasses[left->MangledName()];
+        int r = numReachingClasses[right->MangledName()];
+        if (l > r) return true;
+        if (l < r) return false;
+        return left->MangledName() < right->MangledName();
+    });
+    return targets;
+}
+
+const std::vector<FunctionSymbol*>& ClassHierarchyAnalysis::GetInterfaceCallTargets(InterfaceTypeSymbol* interfaceType, MemberFunctionSymbol* interfaceMemberFunction)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    TargetKey key(interfaceType->TypeId(), interfaceMemberFunction->ImtIndex());
+    auto it = interfaceCallTargetMap.find(key);
+    if (it != interfaceCallTargetMap.cend())
+    {
+        return it->second;
+    }
+    std::vector<FunctionSymbol*>& targets = interfaceCallTargetMap[key];
+    auto iit = implementingClassMap.find(interfaceType->TypeId());
+    if (iit == implementingClassMap.cend() || interfaceMemberFunction->ImtIndex() < 0)
+    {
+        return targets;
+    }
+    for (const std::pair<ClassTypeSymbol*, int>& implementingClass : iit->second)
+    {
+        const std::vector<FunctionSymbol*>& imt = implementingClass.first->Imt(implementingClass.second);
+        if (interfaceMemberFunction->ImtIndex() >= imt.size() || !AddTarget(targets, imt[interfaceMemberFunction->ImtIndex()]))
+        {
+            targets.clear();
+            return targets;
+        }
+    }
+    std::sort(targets.begin(), targets.end(), [](FunctionSymbol* left, FunctionSymbol* right) { return left->MangledName() < right->MangledName(); });
+    return targets;
+}
+
+} } // namespace cmajor::symbols
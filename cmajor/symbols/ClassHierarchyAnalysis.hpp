@@ -0,0 +1,66 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#ifndef CMAJOR_SYMBOLS_CLASS_HIERARCHY_ANALYSIS_INCLUDED
+#define CMAJOR_SYMBOLS_CLASS_HIERARCHY_ANALYSIS_INCLUDED
+#include <boost/uuid/uuid.hpp>
+#include <boost/functional/hash.hpp>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <utility>
+
+namespace cmajor { namespace symbols {
+
+class SymbolTable;
+class ClassTypeSymbol;
+class InterfaceTypeSymbol;
+class FunctionSymbol;
+class MemberFunctionSymbol;
+
+//  ================================================================================================
+//  Class hierarchy analysis over the polymorphic classes of a program. It is built when compiling
+//  a program after the statements of all compile units have been bound, so that every class whose
+//  object can exist at run time is known. The code generator uses it to turn virtual and interface
+//  calls that can reach only one or two functions into direct calls.
+//  ================================================================================================
+
+const int maxDevirtualizedTargets = 2;
+
+class ClassHierarchyAnalysis
+{
+public:
+    ClassHierarchyAnalysis(SymbolTable& symbolTable);
+    ClassHierarchyAnalysis(const ClassHierarchyAnalysis&) = delete;
+    ClassHierarchyAnalysis& operator=(const ClassHierarchyAnalysis&) = delete;
+    //  Returns the distinct functions that a virtual call of virtualFunction through a pointer to classType can reach, or an empty vector if 
+    //  the call cannot be devirtualized, because there are more than maxDevirtualizedTargets of them or because some of them cannot be called directly.
+    const std::vector<FunctionSymbol*>& GetVirtualCallTargets(ClassTypeSymbol* classType, FunctionSymbol* virtualFunction);
+    //  Returns the distinct functions that a call of interfaceMemberFunction through an interface object of interfaceType can reach, or an empty vector.
+    const std::vector<FunctionSymbol*>& GetInterfaceCallTargets(InterfaceTypeSymbol* interfaceType, MemberFunctionSymbol* interfaceMemberFunction);
+    int NumClasses() const { return int(classMap.size()); }
+private:
+    typedef std::pair<boost::uuids::uuid, int> TargetKey;
+    struct TargetKeyHash
+    {
+        size_t operator()(const TargetKey& key) const
+        {
+            size_t x = boost::hash<boost::uuids::uuid>()(key.first);
+            boost::hash_combine(x, key.second);
+            return x;
+        }
+    };
+    std::unordered_map<boost::uuids::uuid, ClassTypeSymbol*, boost::hash<boost::uuids::uuid>> classMap;
+    std::unordered_map<boost::uuids::uuid, std::vector<ClassTypeSymbol*>, boost::hash<boost::uuids::uuid>> derivedClassMap;
+    std::unordered_map<boost::uuids::uuid, std::vector<std::pair<ClassTypeSymbol*, int>>, boost::hash<boost::uuids::uuid>> implementingClassMap;
+    std::unordered_map<TargetKey, std::vector<FunctionSymbol*>, TargetKeyHash> virtualCallTargetMap;
+    std::unordered_map<TargetKey, std::vector<FunctionSymbol*>, TargetKeyHash> interfaceCallTargetMap;
+    std::mutex mtx;
+    bool AddTarget(std::vector<FunctionSymbol*>& targets, FunctionSymbol* target);
+};
+
+} } // namespace cmajor::symbols
+
+#endif // CMAJOR_SYMBOLS_CLASS_HIERARCHY_ANALYSIS_INCLUDED
@@ -205,6 +205,7 @@ void ClassTypeSymbol::Write(SymbolWriter& writer)
     {
         writer.GetBinaryWriter().Write(type->TypeId());
     }
+    writer.GetBinaryWriter().Write(ObjectNameDigest());
 }
 
 const int prototypeIndex = 1000000;
@@ -328,6 +329,7 @@ void ClassTypeSymbol::Read(SymbolReader& reader)
         reader.GetBinaryReader().ReadUuid(typeId);
         reader.GetSymbolTable()->EmplaceTypeRequest(reader, this, typeId, staticLayoutIndex + i);
     }
+    objectNameDigest = reader.GetBinaryReader().ReadUtf8String();
     if (IsPolymorphic() && !IsPrototypeTemplateSpecialization())
     {
         reader.GetSymbolTable()->AddPolymorphicClass(this);
@@ -1252,6 +1254,10 @@ llvm::Constant* ClassTypeSymbol::CreateDefaultIrValue(Emitter& emitter)
 
 llvm::DIType* ClassTypeSymbol::CreateDIType(Emitter& emitter)
 {
+    if (IsPolymorphic() && !emitter.IsClassDefined(TypeId()))
+    {
+        return CreateDIDeclaration(emitter);
+    }
     llvm::DIType* baseClassDIType = nullptr;
     if (baseClass)
     {
@@ -1301,9 +1307,42 @@ llvm::DIType* ClassTypeSymbol::CreateDIForwardDeclaration(Emitter& emitter)
         0, sizeInBits, alignInBits, llvm::DINode::DIFlags::FlagZero, ToUtf8(MangledName()));
 }
 
+llvm::DIType* ClassTypeSymbol::CreateDIDeclaration(Emitter& emitter)
+{
+    Span classSpan = GetSpan();
+    if (GetSymbolType() == SymbolType::classTemplateSpecializationSymbol)
+    {
+        ClassTemplateSpecializationSymbol* specialization = static_cast<ClassTemplateSpecializationSymbol*>(this);
+        classSpan = specialization->GetClassTemplate()->GetSpan();
+    }
+    const llvm::StructLayout* structLayout = emitter.DataLayout()->getStructLayout(llvm::cast<llvm::StructType>(IrType(emitter)));
+    uint64_t sizeInBits = structLayout->getSizeInBits();
+    uint32_t alignInBits = 8 * structLayout->getAlignment();
+    return emitter.DIBuilder()->createForwardDecl(llvm::dwarf::DW_TAG_class_type, ToUtf8(Name()), nullptr, emitter.GetFile(classSpan.FileIndex()), classSpan.LineNumber(),
+        0, sizeInBits, alignInBits, ToUtf8(MangledName()));
+}
+
+//  The digest of the full name is the common suffix of the vmt, imt, imts and statics object names of the class.
+//  It is computed once per class and written to the module file, so imported classes do not need to hash their names again.
+//  Code is generated for compile units in parallel, so the first use of the digest of a class may happen concurrently in several threads.
+
+const std::string& ClassTypeSymbol::ObjectNameDigest()
+{
+    std::call_once(objectNameDigestFlag, &ClassTypeSymbol::ComputeObjectNameDigest, this);
+    return objectNameDigest;
+}
+
+void ClassTypeSymbol::ComputeObjectNameDigest()
+{
+    if (objectNameDigest.empty())
+    {
+        objectNameDigest = GetSha1MessageDigest(ToUtf8(FullNameWithSpecifiers()));
+    }
+}
+
 std::string ClassTypeSymbol::VmtObjectNameStr()
 {
-    return "vmt_" + ToUtf8(SimpleName()) + "_" + GetSha1MessageDigest(ToUtf8(FullNameWithSpecifiers()));;
+    return "vmt_" + ToUtf8(SimpleName()) + "_" + ObjectNameDigest();
 }
 
 std::string ClassTypeSymbol::VmtObjectName(Emitter& emitter)
@@ -1322,7 +1361,7 @@ std::string ClassTypeSymbol::ImtArrayObjectName(Emitter& emitter)
     std::string localImtArrayObjectName = emitter.GetImtArrayObjectName(this);
     if (localImtArrayObjectName.empty())
     {
-        localImtArrayObjectName = "imts_" + ToUtf8(SimpleName()) + "_" + GetSha1MessageDigest(ToUtf8(FullNameWithSpecifiers()));
+        localImtArrayObjectName = "imts_" + ToUtf8(SimpleName()) + "_" + ObjectNameDigest();
         emitter.SetImtArrayObjectName(this, localImtArrayObjectName);
     }
     return localImtArrayObjectName;
@@ -1330,7 +1369,7 @@ std::string ClassTypeSymbol::ImtArrayObjectName(Emitter& emitter)
 
 std::string ClassTypeSymbol::ImtObjectName(int index)
 { 
-    return "imt_" + std::to_string(index) + "_" + ToUtf8(SimpleName()) + "_" + GetSha1MessageDigest(ToUtf8(FullNameWithSpecifiers()));
+    return "imt_" + std::to_string(index) + "_" + ToUtf8(SimpleName()) + "_" + ObjectNameDigest();
 }
 
 ClassTypeSymbol* ClassTypeSymbol::VmtPtrHolderClass() 
@@ -1501,7 +1540,7 @@ std::string ClassTypeSymbol::StaticObjectName(Emitter& emitter)
     std::string localStaticObjectName = emitter.GetStaticObjectName(this);
     if (localStaticObjectName.empty())
     {
-        localStaticObjectName = "statics_" + ToUtf8(SimpleName()) + "_" + GetSha1MessageDigest(ToUtf8(FullNameWithSpecifiers()));
+        localStaticObjectName = "statics_" + ToUtf8(SimpleName()) + "_" + ObjectNameDigest();
         emitter.SetStaticObjectName(this, localStaticObjectName);
     }
     return localStaticObjectName;
@@ -9,6 +9,7 @@
 #include <cmajor/symbols/VariableSymbol.hpp>
 #include <cmajor/ast/Class.hpp>
 #include <cmajor/ast/Constant.hpp>
+#include <mutex>
 
 namespace cmajor { namespace symbols {
 
@@ -167,16 +168,19 @@ public:
     void CreateLayouts();
     const std::vector<TypeSymbol*>& ObjectLayout() const { return objectLayout; }
     const std::vector<FunctionSymbol*>& Vmt() const { return vmt; }
+    const std::vector<FunctionSymbol*>& Imt(int index) const { return imts[index]; }
     llvm::Type* IrType(Emitter& emitter) override;
     llvm::Constant* CreateDefaultIrValue(Emitter& emitter) override;
     llvm::DIType* CreateDIType(Emitter& emitter) override; 
     llvm::DIType* CreateDIForwardDeclaration(Emitter& emitter);
+    llvm::DIType* CreateDIDeclaration(Emitter& emitter);
     llvm::Value* VmtObject(Emitter& emitter, bool create);
     llvm::Type* VmtPtrType(Emitter& emitter);
     std::string VmtObjectName(Emitter& emitter);
     std::string VmtObjectNameStr();
     std::string ImtArrayObjectName(Emitter& emitter);
     std::string ImtObjectName(int index);
+    const std::string& ObjectNameDigest();
     int32_t VmtPtrIndex() const { return vmtPtrIndex; }
     ClassTypeSymbol* VmtPtrHolderClass();
     llvm::Value* StaticObject(Emitter& emitter, bool create);
@@ -218,6 +222,9 @@ private:
     std::unique_ptr<ClassNode> classNode;
     std::unique_ptr<ConstraintNode> constraint;
     ClassTemplateSpecializationSymbol* prototype;
+    std::once_flag objectNameDigestFlag;
+    std::string objectNameDigest;
+    void ComputeObjectNameDigest();
     void InitVmt(std::vector<FunctionSymbol*>& vmtToInit);
     llvm::Value* CreateImt(Emitter& emitter, int index);
     llvm::Value* CreateImts(Emitter& emitter);
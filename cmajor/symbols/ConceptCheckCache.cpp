@@ -0,0 +1,48 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/symbols/ConceptCheckCache.hpp>
+
+namespace cmajor { namespace symbols {
+
+ConceptCheckKey::ConceptCheckKey(ConceptSymbol* conceptSymbol, const std::vector<TypeSymbol*>& typeArguments, const LookupScopeKey& lookupScopeKey_) : lookupScopeKey(lookupScopeKey_)
+{
+    typeIds.push_back(conceptSymbol->TypeId());
+    for (TypeSymbol* typeArgument : typeArguments)
+    {
+        typeIds.push_back(typeArgument->TypeId());
+    }
+}
+
+bool ConceptCheckKey::operator<(const ConceptCheckKey& that) const
+{
+    if (typeIds < that.typeIds) return true;
+    if (that.typeIds < typeIds) return false;
+    return lookupScopeKey < that.lookupScopeKey;
+}
+
+ConceptCheckCache::ConceptCheckCache()
+{
+}
+
+bool ConceptCheckCache::GetResult(const ConceptCheckKey& key, ConceptCheckResult& result)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = resultMap.find(key);
+    if (it != resultMap.cend())
+    {
+        result = it->second;
+        return true;
+    }
+    return false;
+}
+
+void ConceptCheckCache::SetResult(const ConceptCheckKey& key, const ConceptCheckResult& result)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    resultMap[key] = result;
+}
+
+} } // namespace cmajor::symbols
@@ -0,0 +1,79 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#ifndef CMAJOR_SYMBOLS_CONCEPT_CHECK_CACHE_INCLUDED
+#define CMAJOR_SYMBOLS_CONCEPT_CHECK_CACHE_INCLUDED
+#include <cmajor/symbols/ConceptSymbol.hpp>
+#include <cmajor/symbols/TypeSymbol.hpp>
+#include <cmajor/symbols/Scope.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <map>
+#include <vector>
+#include <mutex>
+
+namespace cmajor { namespace symbols {
+
+//  ================================================================================================
+//  Project wide cache of the results of checking whether types fulfill the requirements of a 
+//  concept, keyed by the type ids of the concept and the type arguments, and by the scopes that
+//  names were looked up from. The results are stored as plain data instead of bound constraints, 
+//  because bound nodes are allocated from the arena of the compile unit that created them and go 
+//  away with it. The cache is shared by the compile units of a module that may be bound in 
+//  parallel, so it is protected by a mutex.
+//  ================================================================================================
+
+enum class ConceptCheckConstraintKind : uint8_t
+{
+    atomic, disjunctive, conjunctive
+};
+
+struct ConceptCheckConstraint
+{
+    ConceptCheckConstraint(ConceptCheckConstraintKind kind_, bool satisfied_, ConceptSymbol* conceptSymbol_) : kind(kind_), satisfied(satisfied_), conceptSymbol(conceptSymbol_) {}
+    ConceptCheckConstraintKind kind;
+    bool satisfied;
+    ConceptSymbol* conceptSymbol;
+};
+
+struct ConceptCheckResult
+{
+    ConceptCheckResult() : satisfied(false), commonType(nullptr), hasError(false) {}
+    bool satisfied;
+    //  Bound constraint of the concept in prefix order: a binary constraint is followed by its left and right operands.
+    std::vector<ConceptCheckConstraint> constraint;
+    TypeSymbol* commonType;
+    //  Error of an unsatisfied concept. Spans equal to errorSpan refer to the location of the check that failed.
+    bool hasError;
+    std::string errorMessage;
+    Span errorSpan;
+    std::vector<Span> errorReferences;
+};
+
+class ConceptCheckKey
+{
+public:
+    ConceptCheckKey(ConceptSymbol* conceptSymbol, const std::vector<TypeSymbol*>& typeArguments, const LookupScopeKey& lookupScopeKey_);
+    bool operator<(const ConceptCheckKey& that) const;
+private:
+    std::vector<boost::uuids::uuid> typeIds;
+    LookupScopeKey lookupScopeKey;
+};
+
+class ConceptCheckCache
+{
+public:
+    ConceptCheckCache();
+    ConceptCheckCache(const ConceptCheckCache&) = delete;
+    ConceptCheckCache& operator=(const ConceptCheckCache&) = delete;
+    bool GetResult(const ConceptCheckKey& key, ConceptCheckResult& result);
+    void SetResult(const ConceptCheckKey& key, const ConceptCheckResult& result);
+private:
+    std::map<ConceptCheckKey, ConceptCheckResult> resultMap;
+    std::mutex mtx;
+};
+
+} } // namespace cmajor::symbols
+
+#endif // CMAJOR_SYMBOLS_CONCEPT_CHECK_CACHE_INCLUDED
@@ -0,0 +1,129 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/symbols/ConstExprCallCache.hpp>
+#include <cstring>
+
+namespace cmajor { namespace symbols {
+
+bool IsScalarValue(Value* value)
+{
+    ValueType valueType = value->GetValueType();
+    return valueType >= ValueType::boolValue && valueType <= ValueType::ucharValue;
+}
+
+template<typename ValueT>
+uint64_t ScalarBits(Value* value)
+{
+    typename ValueT::OperandType operand = static_cast<ValueT*>(value)->GetValue();
+    uint64_t bits = 0;
+    std::memcpy(&bits, &operand, sizeof(operand));
+    return bits;
+}
+
+uint64_t GetScalarBits(Value* value)
+{
+    switch (value->GetValueType())
+    {
+        case ValueType::boolValue: return ScalarBits<BoolValue>(value);
+        case ValueType::sbyteValue: return ScalarBits<SByteValue>(value);
+        case ValueType::byteValue: return ScalarBits<ByteValue>(value);
+        case ValueType::shortValue: return ScalarBits<ShortValue>(value);
+        case ValueType::ushortValue: return ScalarBits<UShortValue>(value);
+        case ValueType::intValue: return ScalarBits<IntValue>(value);
+        case ValueType::uintValue: return ScalarBits<UIntValue>(value);
+        case ValueType::longValue: return ScalarBits<LongValue>(value);
+        case ValueType::ulongValue: return ScalarBits<ULongValue>(value);
+        case ValueType::floatValue: return ScalarBits<FloatValue>(value);
+        case ValueType::doubleValue: return ScalarBits<DoubleValue>(value);
+        case ValueType::charValue: return ScalarBits<CharValue>(value);
+        case ValueType::wcharValue: return ScalarBits<WCharValue>(value);
+        case ValueType::ucharValue: return ScalarBits<UCharValue>(value);
+        default: return 0;
+    }
+}
+
+template<typename ValueT>
+Value* MakeScalar(uint64_t bits, const Span& span)
+{
+    typename ValueT::OperandType operand;
+    std::memcpy(&operand, &bits, sizeof(operand));
+    return new ValueT(span, operand);
+}
+
+Value* MakeScalarValue(ValueType valueType, uint64_t bits, const Span& span)
+{
+    switch (valueType)
+    {
+        case ValueType::boolValue: return MakeScalar<BoolValue>(bits, span);
+        case ValueType::sbyteValue: return MakeScalar<SByteValue>(bits, span);
+        case ValueType::byteValue: return MakeScalar<ByteValue>(bits, span);
+        case ValueType::shortValue: return MakeScalar<ShortValue>(bits, span);
+        case ValueType::ushortValue: return MakeScalar<UShortValue>(bits, span);
+        case ValueType::intValue: return MakeScalar<IntValue>(bits, span);
+        case ValueType::uintValue: return MakeScalar<UIntValue>(bits, span);
+        case ValueType::longValue: return MakeScalar<LongValue>(bits, span);
+        case ValueType::ulongValue: return MakeScalar<ULongValue>(bits, span);
+        case ValueType::floatValue: return MakeScalar<FloatValue>(bits, span);
+        case ValueType::doubleValue: return MakeScalar<DoubleValue>(bits, span);
+        case ValueType::charValue: return MakeScalar<CharValue>(bits, span);
+        case ValueType::wcharValue: return MakeScalar<WCharValue>(bits, span);
+        case ValueType::ucharValue: return MakeScalar<UCharValue>(bits, span);
+        default: return nullptr;
+    }
+}
+
+ConstExprCallKey::ConstExprCallKey(FunctionSymbol* function_, const std::vector<TypeSymbol*>& templateTypeArguments_, ValueType targetValueType_, bool cast_, 
+    const LookupScopeKey& lookupScopeKey_) : function(function_), templateTypeArguments(templateTypeArguments_), targetValueType(targetValueType_), cast(cast_), lookupScopeKey(lookupScopeKey_)
+{
+}
+
+bool ConstExprCallKey::AddArgument(Value* argument)
+{
+    if (!IsScalarValue(argument)) return false;
+    arguments.push_back(std::make_pair(argument->GetValueType(), GetScalarBits(argument)));
+    return true;
+}
+
+bool ConstExprCallKey::operator<(const ConstExprCallKey& that) const
+{
+    if (function < that.function) return true;
+    if (that.function < function) return false;
+    if (targetValueType < that.targetValueType) return true;
+    if (that.targetValueType < targetValueType) return false;
+    if (cast < that.cast) return true;
+    if (that.cast < cast) return false;
+    if (templateTypeArguments < that.templateTypeArguments) return true;
+    if (that.templateTypeArguments < templateTypeArguments) return false;
+    if (arguments < that.arguments) return true;
+    if (that.arguments < arguments) return false;
+    return lookupScopeKey < that.lookupScopeKey;
+}
+
+ConstExprCallCache::ConstExprCallCache()
+{
+}
+
+std::unique_ptr<Value> ConstExprCallCache::GetResult(const ConstExprCallKey& key, const Span& span)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = resultMap.find(key);
+    if (it != resultMap.cend())
+    {
+        const std::pair<ValueType, uint64_t>& result = it->second;
+        return std::unique_ptr<Value>(MakeScalarValue(result.first, result.second, span));
+    }
+    return std::unique_ptr<Value>();
+}
+
+void ConstExprCallCache::SetResult(const ConstExprCallKey& key, Value* result)
+{
+    if (!result || !IsScalarValue(result)) return;
+    std::lock_guard<std::mutex> lock(mtx);
+    if (resultMap.size() >= maxConstExprCallCacheSize) return;
+    resultMap[key] = std::make_pair(result->GetValueType(), GetScalarBits(result));
+}
+
+} } // namespace cmajor::symbols
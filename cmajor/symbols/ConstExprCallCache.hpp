@@ -0,0 +1,67 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#ifndef CMAJOR_SYMBOLS_CONST_EXPR_CALL_CACHE_INCLUDED
+#define CMAJOR_SYMBOLS_CONST_EXPR_CALL_CACHE_INCLUDED
+#include <cmajor/symbols/Value.hpp>
+#include <cmajor/symbols/Scope.hpp>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <utility>
+
+namespace cmajor { namespace symbols {
+
+class FunctionSymbol;
+
+//  ================================================================================================
+//  Project wide cache of the results of compile-time evaluated constexpr function calls. A call is
+//  memoized only if its arguments and result are scalar values, that is, values of the basic value
+//  types, so that a cached result does not refer to arrays, structures or pointers owned by some
+//  other evaluation. Names in the function body are looked up also from the file scopes of the 
+//  calling compile unit, so the key includes the contents of those file scopes. The scope of the
+//  caller itself is not part of the key: it does not affect the evaluation of the body and may be
+//  a local block that does not outlive the call. The cache is shared by the compile units of a
+//  module that may be bound in parallel, so it is protected by a mutex.
+//  ================================================================================================
+
+const int maxConstExprCallCacheSize = 1024 * 1024;
+
+bool IsScalarValue(Value* value);
+
+class ConstExprCallKey
+{
+public:
+    ConstExprCallKey(FunctionSymbol* function_, const std::vector<TypeSymbol*>& templateTypeArguments_, ValueType targetValueType_, bool cast_, const LookupScopeKey& lookupScopeKey_);
+    //  Adds an argument value to the key. Returns false if the value is not a scalar value, in which case the call cannot be memoized.
+    bool AddArgument(Value* argument);
+    bool operator<(const ConstExprCallKey& that) const;
+private:
+    FunctionSymbol* function;
+    std::vector<TypeSymbol*> templateTypeArguments;
+    ValueType targetValueType;
+    bool cast;
+    std::vector<std::pair<ValueType, uint64_t>> arguments;
+    LookupScopeKey lookupScopeKey;
+};
+
+class ConstExprCallCache
+{
+public:
+    ConstExprCallCache();
+    ConstExprCallCache(const ConstExprCallCache&) = delete;
+    ConstExprCallCache& operator=(const ConstExprCallCache&) = delete;
+    //  Returns the memoized result of a call located at span, or null if the call has not been memoized.
+    std::unique_ptr<Value> GetResult(const ConstExprCallKey& key, const Span& span);
+    //  Memoizes the result of a call if it is a scalar value.
+    void SetResult(const ConstExprCallKey& key, Value* result);
+private:
+    std::map<ConstExprCallKey, std::pair<ValueType, uint64_t>> resultMap;
+    std::mutex mtx;
+};
+
+} } // namespace cmajor::symbols
+
+#endif // CMAJOR_SYMBOLS_CONST_EXPR_CALL_CACHE_INCLUDED
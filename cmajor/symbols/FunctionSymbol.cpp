@@ -869,12 +869,19 @@ void FunctionSymbol::GenerateVirtualCall(Emitter& emitter, std::vector<GenObject
     Assert(type->BaseType()->IsClassTypeSymbol(), "class type pointer expected");
     ClassTypeSymbol* classType = static_cast<ClassTypeSymbol*>(type->BaseType());
     ClassTypeSymbol* vmtPtrHolderClass = classType->VmtPtrHolderClass();
+    std::vector<FunctionSymbol*> targets;
+    ClassHierarchyAnalysis* classHierarchyAnalysis = GetRootModuleForCurrentThread()->GetClassHierarchyAnalysis();
+    if (classHierarchyAnalysis)
+    {
+        targets = classHierarchyAnalysis->GetVirtualCallTargets(classType, this);
+    }
     llvm::Value* callee = nullptr;
+    llvm::Value* funAsVoidPtr = nullptr;
     for (int i = 0; i < na; ++i)
     {
         GenObject* genObject = genObjects[i];
         genObject->Load(emitter, OperationFlags::none);
-        if (i == 0)
+        if (i == 0 && targets.size() != 1)
         {
             emitter.Stack().Dup();
             llvm::Value* thisPtr = emitter.Stack().Pop();
@@ -891,7 +898,7 @@ void FunctionSymbol::GenerateVirtualCall(Emitter& emitter, std::vector<GenObject
             funPtrIndeces.push_back(emitter.Builder().getInt32(0));
             funPtrIndeces.push_back(emitter.Builder().getInt32(VmtIndex() + functionVmtIndexOffset));
             llvm::Value* funPtrPtr = emitter.Builder().CreateGEP(vmtPtr, funPtrIndeces);
-            llvm::Value* funAsVoidPtr = emitter.Builder().CreateLoad(funPtrPtr);
+            funAsVoidPtr = emitter.Builder().CreateLoad(funPtrPtr);
             callee = emitter.Builder().CreateBitCast(funAsVoidPtr, llvm::PointerType::get(IrType(emitter), 0));
         }
     }
@@ -908,6 +915,31 @@ void FunctionSymbol::GenerateVirtualCall(Emitter& emitter, std::vector<GenObject
         args[n - i - 1] = arg;
     }
     emitter.SetCurrentDebugLocation(span);
+    llvm::Value* result = nullptr;
+    if (targets.size() == 1)
+    {
+        result = GenerateDirectCallInst(emitter, targets[0], args, DontThrow(), span);
+    }
+    else if (targets.size() == 2)
+    {
+        result = GenerateGuardedCallInst(emitter, funAsVoidPtr, callee, targets[0], args, DontThrow(), span);
+    }
+    else
+    {
+        result = GenerateCallInst(emitter, callee, args, DontThrow(), span);
+    }
+    if (result)
+    {
+        emitter.Stack().Push(result);
+    }
+}
+
+//  Generates a call or an invoke instruction for calling this function through the given callee and returns the call result,
+//  or null if the function does not return a value in a register. The nothrow flag is that of the called virtual function or interface, not that of the target.
+
+llvm::Value* FunctionSymbol::GenerateCallInst(Emitter& emitter, llvm::Value* callee, ArgVector& args, bool nothrow, const Span& span)
+{
+    llvm::Value* result = nullptr;
     llvm::BasicBlock* handlerBlock = emitter.HandlerBlock();
     llvm::BasicBlock* cleanupBlock = emitter.CleanupBlock();
     bool newCleanupNeeded = emitter.NewCleanupNeeded();
@@ -919,100 +951,102 @@ void FunctionSymbol::GenerateVirtualCall(Emitter& emitter, std::vector<GenObject
         inputs.push_back(currentPad->value);
         bundles.push_back(llvm::OperandBundleDef("funclet", inputs));
     }
-    if (ReturnType() && !ReturnType()->IsVoidType() && !ReturnsClassInterfaceOrClassDelegateByValue())
+    if (nothrow || (!handlerBlock && !cleanupBlock && !newCleanupNeeded))
     {
-        if (DontThrow() || (!handlerBlock && !cleanupBlock && !newCleanupNeeded))
+        if (currentPad == nullptr)
         {
-            if (currentPad == nullptr)
-            {
-                emitter.Stack().Push(emitter.Builder().CreateCall(IrType(emitter), callee, args));
-            }
-            else
-            {
-                llvm::CallInst* callInst = llvm::CallInst::Create(callee, args, bundles, "", emitter.CurrentBasicBlock());
-                if (emitter.DIBuilder())
-                {
-                    callInst->setDebugLoc(emitter.GetDebugLocation(span));
-                }
-                emitter.Stack().Push(callInst);
-            }
+            result = emitter.Builder().CreateCall(callee, args);
         }
         else
         {
-            llvm::BasicBlock* nextBlock = llvm::BasicBlock::Create(emitter.Context(), "next", emitter.Function());
-            if (newCleanupNeeded)
-            {
-                emitter.CreateCleanup();
-                cleanupBlock = emitter.CleanupBlock();
-            }
-            llvm::BasicBlock* unwindBlock = cleanupBlock;
-            if (unwindBlock == nullptr)
-            {
-                unwindBlock = handlerBlock;
-                Assert(unwindBlock, "no unwind block");
-            }
-            if (currentPad == nullptr)
+            llvm::CallInst* callInst = llvm::CallInst::Create(callee, args, bundles, "", emitter.CurrentBasicBlock());
+            if (emitter.DIBuilder())
             {
-                emitter.Stack().Push(emitter.Builder().CreateInvoke(callee, nextBlock, unwindBlock, args));
+                callInst->setDebugLoc(emitter.GetDebugLocation(span));
             }
-            else
-            {
-                llvm::InvokeInst* invokeInst = llvm::InvokeInst::Create(callee, nextBlock, unwindBlock, args, bundles, "", emitter.CurrentBasicBlock());
-                if (emitter.DIBuilder())
-                {
-                    invokeInst->setDebugLoc(emitter.GetDebugLocation(span));
-                }
-                emitter.Stack().Push(invokeInst);
-            }
-            emitter.SetCurrentBasicBlock(nextBlock);
+            result = callInst;
         }
     }
     else
     {
-        if (DontThrow() || (!handlerBlock && !cleanupBlock && !newCleanupNeeded))
+        llvm::BasicBlock* nextBlock = llvm::BasicBlock::Create(emitter.Context(), "next", emitter.Function());
+        if (newCleanupNeeded)
         {
-            if (currentPad == nullptr)
-            {
-                emitter.Builder().CreateCall(IrType(emitter), callee, args);
-            }
-            else
-            {
-                llvm::CallInst* callInst = llvm::CallInst::Create(callee, args, bundles, "", emitter.CurrentBasicBlock());
-                if (emitter.DIBuilder())
-                {
-                    callInst->setDebugLoc(emitter.GetDebugLocation(span));
-                }
-            }
+            emitter.CreateCleanup();
+            cleanupBlock = emitter.CleanupBlock();
+        }
+        llvm::BasicBlock* unwindBlock = cleanupBlock;
+        if (unwindBlock == nullptr)
+        {
+            unwindBlock = handlerBlock;
+            Assert(unwindBlock, "no unwind block");
+        }
+        if (currentPad == nullptr)
+        {
+            result = emitter.Builder().CreateInvoke(callee, nextBlock, unwindBlock, args);
         }
         else
         {
-            llvm::BasicBlock* nextBlock = llvm::BasicBlock::Create(emitter.Context(), "next", emitter.Function());
-            if (newCleanupNeeded)
-            {
-                emitter.CreateCleanup();
-                cleanupBlock = emitter.CleanupBlock();
-            }
-            llvm::BasicBlock* unwindBlock = cleanupBlock;
-            if (unwindBlock == nullptr)
-            {
-                unwindBlock = handlerBlock;
-                Assert(unwindBlock, "no unwind block");
-            }
-            if (currentPad == nullptr)
+            llvm::InvokeInst* invokeInst = llvm::InvokeInst::Create(callee, nextBlock, unwindBlock, args, bundles, "", emitter.CurrentBasicBlock());
+            if (emitter.DIBuilder())
             {
-                emitter.Builder().CreateInvoke(callee, nextBlock, unwindBlock, args);
+                invokeInst->setDebugLoc(emitter.GetDebugLocation(span));
             }
-            else
-            {
-                llvm::InvokeInst* invokeInst = llvm::InvokeInst::Create(callee, nextBlock, unwindBlock, args, bundles, "", emitter.CurrentBasicBlock());
-                if (emitter.DIBuilder())
-                {
-                    invokeInst->setDebugLoc(emitter.GetDebugLocation(span));
-                }
-            }
-            emitter.SetCurrentBasicBlock(nextBlock);
+            result = invokeInst;
         }
+        emitter.SetCurrentBasicBlock(nextBlock);
+    }
+    if (ReturnType() && ReturnType()->GetSymbolType() != SymbolType::voidTypeSymbol && !ReturnsClassInterfaceOrClassDelegateByValue())
+    {
+        return result;
+    }
+    return nullptr;
+}
+
+//  Calls target directly instead of calling this function through a method table. The first argument is the object pointer that is converted to the 
+//  this pointer type of the target.
+
+llvm::Value* FunctionSymbol::GenerateDirectCallInst(Emitter& emitter, FunctionSymbol* target, ArgVector& args, bool nothrow, const Span& span)
+{
+    llvm::FunctionType* targetType = target->IrType(emitter);
+    llvm::Function* targetFunction = llvm::cast<llvm::Function>(emitter.Module()->getOrInsertFunction(ToUtf8(target->MangledName()), targetType));
+    ArgVector directArgs(args);
+    if (!directArgs.empty() && targetType->getNumParams() > 0 && directArgs[0]->getType() != targetType->getParamType(0))
+    {
+        directArgs[0] = emitter.Builder().CreateBitCast(directArgs[0], targetType->getParamType(0));
+    }
+    return GenerateCallInst(emitter, targetFunction, directArgs, nothrow, span);
+}
+
+//  Speculative devirtualization: if the function pointer loaded from the method table is the expected target, the target is called directly, 
+//  otherwise the call goes through the loaded function pointer.
+
+llvm::Value* FunctionSymbol::GenerateGuardedCallInst(Emitter& emitter, llvm::Value* calleeAsVoidPtr, llvm::Value* callee, FunctionSymbol* target, ArgVector& args, bool nothrow, 
+    const Span& span)
+{
+    llvm::Function* targetFunction = llvm::cast<llvm::Function>(emitter.Module()->getOrInsertFunction(ToUtf8(target->MangledName()), target->IrType(emitter)));
+    llvm::Value* isTarget = emitter.Builder().CreateICmpEQ(calleeAsVoidPtr, emitter.Builder().CreateBitCast(targetFunction, emitter.Builder().getInt8PtrTy()));
+    llvm::BasicBlock* directBlock = llvm::BasicBlock::Create(emitter.Context(), "direct", emitter.Function());
+    llvm::BasicBlock* indirectBlock = llvm::BasicBlock::Create(emitter.Context(), "indirect", emitter.Function());
+    llvm::BasicBlock* nextBlock = llvm::BasicBlock::Create(emitter.Context(), "next", emitter.Function());
+    emitter.Builder().CreateCondBr(isTarget, directBlock, indirectBlock);
+    emitter.SetCurrentBasicBlock(directBlock);
+    llvm::Value* directResult = GenerateDirectCallInst(emitter, target, args, nothrow, span);
+    llvm::BasicBlock* directEndBlock = emitter.CurrentBasicBlock();
+    emitter.Builder().CreateBr(nextBlock);
+    emitter.SetCurrentBasicBlock(indirectBlock);
+    llvm::Value* indirectResult = GenerateCallInst(emitter, callee, args, nothrow, span);
+    llvm::BasicBlock* indirectEndBlock = emitter.CurrentBasicBlock();
+    emitter.Builder().CreateBr(nextBlock);
+    emitter.SetCurrentBasicBlock(nextBlock);
+    if (directResult && indirectResult)
+    {
+        llvm::PHINode* phi = emitter.Builder().CreatePHI(indirectResult->getType(), 2);
+        phi->addIncoming(directResult, directEndBlock);
+        phi->addIncoming(indirectResult, indirectEndBlock);
+        return phi;
     }
+    return nullptr;
 }
 
 std::unique_ptr<Value> FunctionSymbol::ConstructValue(const std::vector<std::unique_ptr<Value>>& argumentValues, const Span& span) const
@@ -142,6 +142,10 @@ public:
     virtual bool IsMemberFunctionToClassDelegateConversion() const { return false; }
     virtual void GenerateCall(Emitter& emitter, std::vector<GenObject*>& genObjects, OperationFlags flags, const Span& span);
     void GenerateVirtualCall(Emitter& emitter, std::vector<GenObject*>& genObjects, OperationFlags flags, const Span& span);
+    llvm::Value* GenerateCallInst(Emitter& emitter, llvm::Value* callee, ArgVector& args, bool nothrow, const Span& span);
+    llvm::Value* GenerateDirectCallInst(Emitter& emitter, FunctionSymbol* target, ArgVector& args, bool nothrow, const Span& span);
+    llvm::Value* GenerateGuardedCallInst(Emitter& emitter, llvm::Value* calleeAsVoidPtr, llvm::Value* callee, FunctionSymbol* target, ArgVector& args, bool nothrow, 
+        const Span& span);
     virtual std::unique_ptr<Value> ConstructValue(const std::vector<std::unique_ptr<Value>>& argumentValues, const Span& span) const;
     virtual std::unique_ptr<Value> ConvertValue(const std::unique_ptr<Value>& value) const;
     virtual ParameterSymbol* GetThisParam() const { return nullptr; }
@@ -38,7 +38,10 @@ enum class GlobalFlags : uint32_t
     cmdoc = 1 << 20,
     optimizeCmDoc = 1 << 21,
     singleThreadedCompile = 1 << 22,
-    debugCompile = 1 << 23
+    debugCompile = 1 << 23,
+    devirtualize = 1 << 24,
+    pipelinedCompile = 1 << 25,
+    thinArchive = 1 << 26
 };
 
 void ResetGlobalFlags();
@@ -133,6 +133,12 @@ llvm::Constant* InterfaceTypeSymbol::CreateDefaultIrValue(Emitter& emitter)
 
 void InterfaceTypeSymbol::GenerateCall(Emitter& emitter, std::vector<GenObject*>& genObjects, OperationFlags flags, MemberFunctionSymbol* interfaceMemberFunction, const Span& span)
 {
+    std::vector<FunctionSymbol*> targets;
+    ClassHierarchyAnalysis* classHierarchyAnalysis = GetRootModuleForCurrentThread()->GetClassHierarchyAnalysis();
+    if (classHierarchyAnalysis)
+    {
+        targets = classHierarchyAnalysis->GetInterfaceCallTargets(this, interfaceMemberFunction);
+    }
     TypeSymbol* type = static_cast<TypeSymbol*>(genObjects[0]->GetType());
     if (type->GetSymbolType() == SymbolType::interfaceTypeSymbol)
     {
@@ -148,17 +154,22 @@ void InterfaceTypeSymbol::GenerateCall(Emitter& emitter, std::vector<GenObject*>
     objectIndeces.push_back(emitter.Builder().getInt32(0));
     llvm::Value* objectPtrPtr = emitter.Builder().CreateGEP(interfaceTypePtr, objectIndeces);
     llvm::Value* objectPtr = emitter.Builder().CreateLoad(objectPtrPtr);
-    ArgVector interfaceIndeces;
-    interfaceIndeces.push_back(emitter.Builder().getInt32(0));
-    interfaceIndeces.push_back(emitter.Builder().getInt32(1));
-    llvm::Value* interfacePtrPtr = emitter.Builder().CreateGEP(interfaceTypePtr, interfaceIndeces);
-    llvm::Value* interfacePtr = emitter.Builder().CreateLoad(interfacePtrPtr);
-    llvm::Value* imtPtr = emitter.Builder().CreateBitCast(interfacePtr, llvm::PointerType::get(emitter.Builder().getInt8PtrTy(), 0));
-    ArgVector methodIndeces;
-    methodIndeces.push_back(emitter.Builder().getInt32(interfaceMemberFunction->ImtIndex()));
-    llvm::Value* methodPtrPtr = emitter.Builder().CreateGEP(imtPtr, methodIndeces);
-    llvm::Value* methodPtr = emitter.Builder().CreateLoad(methodPtrPtr);
-    llvm::Value* callee = emitter.Builder().CreateBitCast(methodPtr, llvm::PointerType::get(interfaceMemberFunction->IrType(emitter), 0));
+    llvm::Value* methodPtr = nullptr;
+    llvm::Value* callee = nullptr;
+    if (targets.size() != 1)
+    {
+        ArgVector interfaceIndeces;
+        interfaceIndeces.push_back(emitter.Builder().getInt32(0));
+        interfaceIndeces.push_back(emitter.Builder().getInt32(1));
+        llvm::Value* interfacePtrPtr = emitter.Builder().CreateGEP(interfaceTypePtr, interfaceIndeces);
+        llvm::Value* interfacePtr = emitter.Builder().CreateLoad(interfacePtrPtr);
+        llvm::Value* imtPtr = emitter.Builder().CreateBitCast(interfacePtr, llvm::PointerType::get(emitter.Builder().getInt8PtrTy(), 0));
+        ArgVector methodIndeces;
+        methodIndeces.push_back(emitter.Builder().getInt32(interfaceMemberFunction->ImtIndex()));
+        llvm::Value* methodPtrPtr = emitter.Builder().CreateGEP(imtPtr, methodIndeces);
+        methodPtr = emitter.Builder().CreateLoad(methodPtrPtr);
+        callee = emitter.Builder().CreateBitCast(methodPtr, llvm::PointerType::get(interfaceMemberFunction->IrType(emitter), 0));
+    }
     int na = genObjects.size();
     for (int i = 1; i < na; ++i)
     {
@@ -179,110 +190,22 @@ void InterfaceTypeSymbol::GenerateCall(Emitter& emitter, std::vector<GenObject*>
         llvm::Value* arg = emitter.Stack().Pop();
         args[n - i - 1] = arg;
     }
-    llvm::BasicBlock* handlerBlock = emitter.HandlerBlock();
-    llvm::BasicBlock* cleanupBlock = emitter.CleanupBlock();
-    bool newCleanupNeeded = emitter.NewCleanupNeeded();
-    Pad* currentPad = emitter.CurrentPad();
-    std::vector<llvm::OperandBundleDef> bundles;
-    if (currentPad != nullptr)
+    llvm::Value* result = nullptr;
+    if (targets.size() == 1)
     {
-        std::vector<llvm::Value*> inputs;
-        inputs.push_back(currentPad->value);
-        bundles.push_back(llvm::OperandBundleDef("funclet", inputs));
+        result = interfaceMemberFunction->GenerateDirectCallInst(emitter, targets[0], args, IsNothrow(), span);
     }
-    if (interfaceMemberFunction->ReturnType()->GetSymbolType() != SymbolType::voidTypeSymbol && !interfaceMemberFunction->ReturnsClassInterfaceOrClassDelegateByValue())
+    else if (targets.size() == 2)
     {
-        if (IsNothrow() || (!handlerBlock && !cleanupBlock && !newCleanupNeeded))
-        {
-            if (currentPad == nullptr)
-            {
-                emitter.Stack().Push(emitter.Builder().CreateCall(callee, args));
-            }
-            else
-            {
-                llvm::CallInst* callInst = llvm::CallInst::Create(callee, args, bundles, "", emitter.CurrentBasicBlock());
-                if (emitter.DIBuilder())
-                {
-                    callInst->setDebugLoc(emitter.GetDebugLocation(span));
-                }
-                emitter.Stack().Push(callInst);
-            }
-        }
-        else
-        {
-            llvm::BasicBlock* nextBlock = llvm::BasicBlock::Create(emitter.Context(), "next", emitter.Function());
-            if (newCleanupNeeded)
-            {
-                emitter.CreateCleanup();
-                cleanupBlock = emitter.CleanupBlock();
-            }
-            llvm::BasicBlock* unwindBlock = cleanupBlock;
-            if (unwindBlock == nullptr)
-            {
-                unwindBlock = handlerBlock;
-                Assert(unwindBlock, "no unwind block");
-            }
-            if (currentPad == nullptr)
-            {
-                emitter.Stack().Push(emitter.Builder().CreateInvoke(callee, nextBlock, unwindBlock, args));
-            }
-            else
-            {
-                llvm::InvokeInst* invokeInst = llvm::InvokeInst::Create(callee, nextBlock, unwindBlock, args, bundles, "", emitter.CurrentBasicBlock());
-                if (emitter.DIBuilder())
-                {
-                    invokeInst->setDebugLoc(emitter.GetDebugLocation(span));
-                }
-                emitter.Stack().Push(invokeInst);
-            }
-            emitter.SetCurrentBasicBlock(nextBlock);
-        }
+        result = interfaceMemberFunction->GenerateGuardedCallInst(emitter, methodPtr, callee, targets[0], args, IsNothrow(), span);
     }
     else
     {
-        if (IsNothrow() || (!handlerBlock && !cleanupBlock && !newCleanupNeeded))
-        {
-            if (currentPad == nullptr)
-            {
-                emitter.Builder().CreateCall(callee, args);
-            }
-            else
-            {
-                llvm::CallInst* callInst = llvm::CallInst::Create(callee, args, bundles, "", emitter.CurrentBasicBlock());
-                if (emitter.DIBuilder())
-                {
-                    callInst->setDebugLoc(emitter.GetDebugLocation(span));
-                }
-            }
-        }
-        else
-        {
-            llvm::BasicBlock* nextBlock = llvm::BasicBlock::Create(emitter.Context(), "next", emitter.Function());
-            if (newCleanupNeeded)
-            {
-                emitter.CreateCleanup();
-                cleanupBlock = emitter.CleanupBlock();
-            }
-            llvm::BasicBlock* unwindBlock = cleanupBlock;
-            if (unwindBlock == nullptr)
-            {
-                unwindBlock = handlerBlock;
-                Assert(unwindBlock, "no unwind block");
-            }
-            if (currentPad == nullptr)
-            {
-                emitter.Builder().CreateInvoke(callee, nextBlock, unwindBlock, args);
-            }
-            else
-            {
-                llvm::InvokeInst* invokeInst = llvm::InvokeInst::Create(callee, nextBlock, unwindBlock, args, bundles, "", emitter.CurrentBasicBlock());
-                if (emitter.DIBuilder())
-                {
-                    invokeInst->setDebugLoc(emitter.GetDebugLocation(span));
-                }
-            }
-            emitter.SetCurrentBasicBlock(nextBlock);
-        }
+        result = interfaceMemberFunction->GenerateCallInst(emitter, callee, args, IsNothrow(), span);
+    }
+    if (result)
+    {
+        emitter.Stack().Push(result);
     }
 }
 
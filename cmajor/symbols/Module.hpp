@@ -6,6 +6,9 @@
 #ifndef CMAJOR_SYMBOLS_MODULE_INCLUDED
 #define CMAJOR_SYMBOLS_MODULE_INCLUDED
 #include <cmajor/symbols/SymbolTable.hpp>
+#include <cmajor/symbols/ClassHierarchyAnalysis.hpp>
+#include <cmajor/symbols/ConstExprCallCache.hpp>
+#include <cmajor/symbols/ConceptCheckCache.hpp>
 #include <cmajor/symbols/Warning.hpp>
 #include <cmajor/util/CodeFormatter.hpp>
 #include <mutex>
@@ -30,7 +33,8 @@ const uint8_t moduleFormat_2 = uint8_t('2');
 const uint8_t moduleFormat_3 = uint8_t('3');
 const uint8_t moduleFormat_4 = uint8_t('4');
 const uint8_t moduleFormat_5 = uint8_t('5');
-const uint8_t currentModuleFormat = moduleFormat_5;
+const uint8_t moduleFormat_6 = uint8_t('6');
+const uint8_t currentModuleFormat = moduleFormat_6;
 
 enum class ModuleFlags : uint8_t
 {
@@ -158,6 +162,10 @@ public:
     int GetBuildTimeMs();
     bool Preparing() const { return preparing; }
     void SetPreparing(bool preparing_) { preparing = preparing_; }
+    ClassHierarchyAnalysis* GetClassHierarchyAnalysis() { return classHierarchyAnalysis.get(); }
+    void SetClassHierarchyAnalysis(ClassHierarchyAnalysis* classHierarchyAnalysis_) { classHierarchyAnalysis.reset(classHierarchyAnalysis_); }
+    ConstExprCallCache& GetConstExprCallCache() { return constExprCallCache; }
+    ConceptCheckCache& GetConceptCheckCache() { return conceptCheckCache; }
 private:
     uint8_t format;
     ModuleFlags flags;
@@ -178,6 +186,9 @@ private:
     std::vector<Module*> allRefModules;
     uint32_t symbolTablePos;
     std::unique_ptr<SymbolTable> symbolTable;
+    std::unique_ptr<ClassHierarchyAnalysis> classHierarchyAnalysis;
+    ConstExprCallCache constExprCallCache;
+    ConceptCheckCache conceptCheckCache;
     std::string directoryPath;
     std::vector<std::string> libraryFilePaths;
     std::u32string currentProjectName;
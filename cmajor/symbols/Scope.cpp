@@ -14,6 +14,7 @@
 #include <cmajor/ast/Identifier.hpp>
 #include <cmajor/util/Unicode.hpp>
 #include <cmajor/util/Util.hpp>
+#include <algorithm>
 
 namespace cmajor { namespace symbols {
 
@@ -519,4 +520,62 @@ void FileScope::CollectViableFunctions(int arity, const std::u32string&  groupNa
     }
 }
 
+//  A declaration block is identified by its source position in addition to its full name, because the blocks of a function have the same name.
+
+std::u32string ScopeId(ContainerScope* scope)
+{
+    ContainerSymbol* container = scope->Container();
+    if (!container)
+    {
+        return std::u32string();
+    }
+    std::u32string scopeId = container->FullName();
+    if (container->GetSymbolType() == SymbolType::declarationBlock)
+    {
+        const Span& span = container->GetSpan();
+        scopeId.append(1, U'@').append(ToUtf32(std::to_string(span.FileIndex()))).append(1, U':').append(ToUtf32(std::to_string(span.Start())));
+    }
+    return scopeId;
+}
+
+LookupScopeKey::LookupScopeKey(ContainerScope* containerScope, const std::vector<std::unique_ptr<FileScope>>& fileScopes) : containerScopeId(ScopeId(containerScope))
+{
+    AddFileScopes(fileScopes);
+}
+
+//  A key without a container scope for lookups that do not depend on the scope of the caller.
+
+LookupScopeKey::LookupScopeKey(const std::vector<std::unique_ptr<FileScope>>& fileScopes)
+{
+    AddFileScopes(fileScopes);
+}
+
+void LookupScopeKey::AddFileScopes(const std::vector<std::unique_ptr<FileScope>>& fileScopes)
+{
+    for (const std::unique_ptr<FileScope>& fileScope : fileScopes)
+    {
+        for (ContainerScope* importedScope : fileScope->ContainerScopes())
+        {
+            importedScopeIds.push_back(ScopeId(importedScope));
+        }
+        importedScopeIds.push_back(std::u32string());
+        int start = aliases.size();
+        for (const std::pair<std::u32string, Symbol*>& alias : fileScope->AliasSymbolMap())
+        {
+            aliases.push_back(std::make_pair(alias.first, alias.second->FullName()));
+        }
+        std::sort(aliases.begin() + start, aliases.end());
+        aliases.push_back(std::make_pair(std::u32string(), std::u32string()));
+    }
+}
+
+bool LookupScopeKey::operator<(const LookupScopeKey& that) const
+{
+    if (containerScopeId < that.containerScopeId) return true;
+    if (that.containerScopeId < containerScopeId) return false;
+    if (importedScopeIds < that.importedScopeIds) return true;
+    if (that.importedScopeIds < importedScopeIds) return false;
+    return aliases < that.aliases;
+}
+
 } } // namespace cmajor::symbols
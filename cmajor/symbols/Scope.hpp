@@ -9,6 +9,8 @@
 #include <cmajor/parsing/Scanner.hpp>
 #include <unordered_map>
 #include <unordered_set>
+#include <memory>
+#include <vector>
 
 namespace cmajor { namespace symbols {
 
@@ -88,12 +90,31 @@ public:
     Symbol* Lookup(const std::u32string& name, ScopeLookup lookup) const override;
     void CollectViableFunctions(int arity, const std::u32string&  groupName, std::unordered_set<ContainerScope*>& scopesLookedUp, ViableFunctionSet& viableFunctions,
         Module* module);
+    const std::vector<ContainerScope*>& ContainerScopes() const { return containerScopes; }
+    const std::unordered_map<std::u32string, Symbol*>& AliasSymbolMap() const { return aliasSymbolMap; }
 private:
     Module* module;
     std::vector<ContainerScope*> containerScopes;
     std::unordered_map<std::u32string, Symbol*> aliasSymbolMap;
 };
 
+//  Identifies the scopes that names are looked up from: a container scope and the contents of the file scopes of a compile unit.
+//  Compile units whose file scopes import the same namespaces and define the same aliases have equal keys.
+//  Scopes and alias targets are identified by full names, not by addresses, so a key stays valid after the symbols it was made from have been destroyed.
+
+class LookupScopeKey
+{
+public:
+    LookupScopeKey(ContainerScope* containerScope, const std::vector<std::unique_ptr<FileScope>>& fileScopes);
+    LookupScopeKey(const std::vector<std::unique_ptr<FileScope>>& fileScopes);
+    bool operator<(const LookupScopeKey& that) const;
+private:
+    std::u32string containerScopeId;
+    std::vector<std::u32string> importedScopeIds;
+    std::vector<std::pair<std::u32string, std::u32string>> aliases;
+    void AddFileScopes(const std::vector<std::unique_ptr<FileScope>>& fileScopes);
+};
+
 } } // namespace cmajor::symbols
 
 #endif // CMAJOR_SYMBOLS_SCOPE_INCLUDED
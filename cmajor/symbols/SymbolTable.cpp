@@ -1054,6 +1054,41 @@ Node* SymbolTable::GetNode(Symbol* symbol) const
     }
 }
 
+//  Called when the body of a function has been released: removes the node mappings of the declaration blocks and local variables of the function, 
+//  so that the addresses of the deleted body nodes cannot be found again if the memory is reused.
+
+void SymbolTable::UnmapFunctionBody(FunctionSymbol* functionSymbol)
+{
+    UnmapLocalSymbols(functionSymbol);
+    for (LocalVariableSymbol* localVariable : functionSymbol->LocalVariables())
+    {
+        UnmapSymbol(localVariable);
+    }
+}
+
+void SymbolTable::UnmapLocalSymbols(ContainerSymbol* container)
+{
+    for (const std::unique_ptr<Symbol>& member : container->Members())
+    {
+        if (member->GetSymbolType() == SymbolType::parameterSymbol || member->GetSymbolType() == SymbolType::templateParameterSymbol) continue;
+        UnmapSymbol(member.get());
+        if (member->IsContainerSymbol())
+        {
+            UnmapLocalSymbols(static_cast<ContainerSymbol*>(member.get()));
+        }
+    }
+}
+
+void SymbolTable::UnmapSymbol(Symbol* symbol)
+{
+    auto it = symbolNodeMap.find(symbol);
+    if (it != symbolNodeMap.cend())
+    {
+        nodeSymbolMap.erase(it->second);
+        symbolNodeMap.erase(it);
+    }
+}
+
 void SymbolTable::AddTypeOrConceptSymbolToTypeIdMap(Symbol* typeOrConceptSymbol)
 {
     if (typeOrConceptSymbol->IsTypeSymbol())
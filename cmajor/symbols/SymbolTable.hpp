@@ -160,6 +160,7 @@ public:
     Symbol* GetSymbol(Node* node) const;
     Node* GetNodeNoThrow(Symbol* symbol) const;
     Node* GetNode(Symbol* symbol) const;
+    void UnmapFunctionBody(FunctionSymbol* functionSymbol);
     void SetTypeIdFor(TypeSymbol* typeSymbol);
     void SetTypeIdFor(ConceptSymbol* conceptSymbol);
     void SetFunctionIdFor(FunctionSymbol* functionSymbol);
@@ -256,6 +257,8 @@ private:
     int numSpecializationsNew;
     int GetNextDeclarationBlockIndex() { return declarationBlockIndex++; }
     void ResetDeclarationBlockIndex() { declarationBlockIndex = 0; }
+    void UnmapSymbol(Symbol* symbol);
+    void UnmapLocalSymbols(ContainerSymbol* container);
     void EmplaceTypeOrConceptRequest(SymbolReader& reader, Symbol* forSymbol, const boost::uuids::uuid& typeId, int index);
 };
 
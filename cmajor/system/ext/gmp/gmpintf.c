@@ -1,6 +1,8 @@
 #include "gmpintf.h"
 #include "gmp.h"
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 // integer functions:
 
@@ -75,6 +77,21 @@ GMP_API void free_mpz_str(char* mpz_str)
     free(mpz_str);
 }
 
+// returns the size of a buffer large enough for the digits, the sign and the terminating zero:
+
+GMP_API int64_t get_mpz_str_size(void* mpz_handle, int32_t base)
+{
+    mpz_t* mpz = (mpz_t*)mpz_handle;
+    return mpz_sizeinbase(*mpz, abs(base)) + 2;
+}
+
+GMP_API int64_t get_mpz_str_buf(void* mpz_handle, int32_t base, char* buf)
+{
+    mpz_t* mpz = (mpz_t*)mpz_handle;
+    mpz_get_str(buf, base, *mpz);
+    return strlen(buf);
+}
+
 GMP_API void add_mpz(void* mpz_target, void* mpz_left, void* mpz_right)
 {
     mpz_t* target = (mpz_t*)mpz_target;
@@ -240,6 +257,19 @@ GMP_API void free_mpq_str(char* mpq_str)
     free(mpq_str);
 }
 
+GMP_API int64_t get_mpq_str_size(void* mpq_handle, int32_t base)
+{
+    mpq_t* mpq = (mpq_t*)mpq_handle;
+    return mpz_sizeinbase(mpq_numref(*mpq), abs(base)) + mpz_sizeinbase(mpq_denref(*mpq), abs(base)) + 3;
+}
+
+GMP_API int64_t get_mpq_str_buf(void* mpq_handle, int32_t base, char* buf)
+{
+    mpq_t* mpq = (mpq_t*)mpq_handle;
+    mpq_get_str(buf, base, *mpq);
+    return strlen(buf);
+}
+
 GMP_API void set_mpq_z(void* mpq_left, void* mpz_right)
 {
     mpq_t* left = (mpq_t*)mpq_left;
@@ -428,6 +458,29 @@ GMP_API void free_mpf_str(char* mpf_str)
     free(mpf_str);
 }
 
+// mpf_get_str generates at most the number of digits that the precision of the number allows, one limb more than the precision rounded up to limbs:
+
+GMP_API int64_t get_mpf_str_size(void* mpf_handle, int32_t base_, uint32_t numDigits)
+{
+    mpf_t* subject = (mpf_t*)mpf_handle;
+    double bits = (double)mpf_get_prec(*subject) + 2 * GMP_NUMB_BITS;
+    int64_t maxDigits = (int64_t)(bits * log(2.0) / log((double)abs(base_))) + 3;
+    if (numDigits != 0 && numDigits < maxDigits)
+    {
+        return (int64_t)numDigits + 2;
+    }
+    return maxDigits + 2;
+}
+
+GMP_API int64_t get_mpf_str_buf(void* mpf_handle, int32_t base_, uint32_t numDigits, int64_t* exponent, char* buf)
+{
+    mpf_t* subject = (mpf_t*)mpf_handle;
+    mp_exp_t exp = 0;
+    mpf_get_str(buf, &exp, base_, numDigits, *subject);
+    *exponent = exp;
+    return strlen(buf);
+}
+
 GMP_API void add_mpf(void* mpf_target, void* mpf_left, void* mpf_right)
 {
     mpf_t* target = (mpf_t*)mpf_target;
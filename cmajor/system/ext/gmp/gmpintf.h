@@ -29,6 +29,8 @@ GMP_API int32_t assign_mpz_str(void* mpz_handle, const char* str, int32_t base);
 GMP_API void swap_mpz(void* mpz_left, void* mpz_right);
 GMP_API char* get_mpz_str(void* mpz_handle, int32_t base);
 GMP_API void free_mpz_str(char* mzp_str);
+GMP_API int64_t get_mpz_str_size(void* mpz_handle, int32_t base);
+GMP_API int64_t get_mpz_str_buf(void* mpz_handle, int32_t base, char* buf);
 GMP_API void add_mpz(void* mpz_target, void* mpz_left, void* mpz_right);
 GMP_API void sub_mpz(void* mpz_target, void* mpz_left, void* mpz_right);
 GMP_API void mul_mpz(void* mpz_target, void* mpz_left, void* mpz_right);
@@ -55,6 +57,8 @@ GMP_API void set_mpq_si(void* mpq_handle, int32_t n, int32_t d);
 GMP_API void set_mpq_ui(void* mpq_handle, uint32_t n, uint32_t d);
 GMP_API char* get_mpq_str(void* mpq_handle, int32_t base);
 GMP_API void free_mpq_str(char* mpq_str);
+GMP_API int64_t get_mpq_str_size(void* mpq_handle, int32_t base);
+GMP_API int64_t get_mpq_str_buf(void* mpq_handle, int32_t base, char* buf);
 GMP_API void set_mpq_z(void* mpq_left, void* mpz_right);
 GMP_API void add_mpq(void* mpq_target, void* mpq_left, void* mpq_right);
 GMP_API void sub_mpq(void* mpq_target, void* mpq_left, void* mpq_right);
@@ -85,6 +89,8 @@ GMP_API void set_mpf_q(void* mpf_left, void* mpq_right);
 GMP_API int32_t set_mpf_str(void* mpf_left, const char* str, int32_t base);
 GMP_API char* get_mpf_str(void* mpf_handle, int32_t base_, uint32_t numDigits, int64_t* exponent);
 GMP_API void free_mpf_str(char* mpf_str);
+GMP_API int64_t get_mpf_str_size(void* mpf_handle, int32_t base_, uint32_t numDigits);
+GMP_API int64_t get_mpf_str_buf(void* mpf_handle, int32_t base_, uint32_t numDigits, int64_t* exponent, char* buf);
 GMP_API void add_mpf(void* mpf_target, void* mpf_left, void* mpf_right);
 GMP_API void sub_mpf(void* mpf_target, void* mpf_left, void* mpf_right);
 GMP_API void mul_mpf(void* mpf_target, void* mpf_left, void* mpf_right);
@@ -223,6 +223,17 @@ void BinaryReader::Skip(uint32_t size)
     pos += size;
 }
 
+void BinaryReader::Seek(uint32_t pos_)
+{
+    const uint8_t* start = begin - pos;
+    if (pos_ > end - start)
+    {
+        throw std::runtime_error("seek past end of file '" + fileName + "'");
+    }
+    begin = start + pos_;
+    pos = pos_;
+}
+
 void BinaryReader::CheckEof()
 {
     if (begin == end)
@@ -40,6 +40,7 @@ public:
     void ReadUuid(boost::uuids::uuid& uuid);
     uint32_t Pos() const { return pos; }
     void Skip(uint32_t size);
+    void Seek(uint32_t pos_);
 private:
     std::string fileName;
     MappedInputFile file;
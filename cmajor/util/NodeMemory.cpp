@@ -0,0 +1,293 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/util/NodeMemory.hpp>
+#include <vector>
+#include <mutex>
+#include <new>
+
+namespace cmajor { namespace util {
+
+const size_t granularity = 16;
+const size_t numSizeClasses = 16;
+const size_t blockSize = 64 * 1024;
+const size_t batchSize = 1024;
+const size_t maxCachedNodes = 4 * batchSize;
+
+struct FreeNode
+{
+    FreeNode* next;
+};
+
+struct FreeNodeBatch
+{
+    FreeNodeBatch(FreeNode* head_, size_t count_) : head(head_), count(count_) {}
+    FreeNode* head;
+    size_t count;
+};
+
+//  The central pool holds the free nodes and unused block space that threads have given back.
+//  It is shared by all threads and never destroyed, so nodes can be freed at any time, even during the destruction of static objects.
+
+class NodeMemoryPool
+{
+public:
+    bool GetBatch(size_t sizeClass, FreeNodeBatch& batch);
+    void PutBatch(size_t sizeClass, const FreeNodeBatch& batch);
+    void GetBlock(char*& blockPos, char*& blockEnd);
+    void PutBlock(char* blockPos, char* blockEnd);
+    void* Allocate(size_t sizeClass);
+    void Free(void* memory, size_t sizeClass);
+private:
+    std::mutex mtx;
+    std::vector<FreeNodeBatch> batches[numSizeClasses];
+    std::vector<std::pair<char*, char*>> blocks;
+    void GetBlockLocked(char*& blockPos, char*& blockEnd);
+};
+
+bool NodeMemoryPool::GetBatch(size_t sizeClass, FreeNodeBatch& batch)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<FreeNodeBatch>& classBatches = batches[sizeClass - 1];
+    if (classBatches.empty())
+    {
+        return false;
+    }
+    batch = classBatches.back();
+    classBatches.pop_back();
+    return true;
+}
+
+void NodeMemoryPool::PutBatch(size_t sizeClass, const FreeNodeBatch& batch)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    batches[sizeClass - 1].push_back(batch);
+}
+
+void NodeMemoryPool::GetBlock(char*& blockPos, char*& blockEnd)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    GetBlockLocked(blockPos, blockEnd);
+}
+
+void NodeMemoryPool::GetBlockLocked(char*& blockPos, char*& blockEnd)
+{
+    if (!blocks.empty())
+    {
+        blockPos = blocks.back().first;
+        blockEnd = blocks.back().second;
+        blocks.pop_back();
+    }
+    else
+    {
+        blockPos = static_cast<char*>(::operator new(blockSize));
+        blockEnd = blockPos + blockSize;
+    }
+}
+
+void NodeMemoryPool::PutBlock(char* blockPos, char* blockEnd)
+{
+    if (blockEnd - blockPos < static_cast<ptrdiff_t>(granularity))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    blocks.push_back(std::make_pair(blockPos, blockEnd));
+}
+
+void* NodeMemoryPool::Allocate(size_t sizeClass)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<FreeNodeBatch>& classBatches = batches[sizeClass - 1];
+    if (!classBatches.empty())
+    {
+        FreeNodeBatch& batch = classBatches.back();
+        FreeNode* node = batch.head;
+        batch.head = node->next;
+        if (--batch.count == 0)
+        {
+            classBatches.pop_back();
+        }
+        return node;
+    }
+    size_t allocationSize = sizeClass * granularity;
+    char* blockPos = nullptr;
+    char* blockEnd = nullptr;
+    GetBlockLocked(blockPos, blockEnd);
+    while (blockEnd - blockPos < static_cast<ptrdiff_t>(allocationSize))
+    {
+        GetBlockLocked(blockPos, blockEnd);
+    }
+    void* memory = blockPos;
+    blockPos += allocationSize;
+    if (blockEnd - blockPos >= static_cast<ptrdiff_t>(granularity))
+    {
+        blocks.push_back(std::make_pair(blockPos, blockEnd));
+    }
+    return memory;
+}
+
+void NodeMemoryPool::Free(void* memory, size_t sizeClass)
+{
+    FreeNode* node = static_cast<FreeNode*>(memory);
+    node->next = nullptr;
+    PutBatch(sizeClass, FreeNodeBatch(node, 1));
+}
+
+NodeMemoryPool* nodeMemoryPool = nullptr;
+std::once_flag nodeMemoryPoolFlag;
+
+NodeMemoryPool& GetNodeMemoryPool()
+{
+    std::call_once(nodeMemoryPoolFlag, []() { nodeMemoryPool = new NodeMemoryPool(); });
+    return *nodeMemoryPool;
+}
+
+struct NodeFreeLists
+{
+    NodeFreeLists() : blockPos(nullptr), blockEnd(nullptr)
+    {
+        for (size_t i = 0; i < numSizeClasses; ++i)
+        {
+            freeList[i] = nullptr;
+            count[i] = 0;
+        }
+    }
+    FreeNode* freeList[numSizeClasses];
+    size_t count[numSizeClasses];
+    char* blockPos;
+    char* blockEnd;
+};
+
+#ifdef _WIN32
+__declspec(thread) NodeFreeLists* freeLists = nullptr;
+__declspec(thread) bool freeListsReleased = false;
+#else
+__thread NodeFreeLists* freeLists = nullptr;
+__thread bool freeListsReleased = false;
+#endif
+
+//  Gives the free lists and the unused part of the current block of an exiting thread back to the central pool.
+
+struct NodeFreeListsOwner
+{
+    ~NodeFreeListsOwner()
+    {
+        if (!freeLists)
+        {
+            return;
+        }
+        NodeMemoryPool& pool = GetNodeMemoryPool();
+        for (size_t i = 0; i < numSizeClasses; ++i)
+        {
+            if (freeLists->freeList[i])
+            {
+                pool.PutBatch(i + 1, FreeNodeBatch(freeLists->freeList[i], freeLists->count[i]));
+            }
+        }
+        pool.PutBlock(freeLists->blockPos, freeLists->blockEnd);
+        delete freeLists;
+        freeLists = nullptr;
+        freeListsReleased = true;
+    }
+};
+
+NodeFreeLists* GetFreeLists()
+{
+    if (!freeLists)
+    {
+        if (freeListsReleased)
+        {
+            return nullptr;
+        }
+        static thread_local NodeFreeListsOwner owner;
+        freeLists = new NodeFreeLists();
+    }
+    return freeLists;
+}
+
+void* AllocateNodeMemory(size_t size)
+{
+    size_t sizeClass = (size + granularity - 1) / granularity;
+    if (sizeClass == 0 || sizeClass > numSizeClasses)
+    {
+        return ::operator new(size);
+    }
+    NodeFreeLists* lists = GetFreeLists();
+    if (!lists)
+    {
+        return GetNodeMemoryPool().Allocate(sizeClass);
+    }
+    FreeNode*& head = lists->freeList[sizeClass - 1];
+    if (!head)
+    {
+        FreeNodeBatch batch(nullptr, 0);
+        if (GetNodeMemoryPool().GetBatch(sizeClass, batch))
+        {
+            head = batch.head;
+            lists->count[sizeClass - 1] = batch.count;
+        }
+    }
+    if (head)
+    {
+        FreeNode* node = head;
+        head = node->next;
+        --lists->count[sizeClass - 1];
+        return node;
+    }
+    size_t allocationSize = sizeClass * granularity;
+    if (lists->blockEnd - lists->blockPos < static_cast<ptrdiff_t>(allocationSize))
+    {
+        GetNodeMemoryPool().GetBlock(lists->blockPos, lists->blockEnd);
+        while (lists->blockEnd - lists->blockPos < static_cast<ptrdiff_t>(allocationSize))
+        {
+            GetNodeMemoryPool().GetBlock(lists->blockPos, lists->blockEnd);
+        }
+    }
+    void* memory = lists->blockPos;
+    lists->blockPos += allocationSize;
+    return memory;
+}
+
+void FreeNodeMemory(void* memory, size_t size)
+{
+    if (!memory)
+    {
+        return;
+    }
+    size_t sizeClass = (size + granularity - 1) / granularity;
+    if (sizeClass == 0 || sizeClass > numSizeClasses)
+    {
+        ::operator delete(memory);
+        return;
+    }
+    NodeFreeLists* lists = GetFreeLists();
+    if (!lists)
+    {
+        GetNodeMemoryPool().Free(memory, sizeClass);
+        return;
+    }
+    FreeNode* node = static_cast<FreeNode*>(memory);
+    FreeNode*& head = lists->freeList[sizeClass - 1];
+    size_t& count = lists->count[sizeClass - 1];
+    node->next = head;
+    head = node;
+    ++count;
+    if (count > maxCachedNodes)
+    {
+        FreeNode* batchHead = head;
+        FreeNode* batchTail = head;
+        for (size_t i = 1; i < batchSize; ++i)
+        {
+            batchTail = batchTail->next;
+        }
+        head = batchTail->next;
+        batchTail->next = nullptr;
+        count -= batchSize;
+        GetNodeMemoryPool().PutBatch(sizeClass, FreeNodeBatch(batchHead, batchSize));
+    }
+}
+
+} } // namespace cmajor::util
@@ -0,0 +1,21 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#ifndef CMAJOR_UTIL_NODE_MEMORY_INCLUDED
+#define CMAJOR_UTIL_NODE_MEMORY_INCLUDED
+#include <stddef.h>
+
+namespace cmajor { namespace util {
+
+//  Memory of small tree nodes is carved from large blocks and recycled through per-thread free lists of fixed size classes.
+//  Free lists that grow long and the free lists of exiting threads are given back to a central pool that other threads reuse.
+//  The memory is never returned to the system.
+
+void* AllocateNodeMemory(size_t size);
+void FreeNodeMemory(void* memory, size_t size);
+
+} } // namespace cmajor::util
+
+#endif // CMAJOR_UTIL_NODE_MEMORY_INCLUDED
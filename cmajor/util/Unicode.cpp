@@ -1894,15 +1894,6 @@ CharacterInfo& CharacterInfoPage::GetCharacterInfo(int index)
     return characterInfos[index];
 }
 
-const CharacterInfo& CharacterInfoPage::GetCharacterInfo(int index) const
-{
-    if (index < 0 || index > characterInfos.size())
-    {
-        throw UnicodeException("invalid character info index");
-    }
-    return characterInfos[index];
-}
-
 void CharacterInfoPage::Write(BinaryWriter& writer)
 {
     for (int i = 0; i < characterInfos.size(); ++i)
@@ -1926,15 +1917,6 @@ ExtendedCharacterInfoPage::ExtendedCharacterInfoPage()
     extendedCharacterInfos.resize(numInfosInPage);
 }
 
-const ExtendedCharacterInfo& ExtendedCharacterInfoPage::GetExtendedCharacterInfo(int index) const
-{
-    if (index < 0 || index > extendedCharacterInfos.size())
-    {
-        throw UnicodeException("invalid extended character info index");
-    }
-    return extendedCharacterInfos[index];
-}
-
 ExtendedCharacterInfo& ExtendedCharacterInfoPage::GetExtendedCharacterInfo(int index)
 {
     if (index < 0 || index > extendedCharacterInfos.size())
@@ -2043,8 +2025,22 @@ std::string CmajorUcdFilePath()
     return (boost::filesystem::path(CmajorRoot()) / boost::filesystem::path("unicode") / boost::filesystem::path("cmajor_ucd.bin")).generic_string();
 }
 
-CharacterTable::CharacterTable() : headerRead(false), extendedHeaderStart(0), extendedHeaderEnd(0), extendedHeaderRead(false)
+CharacterTable::CharacterTable() : extendedHeaderStart(0), extendedHeaderEnd(0)
 {
+    for (int i = 0; i < numCharacterInfoPages; ++i)
+    {
+        pages[i].store(nullptr, std::memory_order_relaxed);
+        extendedPages[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+CharacterTable::~CharacterTable()
+{
+    for (int i = 0; i < numCharacterInfoPages; ++i)
+    {
+        delete pages[i].load(std::memory_order_relaxed);
+        delete extendedPages[i].load(std::memory_order_relaxed);
+    }
 }
 
 void CharacterTable::Write()
@@ -2052,21 +2048,29 @@ void CharacterTable::Write()
     std::string ucdFilePath = CmajorUcdFilePath();
     BinaryWriter writer(ucdFilePath);
     WriteHeader(writer);
-    int n = pages.size();
+    int n = 0;
+    while (n < numCharacterInfoPages && pages[n].load(std::memory_order_relaxed))
+    {
+        ++n;
+    }
     for (int i = 0; i < n; ++i)
     {
-        CharacterInfoPage* page = pages[i].get();
+        CharacterInfoPage* page = pages[i].load(std::memory_order_relaxed);
         page->Write(writer);
     }
     extendedHeaderStart = writer.Pos();
-    int nx = extendedPages.size();
+    int nx = 0;
+    while (nx < numCharacterInfoPages && extendedPages[nx].load(std::memory_order_relaxed))
+    {
+        ++nx;
+    }
     extendedHeader.AllocatePages(nx);
     extendedHeader.Write(writer);
     extendedHeaderEnd = writer.Pos();
     for (int i = 0; i < nx; ++i)
     {
         extendedHeader.SetPageStart(i, writer.Pos());
-        ExtendedCharacterInfoPage* extendedPage = extendedPages[i].get();
+        ExtendedCharacterInfoPage* extendedPage = extendedPages[i].load(std::memory_order_relaxed);
         extendedPage->Write(writer);
     }
     writer.Seek(extendedHeaderStart);
@@ -2087,7 +2091,6 @@ void CharacterTable::WriteHeader(BinaryWriter& writer)
 
 void CharacterTable::ReadHeader(BinaryReader& reader)
 {
-    headerRead = true;
     uint8_t magic[8];
     for (int i = 0; i < 8; ++i)
     {
@@ -2108,140 +2111,94 @@ void CharacterTable::ReadHeader(BinaryReader& reader)
     extendedHeaderEnd = reader.ReadUInt();
 }
 
-void CharacterTable::ReadExtendedHeader(BinaryReader& reader)
+void CharacterTable::ThrowInvalidCodePoint(char32_t codePoint)
 {
-    extendedHeaderRead = true;
-    extendedHeader.Read(reader);
+    throw UnicodeException("invalid Unicode code point " + std::to_string(codePoint));
 }
 
 std::mutex mtx;
 
-const CharacterInfo& CharacterTable::GetCharacterInfo(char32_t codePoint)
+//  Called with mtx locked. The file stays mapped until the table is destroyed.
+
+void CharacterTable::OpenUcdFile()
 {
-    if (codePoint > 0x10FFFF)
-    {
-        throw UnicodeException("invalid Unicode code point " + std::to_string(codePoint));
-    }
-    int pageIndex = codePoint / numInfosInPage;
-    if (pages.size() <= pageIndex)
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        while (pages.size() <= pageIndex)
-        {
-            pages.push_back(std::unique_ptr<CharacterInfoPage>());
-        }
-    }
-    CharacterInfoPage* page = pages[pageIndex].get();
-    if (!page)
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (!page)
-        {
-            std::string ucdFilePath = CmajorUcdFilePath();
-            BinaryReader reader(ucdFilePath);
-            uint32_t pageStart = 0;
-            if (!headerRead)
-            {
-                ReadHeader(reader);
-                pageStart = characterInfoPageSize * pageIndex;
-            }
-            else
-            {
-                pageStart = headerSize + characterInfoPageSize * pageIndex;
-            }
-            reader.Skip(pageStart);
-            page = new CharacterInfoPage();
-            page->Read(reader);
-            pages[pageIndex] = std::move(std::unique_ptr<CharacterInfoPage>(page));
-        }
-    }
-    int infoIndex = codePoint % numInfosInPage;
-    return page->GetCharacterInfo(infoIndex);
+    if (ucdReader) return;
+    std::unique_ptr<BinaryReader> reader(new BinaryReader(CmajorUcdFilePath()));
+    ReadHeader(*reader);
+    reader->Seek(extendedHeaderStart);
+    extendedHeader.Read(*reader);
+    ucdReader = std::move(reader);
 }
 
-CharacterInfo& CharacterTable::CreateCharacterInfo(char32_t codePoint)
+CharacterInfoPage* CharacterTable::LoadPage(int pageIndex)
 {
-    if (codePoint > 0x10FFFF)
+    std::lock_guard<std::mutex> lock(mtx);
+    CharacterInfoPage* page = pages[pageIndex].load(std::memory_order_relaxed);
+    if (page)
     {
-        throw UnicodeException("invalid Unicode code point " + std::to_string(codePoint));
+        return page;
     }
-    int pageIndex = codePoint / numInfosInPage;
-    while (pages.size() <= pageIndex)
+    OpenUcdFile();
+    ucdReader->Seek(headerSize + characterInfoPageSize * pageIndex);
+    std::unique_ptr<CharacterInfoPage> newPage(new CharacterInfoPage());
+    newPage->Read(*ucdReader);
+    page = newPage.release();
+    pages[pageIndex].store(page, std::memory_order_release);
+    return page;
+}
+
+ExtendedCharacterInfoPage* CharacterTable::LoadExtendedPage(int pageIndex)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    ExtendedCharacterInfoPage* extendedPage = extendedPages[pageIndex].load(std::memory_order_relaxed);
+    if (extendedPage)
     {
-        pages.push_back(std::unique_ptr<CharacterInfoPage>(new CharacterInfoPage()));
+        return extendedPage;
     }
-    int infoIndex = codePoint % numInfosInPage;
-    CharacterInfoPage* page = pages[pageIndex].get();
-    return page->GetCharacterInfo(infoIndex);
+    OpenUcdFile();
+    ucdReader->Seek(extendedHeader.GetPageStart(pageIndex));
+    std::unique_ptr<ExtendedCharacterInfoPage> newExtendedPage(new ExtendedCharacterInfoPage());
+    newExtendedPage->Read(*ucdReader);
+    extendedPage = newExtendedPage.release();
+    extendedPages[pageIndex].store(extendedPage, std::memory_order_release);
+    return extendedPage;
 }
 
-const ExtendedCharacterInfo& CharacterTable::GetExtendedCharacterInfo(char32_t codePoint)
+CharacterInfo& CharacterTable::CreateCharacterInfo(char32_t codePoint)
 {
     if (codePoint > 0x10FFFF)
     {
-        throw UnicodeException("invalid Unicode code point " + std::to_string(codePoint));
+        ThrowInvalidCodePoint(codePoint);
     }
     int pageIndex = codePoint / numInfosInPage;
-    if (extendedPages.size() <= pageIndex)
+    for (int i = 0; i <= pageIndex; ++i)
     {
-        std::lock_guard<std::mutex> lock(mtx);
-        while (extendedPages.size() <= pageIndex)
+        if (!pages[i].load(std::memory_order_relaxed))
         {
-            extendedPages.push_back(std::unique_ptr<ExtendedCharacterInfoPage>());
-        }
-    }
-    ExtendedCharacterInfoPage* extendedPage = extendedPages[pageIndex].get();
-    if (!extendedPage)
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (!extendedPage)
-        {
-            std::string ucdFilePath = CmajorUcdFilePath();
-            BinaryReader reader(ucdFilePath);
-            uint32_t start = 0;
-            uint32_t pageStart = 0;
-            if (!headerRead)
-            {
-                ReadHeader(reader);
-                start = extendedHeaderStart - headerSize;
-            }
-            else
-            {
-                start = extendedHeaderStart;
-            }
-            if (!extendedHeaderRead)
-            {
-                reader.Skip(start);
-                ReadExtendedHeader(reader);
-                pageStart = extendedHeader.GetPageStart(pageIndex) - extendedHeaderEnd;
-            }
-            else
-            {
-                pageStart = extendedHeader.GetPageStart(pageIndex);
-            }
-            reader.Skip(pageStart);
-            extendedPage = new ExtendedCharacterInfoPage();
-            extendedPage->Read(reader);
-            extendedPages[pageIndex] = std::move(std::unique_ptr<ExtendedCharacterInfoPage>(extendedPage));
+            pages[i].store(new CharacterInfoPage(), std::memory_order_release);
         }
     }
     int infoIndex = codePoint % numInfosInPage;
-    return extendedPage->GetExtendedCharacterInfo(infoIndex);
+    CharacterInfoPage* page = pages[pageIndex].load(std::memory_order_relaxed);
+    return page->GetCharacterInfo(infoIndex);
 }
 
 ExtendedCharacterInfo& CharacterTable::CreateExtendedCharacterInfo(char32_t codePoint)
 {
     if (codePoint > 0x10FFFF)
     {
-        throw UnicodeException("invalid Unicode code point " + std::to_string(codePoint));
+        ThrowInvalidCodePoint(codePoint);
     }
     int pageIndex = codePoint / numInfosInPage;
-    while (extendedPages.size() <= pageIndex)
+    for (int i = 0; i <= pageIndex; ++i)
     {
-        extendedPages.push_back(std::unique_ptr<ExtendedCharacterInfoPage>(new ExtendedCharacterInfoPage()));
+        if (!extendedPages[i].load(std::memory_order_relaxed))
+        {
+            extendedPages[i].store(new ExtendedCharacterInfoPage(), std::memory_order_release);
+        }
     }
     int infoIndex = codePoint % numInfosInPage;
-    ExtendedCharacterInfoPage* extendedPage = extendedPages[pageIndex].get();
+    ExtendedCharacterInfoPage* extendedPage = extendedPages[pageIndex].load(std::memory_order_relaxed);
     return extendedPage->GetExtendedCharacterInfo(infoIndex);
 }
 
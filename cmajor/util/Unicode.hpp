@@ -11,6 +11,7 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <atomic>
 #include <stdexcept>
 #include <stdint.h>
 #include <cstdio>
@@ -605,6 +606,7 @@ constexpr int numInfosInPage = 1024;
 constexpr size_t characterInfoSize = sizeof(uint64_t) + sizeof(BlockId) + sizeof(GeneralCategoryId) + sizeof(AgeId) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint32_t) + 
     sizeof(uint32_t) + sizeof(ScriptId);
 constexpr size_t characterInfoPageSize = numInfosInPage * characterInfoSize;
+constexpr int numCharacterInfoPages = 0x10FFFF / numInfosInPage + 1;
 
 enum class NumericTypeId : uint8_t
 {
@@ -988,7 +990,7 @@ class CharacterInfoPage
 {
 public:
     CharacterInfoPage();
-    const CharacterInfo& GetCharacterInfo(int index) const;
+    const CharacterInfo& GetCharacterInfo(int index) const { return characterInfos[index]; }
     CharacterInfo& GetCharacterInfo(int index);
     void Write(BinaryWriter& writer);
     void Read(BinaryReader& reader);
@@ -1000,7 +1002,7 @@ class ExtendedCharacterInfoPage
 {
 public:
     ExtendedCharacterInfoPage();
-    const ExtendedCharacterInfo& GetExtendedCharacterInfo(int index) const;
+    const ExtendedCharacterInfo& GetExtendedCharacterInfo(int index) const { return extendedCharacterInfos[index]; }
     ExtendedCharacterInfo& GetExtendedCharacterInfo(int index);
     void Write(BinaryWriter& writer);
     void Read(BinaryReader& reader);
@@ -1024,30 +1026,62 @@ const uint8_t cmajor_ucd_version_1 = '1';
 const uint8_t cmajor_ucd_version_2 = '2';
 const uint8_t current_cmajor_ucd_version = cmajor_ucd_version_2;
 
+//  The character table maps cmajor_ucd.bin into memory once and decodes pages on first use.
+//  Page slots are allocated up front and never resized, so a lookup of an already decoded page is a lock-free atomic load.
+
 class CharacterTable
 {
 public:
     static void Init();
     static void Done();
     static CharacterTable& Instance() { return *instance; }
-    const CharacterInfo& GetCharacterInfo(char32_t codePoint);
+    ~CharacterTable();
+    const CharacterInfo& GetCharacterInfo(char32_t codePoint)
+    {
+        if (codePoint > 0x10FFFF)
+        {
+            ThrowInvalidCodePoint(codePoint);
+        }
+        int pageIndex = codePoint / numInfosInPage;
+        CharacterInfoPage* page = pages[pageIndex].load(std::memory_order_acquire);
+        if (!page)
+        {
+            page = LoadPage(pageIndex);
+        }
+        return page->GetCharacterInfo(codePoint % numInfosInPage);
+    }
     CharacterInfo& CreateCharacterInfo(char32_t codePoint);
-    const ExtendedCharacterInfo& GetExtendedCharacterInfo(char32_t codePoint);
+    const ExtendedCharacterInfo& GetExtendedCharacterInfo(char32_t codePoint)
+    {
+        if (codePoint > 0x10FFFF)
+        {
+            ThrowInvalidCodePoint(codePoint);
+        }
+        int pageIndex = codePoint / numInfosInPage;
+        ExtendedCharacterInfoPage* extendedPage = extendedPages[pageIndex].load(std::memory_order_acquire);
+        if (!extendedPage)
+        {
+            extendedPage = LoadExtendedPage(pageIndex);
+        }
+        return extendedPage->GetExtendedCharacterInfo(codePoint % numInfosInPage);
+    }
     ExtendedCharacterInfo& CreateExtendedCharacterInfo(char32_t codePoint);
     void Write();
 private:
     static std::unique_ptr<CharacterTable> instance;
     CharacterTable();
-    bool headerRead;
-    std::vector<std::unique_ptr<CharacterInfoPage>> pages;
+    std::unique_ptr<BinaryReader> ucdReader;
+    std::atomic<CharacterInfoPage*> pages[numCharacterInfoPages];
     uint32_t extendedHeaderStart;
     uint32_t extendedHeaderEnd;
-    bool extendedHeaderRead;
     ExtendedCharacterInfoHeader extendedHeader;
-    std::vector<std::unique_ptr<ExtendedCharacterInfoPage>> extendedPages;
+    std::atomic<ExtendedCharacterInfoPage*> extendedPages[numCharacterInfoPages];
     void WriteHeader(BinaryWriter& writer);
     void ReadHeader(BinaryReader& reader);
-    void ReadExtendedHeader(BinaryReader& reader);
+    void OpenUcdFile();
+    CharacterInfoPage* LoadPage(int pageIndex);
+    ExtendedCharacterInfoPage* LoadExtendedPage(int pageIndex);
+    void ThrowInvalidCodePoint(char32_t codePoint);
     const size_t headerSize = 16;
 };
 
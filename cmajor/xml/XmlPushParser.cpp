@@ -0,0 +1,76 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/xml/XmlPushParser.hpp>
+#include <cmajor/xml/XmlProcessor.hpp>
+#include <istream>
+#include <memory>
+
+namespace cmajor { namespace xml {
+
+const int64_t defaultMaxBufferSize = 16 * 1024 * 1024;
+const int64_t streamChunkSize = 64 * 1024;
+
+XmlPushParser::XmlPushParser(XmlSpanContentHandler* contentHandler_, const std::string& systemId_) :
+    parser(contentHandler_, systemId_), systemId(systemId_), maxBufferSize(defaultMaxBufferSize)
+{
+}
+
+void XmlPushParser::Feed(const char* data, int64_t size)
+{
+    if (parser.Finished())
+    {
+        throw XmlProcessingException("error in '" + systemId + "': data after the end of the document");
+    }
+    const char* begin = data;
+    const char* end = data + size;
+    if (!buffer.empty())
+    {
+        buffer.append(data, size);
+        begin = buffer.data();
+        end = buffer.data() + buffer.length();
+    }
+    const char* consumed = parser.Parse(begin, end, false);
+    parser.Discard(begin, consumed);
+    int64_t rest = end - consumed;
+    if (rest > maxBufferSize)
+    {
+        throw XmlProcessingException("error in '" + systemId + "': a construct of more than " + std::to_string(maxBufferSize) + " bytes exceeds the maximum buffer size");
+    }
+    if (buffer.empty())
+    {
+        buffer.assign(consumed, rest);
+    }
+    else
+    {
+        buffer.erase(0, consumed - begin);
+    }
+}
+
+void XmlPushParser::Finish()
+{
+    const char* begin = buffer.data();
+    const char* end = buffer.data() + buffer.length();
+    parser.Parse(begin, end, true);
+    buffer.clear();
+}
+
+void ParseXmlStream(std::istream& stream, const std::string& systemId, XmlSpanContentHandler* contentHandler)
+{
+    XmlPushParser parser(contentHandler, systemId);
+    std::unique_ptr<char[]> chunk(new char[streamChunkSize]);
+    while (stream)
+    {
+        stream.read(chunk.get(), streamChunkSize);
+        int64_t n = stream.gcount();
+        if (n > 0)
+        {
+            parser.Feed(chunk.get(), n);
+        }
+    }
+    parser.Finish();
+}
+
+} } // namespace cmajor::xml
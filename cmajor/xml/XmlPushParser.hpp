@@ -0,0 +1,46 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+// ==============================================================================
+// Incremental XML parser. The caller feeds UTF-8 encoded bytes in chunks of any
+// size and receives SAX events as soon as the constructs complete. Only the tail
+// of a construct that is cut by a chunk boundary is buffered; text is reported
+// in pieces as it arrives. The buffer is bounded by the maximum buffer size.
+// ==============================================================================
+
+#ifndef CMAJOR_XML_XML_PUSH_PARSER
+#define CMAJOR_XML_XML_PUSH_PARSER
+#include <cmajor/xml/XmlSpanParser.hpp>
+#include <iosfwd>
+
+namespace cmajor { namespace xml {
+
+class XmlPushParser
+{
+public:
+    XmlPushParser(XmlSpanContentHandler* contentHandler_, const std::string& systemId_);
+    XmlPushParser(const XmlPushParser&) = delete;
+    XmlPushParser& operator=(const XmlPushParser&) = delete;
+    void Feed(const char* data, int64_t size);
+    void Finish();
+    int64_t MaxBufferSize() const { return maxBufferSize; }
+    void SetMaxBufferSize(int64_t maxBufferSize_) { maxBufferSize = maxBufferSize_; }
+private:
+    XmlSpanParser parser;
+    std::string systemId;
+    std::string buffer;
+    int64_t maxBufferSize;
+};
+
+//  ==================================================================================
+//  ParseXmlStream parses UTF-8 encoded XML read from given stream in chunks using
+//  given span content handler. systemId is used for error messages only.
+//  ==================================================================================
+
+void ParseXmlStream(std::istream& stream, const std::string& systemId, XmlSpanContentHandler* contentHandler);
+
+} } // namespace cmajor::xml
+
+#endif // CMAJOR_XML_XML_PUSH_PARSER
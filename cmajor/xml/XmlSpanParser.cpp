@@ -0,0 +1,1008 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/xml/XmlSpanParser.hpp>
+#include <cmajor/xml/XmlProcessor.hpp>
+#include <cmajor/util/MappedInputFile.hpp>
+#include <cmajor/util/Unicode.hpp>
+#include <string.h>
+
+namespace cmajor { namespace xml {
+
+using namespace cmajor::util;
+using namespace cmajor::unicode;
+
+std::u32string StringSpan::ToUtf32() const
+{
+    std::u32string result;
+    result.reserve(end - begin);
+    const char* p = begin;
+    while (p != end)
+    {
+        uint8_t x = static_cast<uint8_t>(*p);
+        if (x < 0x80)
+        {
+            result.append(1, static_cast<char32_t>(x));
+            ++p;
+        }
+        else
+        {
+            Utf8ToUtf32Engine engine;
+            while (p != end)
+            {
+                engine.Put(static_cast<uint8_t>(*p));
+                ++p;
+                if (engine.ResulReady())
+                {
+                    result.append(1, engine.Result());
+                    break;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+bool operator==(const StringSpan& left, const StringSpan& right)
+{
+    return left.Length() == right.Length() && memcmp(left.Begin(), right.Begin(), left.Length()) == 0;
+}
+
+bool operator==(const StringSpan& left, const char* right)
+{
+    int64_t n = strlen(right);
+    return left.Length() == n && memcmp(left.Begin(), right, n) == 0;
+}
+
+SpanAttribute::SpanAttribute(const StringSpan& namespaceUri_, const StringSpan& localName_, const StringSpan& qualifiedName_, const StringSpan& value_) :
+    namespaceUri(namespaceUri_), localName(localName_), qualifiedName(qualifiedName_), value(value_)
+{
+}
+
+const StringSpan* SpanAttributes::GetAttributeValue(const char* namespaceUri, const char* localName) const
+{
+    for (const SpanAttribute& attribute : attributes)
+    {
+        if (attribute.NamespaceUri() == namespaceUri && attribute.LocalName() == localName)
+        {
+            return &attribute.Value();
+        }
+    }
+    return nullptr;
+}
+
+const StringSpan* SpanAttributes::GetAttributeValue(const char* qualifiedName) const
+{
+    for (const SpanAttribute& attribute : attributes)
+    {
+        if (attribute.QualifiedName() == qualifiedName)
+        {
+            return &attribute.Value();
+        }
+    }
+    return nullptr;
+}
+
+XmlSpanContentHandler::~XmlSpanContentHandler()
+{
+}
+
+XmlContentHandlerAdapter::XmlContentHandlerAdapter(XmlContentHandler* contentHandler_) : contentHandler(contentHandler_)
+{
+}
+
+void XmlContentHandlerAdapter::StartDocument()
+{
+    contentHandler->StartDocument();
+}
+
+void XmlContentHandlerAdapter::EndDocument()
+{
+    contentHandler->EndDocument();
+}
+
+void XmlContentHandlerAdapter::Version(const StringSpan& xmlVersion)
+{
+    contentHandler->Version(xmlVersion.ToUtf32());
+}
+
+void XmlContentHandlerAdapter::Standalone(bool standalone)
+{
+    contentHandler->Standalone(standalone);
+}
+
+void XmlContentHandlerAdapter::Encoding(const StringSpan& encoding)
+{
+    contentHandler->Encoding(encoding.ToUtf32());
+}
+
+void XmlContentHandlerAdapter::Text(const StringSpan& text)
+{
+    contentHandler->Text(text.ToUtf32());
+}
+
+void XmlContentHandlerAdapter::Comment(const StringSpan& comment)
+{
+    contentHandler->Comment(comment.ToUtf32());
+}
+
+void XmlContentHandlerAdapter::PI(const StringSpan& target, const StringSpan& data)
+{
+    contentHandler->PI(target.ToUtf32(), data.ToUtf32());
+}
+
+void XmlContentHandlerAdapter::CDataSection(const StringSpan& cdata)
+{
+    contentHandler->CDataSection(cdata.ToUtf32());
+}
+
+void XmlContentHandlerAdapter::StartElement(const StringSpan& namespaceUri, const StringSpan& localName, const StringSpan& qualifiedName, const SpanAttributes& spanAttributes)
+{
+    attributes.Clear();
+    for (const SpanAttribute& attribute : spanAttributes)
+    {
+        attributes.Add(Attribute(attribute.NamespaceUri().ToUtf32(), attribute.LocalName().ToUtf32(), attribute.QualifiedName().ToUtf32(), attribute.Value().ToUtf32()));
+    }
+    contentHandler->StartElement(namespaceUri.ToUtf32(), localName.ToUtf32(), qualifiedName.ToUtf32(), attributes);
+}
+
+void XmlContentHandlerAdapter::EndElement(const StringSpan& namespaceUri, const StringSpan& localName, const StringSpan& qualifiedName)
+{
+    contentHandler->EndElement(namespaceUri.ToUtf32(), localName.ToUtf32(), qualifiedName.ToUtf32());
+}
+
+void XmlContentHandlerAdapter::SkippedEntity(const StringSpan& entityName)
+{
+    contentHandler->SkippedEntity(entityName.ToUtf32());
+}
+
+inline bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool IsNameStop(char c)
+{
+    switch (c)
+    {
+        case ' ': case '\t': case '\n': case '\r': case '=': case '/': case '>': case '<': case '?': case '"': case '\'': case '&': case ';': case '[': case ']':
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline const char* SkipSpace(const char* p, const char* end)
+{
+    while (p != end && IsSpace(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+inline bool StartsWith(const char* p, const char* end, const char* s, int n)
+{
+    return end - p >= n && memcmp(p, s, n) == 0;
+}
+
+inline bool IsPrefixOf(const char* p, const char* end, const char* s, int n)
+{
+    return end - p < n && memcmp(p, s, end - p) == 0;
+}
+
+const char* Find(const char* p, const char* end, const char* s, int n)
+{
+    while (end - p >= n)
+    {
+        const char* q = static_cast<const char*>(memchr(p, s[0], end - p - n + 1));
+        if (!q)
+        {
+            return nullptr;
+        }
+        if (memcmp(q, s, n) == 0)
+        {
+            return q;
+        }
+        p = q + 1;
+    }
+    return nullptr;
+}
+
+void AppendUtf8(std::string& s, uint32_t c)
+{
+    if (c < 0x80)
+    {
+        s.append(1, static_cast<char>(c));
+    }
+    else if (c < 0x800)
+    {
+        s.append(1, static_cast<char>(0xC0 | (c >> 6)));
+        s.append(1, static_cast<char>(0x80 | (c & 0x3F)));
+    }
+    else if (c < 0x10000)
+    {
+        s.append(1, static_cast<char>(0xE0 | (c >> 12)));
+        s.append(1, static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        s.append(1, static_cast<char>(0x80 | (c & 0x3F)));
+    }
+    else
+    {
+        s.append(1, static_cast<char>(0xF0 | (c >> 18)));
+        s.append(1, static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+        s.append(1, static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        s.append(1, static_cast<char>(0x80 | (c & 0x3F)));
+    }
+}
+
+//  Returns the end of the longest prefix of a text run that does not end in the middle of a reference or an UTF-8 sequence.
+
+const char* CompleteTextEnd(const char* begin, const char* end)
+{
+    for (const char* p = end; p != begin; --p)
+    {
+        char c = p[-1];
+        if (c == ';')
+        {
+            break;
+        }
+        else if (c == '&')
+        {
+            end = p - 1;
+            break;
+        }
+    }
+    const char* p = end;
+    while (p != begin && (static_cast<uint8_t>(p[-1]) & 0xC0) == 0x80)
+    {
+        --p;
+    }
+    if (p != begin)
+    {
+        uint8_t lead = static_cast<uint8_t>(p[-1]);
+        int length = 1;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+        }
+        if (end - (p - 1) < length)
+        {
+            end = p - 1;
+        }
+    }
+    return end;
+}
+
+const char* xmlNamespaceUri = "http://www.w3.org/XML/1998/namespace";
+
+XmlSpanParser::XmlSpanParser(XmlSpanContentHandler* contentHandler_, const std::string& systemId_) :
+    contentHandler(contentHandler_), systemId(systemId_), bufferStart(nullptr), bufferOffset(0), lineNumber(1), lineStartOffset(0), started(false), atDocumentStart(true), rootSeen(false), finished(false), depth(0),
+    numNamespaceBindings(0)
+{
+}
+
+void XmlSpanParser::Parse(const char* begin, const char* end)
+{
+    Parse(begin, end, true);
+}
+
+const char* XmlSpanParser::Parse(const char* begin, const char* end, bool final)
+{
+    bufferStart = begin;
+    const char* pos = begin;
+    if (!started)
+    {
+        if (!final && IsPrefixOf(pos, end, "\xEF\xBB\xBF", 3))
+        {
+            return pos;
+        }
+        if (StartsWith(pos, end, "\xEF\xBB\xBF", 3))
+        {
+            pos += 3;
+        }
+        started = true;
+        contentHandler->StartDocument();
+    }
+    while (pos != end && !finished)
+    {
+        if (!ParseNext(pos, end, final))
+        {
+            return pos;
+        }
+        atDocumentStart = false;
+    }
+    if (final && !finished)
+    {
+        if (depth > 0)
+        {
+            throw XmlProcessingException(GetErrorLocationStr(pos) + ": unexpected end of content, element '" + tagStack[depth - 1] + "' not closed");
+        }
+        if (!rootSeen)
+        {
+            throw XmlProcessingException(GetErrorLocationStr(pos) + ": document has no root element");
+        }
+        finished = true;
+        contentHandler->EndDocument();
+    }
+    return pos;
+}
+
+void XmlSpanParser::Discard(const char* begin, const char* end)
+{
+    const char* p = begin;
+    while (p != end)
+    {
+        const char* q = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!q)
+        {
+            break;
+        }
+        ++lineNumber;
+        p = q + 1;
+        lineStartOffset = bufferOffset + (p - begin);
+    }
+    bufferOffset += end - begin;
+}
+
+bool XmlSpanParser::ParseNext(const char*& pos, const char* end, bool final)
+{
+    if (*pos != '<')
+    {
+        return ParseText(pos, end, final);
+    }
+    if (end - pos < 2)
+    {
+        return NeedMore(end, final, pos, "markup");
+    }
+    char c = pos[1];
+    if (c == '/')
+    {
+        return ParseEndTag(pos, end, final);
+    }
+    else if (c == '?')
+    {
+        return ParsePI(pos, end, final);
+    }
+    else if (c == '!')
+    {
+        if (StartsWith(pos, end, "<!--", 4))
+        {
+            return ParseComment(pos, end, final);
+        }
+        else if (StartsWith(pos, end, "<![CDATA[", 9))
+        {
+            return ParseCDataSection(pos, end, final);
+        }
+        else if (StartsWith(pos, end, "<!DOCTYPE", 9))
+        {
+            return ParseDocType(pos, end, final);
+        }
+        else if (IsPrefixOf(pos, end, "<!--", 4) || IsPrefixOf(pos, end, "<![CDATA[", 9) || IsPrefixOf(pos, end, "<!DOCTYPE", 9))
+        {
+            return NeedMore(end, final, pos, "markup declaration");
+        }
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": invalid markup declaration");
+    }
+    return ParseStartTag(pos, end, final);
+}
+
+bool XmlSpanParser::ParseText(const char*& pos, const char* end, bool final)
+{
+    const char* textEnd = static_cast<const char*>(memchr(pos, '<', end - pos));
+    if (!textEnd)
+    {
+        textEnd = end;
+        if (!final && depth > 0)
+        {
+            textEnd = CompleteTextEnd(pos, end);
+            if (textEnd == pos)
+            {
+                return false;
+            }
+        }
+    }
+    if (depth == 0)
+    {
+        const char* p = SkipSpace(pos, textEnd);
+        if (p != textEnd)
+        {
+            throw XmlProcessingException(GetErrorLocationStr(p) + ": text not allowed outside the root element");
+        }
+        pos = textEnd;
+        return true;
+    }
+    const char* amp = static_cast<const char*>(memchr(pos, '&', textEnd - pos));
+    if (!amp)
+    {
+        contentHandler->Text(StringSpan(pos, textEnd));
+        pos = textEnd;
+        return true;
+    }
+    text.assign(pos, amp);
+    const char* p = amp;
+    while (p != textEnd)
+    {
+        if (*p == '&')
+        {
+            StringSpan entityName;
+            if (!DecodeReference(p, textEnd, text, entityName, p))
+            {
+                if (!text.empty())
+                {
+                    contentHandler->Text(StringSpan(text.data(), text.data() + text.length()));
+                    text.clear();
+                }
+                contentHandler->SkippedEntity(entityName);
+            }
+        }
+        else
+        {
+            const char* next = static_cast<const char*>(memchr(p, '&', textEnd - p));
+            if (!next)
+            {
+                next = textEnd;
+            }
+            text.append(p, next);
+            p = next;
+        }
+    }
+    if (!text.empty())
+    {
+        contentHandler->Text(StringSpan(text.data(), text.data() + text.length()));
+    }
+    pos = textEnd;
+    return true;
+}
+
+bool XmlSpanParser::ParseStartTag(const char*& pos, const char* end, bool final)
+{
+    const char* p = pos + 1;
+    char quote = '\0';
+    while (p != end)
+    {
+        char c = *p;
+        if (quote)
+        {
+            const char* q = static_cast<const char*>(memchr(p, quote, end - p));
+            if (!q)
+            {
+                p = end;
+                break;
+            }
+            p = q + 1;
+            quote = '\0';
+            continue;
+        }
+        if (c == '>')
+        {
+            break;
+        }
+        else if (c == '"' || c == '\'')
+        {
+            quote = c;
+        }
+        else if (c == '<')
+        {
+            throw XmlProcessingException(GetErrorLocationStr(p) + ": '<' not allowed in a start tag");
+        }
+        ++p;
+    }
+    if (p == end)
+    {
+        return NeedMore(end, final, pos, "start tag");
+    }
+    const char* tagEnd = p;
+    bool empty = tagEnd[-1] == '/';
+    const char* contentEnd = empty ? tagEnd - 1 : tagEnd;
+    if (depth == 0 && rootSeen)
+    {
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": document can have only one root element");
+    }
+    const char* nameBegin = pos + 1;
+    const char* nameEnd = ParseName(nameBegin, contentEnd);
+    StringSpan qualifiedName(nameBegin, nameEnd);
+    rawAttributes.clear();
+    attributeValues.clear();
+    ++depth;
+    int bindingsBefore = numNamespaceBindings;
+    p = nameEnd;
+    while (true)
+    {
+        const char* q = SkipSpace(p, contentEnd);
+        if (q == contentEnd)
+        {
+            break;
+        }
+        if (q == p)
+        {
+            throw XmlProcessingException(GetErrorLocationStr(q) + ": white space expected");
+        }
+        const char* attNameEnd = ParseName(q, contentEnd);
+        StringSpan attName(q, attNameEnd);
+        p = SkipSpace(attNameEnd, contentEnd);
+        if (p == contentEnd || *p != '=')
+        {
+            throw XmlProcessingException(GetErrorLocationStr(p) + ": '=' expected");
+        }
+        p = SkipSpace(p + 1, contentEnd);
+        if (p == contentEnd || (*p != '"' && *p != '\''))
+        {
+            throw XmlProcessingException(GetErrorLocationStr(p) + ": quoted attribute value expected");
+        }
+        const char* valueBegin = p + 1;
+        const char* valueEnd = static_cast<const char*>(memchr(valueBegin, *p, contentEnd - valueBegin));
+        if (!valueEnd)
+        {
+            throw XmlProcessingException(GetErrorLocationStr(p) + ": unterminated attribute value");
+        }
+        p = valueEnd + 1;
+        RawAttribute attribute;
+        attribute.qualifiedName = attName;
+        attribute.value = StringSpan(valueBegin, valueEnd);
+        attribute.decodedBegin = -1;
+        attribute.decodedEnd = -1;
+        if (memchr(valueBegin, '&', valueEnd - valueBegin))
+        {
+            attribute.decodedBegin = attributeValues.length();
+            DecodeValue(valueBegin, valueEnd, attributeValues, valueBegin);
+            attribute.decodedEnd = attributeValues.length();
+            attribute.value = StringSpan(attributeValues.data() + attribute.decodedBegin, attributeValues.data() + attribute.decodedEnd);
+        }
+        if (StartsWith(attName.Begin(), attName.End(), "xmlns", 5))
+        {
+            if (attName.Length() == 5)
+            {
+                BindNamespace(StringSpan(), attribute.value);
+                continue;
+            }
+            else if (attName.Begin()[5] == ':')
+            {
+                BindNamespace(StringSpan(attName.Begin() + 6, attName.End()), attribute.value);
+                continue;
+            }
+        }
+        rawAttributes.push_back(attribute);
+    }
+    attributes.Clear();
+    for (const RawAttribute& attribute : rawAttributes)
+    {
+        StringSpan value = attribute.value;
+        if (attribute.decodedBegin != -1)
+        {
+            value = StringSpan(attributeValues.data() + attribute.decodedBegin, attributeValues.data() + attribute.decodedEnd);
+        }
+        StringSpan prefix;
+        StringSpan localName;
+        SplitQualifiedName(attribute.qualifiedName, prefix, localName, attribute.qualifiedName.Begin());
+        attributes.Add(SpanAttribute(GetNamespaceUri(prefix, false, attribute.qualifiedName.Begin()), localName, attribute.qualifiedName, value));
+    }
+    StringSpan prefix;
+    StringSpan localName;
+    SplitQualifiedName(qualifiedName, prefix, localName, nameBegin);
+    if (prefix == "xmlns")
+    {
+        throw XmlProcessingException(GetErrorLocationStr(nameBegin) + ": 'xmlns' prefix cannot be declared for an element");
+    }
+    StringSpan namespaceUri = GetNamespaceUri(prefix, true, nameBegin);
+    rootSeen = true;
+    contentHandler->StartElement(namespaceUri, localName, qualifiedName, attributes);
+    if (empty)
+    {
+        contentHandler->EndElement(namespaceUri, localName, qualifiedName);
+        --depth;
+        numNamespaceBindings = bindingsBefore;
+    }
+    else
+    {
+        if (int(tagStack.size()) < depth)
+        {
+            tagStack.resize(depth);
+        }
+        tagStack[depth - 1].assign(qualifiedName.Begin(), qualifiedName.End());
+    }
+    pos = tagEnd + 1;
+    return true;
+}
+
+bool XmlSpanParser::ParseEndTag(const char*& pos, const char* end, bool final)
+{
+    const char* tagEnd = static_cast<const char*>(memchr(pos, '>', end - pos));
+    if (!tagEnd)
+    {
+        return NeedMore(end, final, pos, "end tag");
+    }
+    const char* nameBegin = pos + 2;
+    const char* nameEnd = ParseName(nameBegin, tagEnd);
+    if (SkipSpace(nameEnd, tagEnd) != tagEnd)
+    {
+        throw XmlProcessingException(GetErrorLocationStr(nameEnd) + ": '>' expected");
+    }
+    StringSpan qualifiedName(nameBegin, nameEnd);
+    if (depth == 0)
+    {
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": end tag '" + qualifiedName.ToString() + "' has no corresponding start tag");
+    }
+    const std::string& startTag = tagStack[depth - 1];
+    if (qualifiedName.Length() != int64_t(startTag.length()) || memcmp(nameBegin, startTag.data(), startTag.length()) != 0)
+    {
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": end tag '" + qualifiedName.ToString() + "' does not match start tag '" + startTag + "'");
+    }
+    StringSpan prefix;
+    StringSpan localName;
+    SplitQualifiedName(qualifiedName, prefix, localName, nameBegin);
+    contentHandler->EndElement(GetNamespaceUri(prefix, true, nameBegin), localName, qualifiedName);
+    while (numNamespaceBindings > 0 && namespaceBindings[numNamespaceBindings - 1].depth == depth)
+    {
+        --numNamespaceBindings;
+    }
+    --depth;
+    pos = tagEnd + 1;
+    return true;
+}
+
+bool XmlSpanParser::ParseComment(const char*& pos, const char* end, bool final)
+{
+    const char* commentBegin = pos + 4;
+    const char* commentEnd = Find(commentBegin, end, "-->", 3);
+    if (!commentEnd)
+    {
+        return NeedMore(end, final, pos, "comment");
+    }
+    contentHandler->Comment(StringSpan(commentBegin, commentEnd));
+    pos = commentEnd + 3;
+    return true;
+}
+
+bool XmlSpanParser::ParseCDataSection(const char*& pos, const char* end, bool final)
+{
+    const char* cdataBegin = pos + 9;
+    const char* cdataEnd = Find(cdataBegin, end, "]]>", 3);
+    if (!cdataEnd)
+    {
+        return NeedMore(end, final, pos, "CDATA section");
+    }
+    if (depth == 0)
+    {
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": CDATA section not allowed outside the root element");
+    }
+    contentHandler->CDataSection(StringSpan(cdataBegin, cdataEnd));
+    pos = cdataEnd + 3;
+    return true;
+}
+
+bool XmlSpanParser::ParsePI(const char*& pos, const char* end, bool final)
+{
+    const char* piEnd = Find(pos + 2, end, "?>", 2);
+    if (!piEnd)
+    {
+        return NeedMore(end, final, pos, "processing instruction");
+    }
+    const char* targetBegin = pos + 2;
+    const char* targetEnd = ParseName(targetBegin, piEnd);
+    StringSpan target(targetBegin, targetEnd);
+    if (target == "xml")
+    {
+        if (!atDocumentStart)
+        {
+            throw XmlProcessingException(GetErrorLocationStr(pos) + ": XML declaration allowed only at the start of the document");
+        }
+        ParseXmlDeclaration(targetEnd, piEnd);
+    }
+    else
+    {
+        contentHandler->PI(target, StringSpan(SkipSpace(targetEnd, piEnd), piEnd));
+    }
+    pos = piEnd + 2;
+    return true;
+}
+
+bool XmlSpanParser::ParseDocType(const char*& pos, const char* end, bool final)
+{
+    if (rootSeen)
+    {
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": document type declaration not allowed after the root element");
+    }
+    const char* p = pos + 9;
+    char quote = '\0';
+    int bracketLevel = 0;
+    while (p != end)
+    {
+        char c = *p;
+        if (quote)
+        {
+            if (c == quote)
+            {
+                quote = '\0';
+            }
+        }
+        else if (c == '"' || c == '\'')
+        {
+            quote = c;
+        }
+        else if (c == '[')
+        {
+            ++bracketLevel;
+        }
+        else if (c == ']')
+        {
+            --bracketLevel;
+        }
+        else if (c == '>' && bracketLevel == 0)
+        {
+            pos = p + 1;
+            return true;
+        }
+        ++p;
+    }
+    return NeedMore(end, final, pos, "document type declaration");
+}
+
+void XmlSpanParser::ParseXmlDeclaration(const char* begin, const char* end)
+{
+    const char* p = begin;
+    while (true)
+    {
+        p = SkipSpace(p, end);
+        if (p == end)
+        {
+            break;
+        }
+        const char* nameEnd = ParseName(p, end);
+        StringSpan name(p, nameEnd);
+        p = SkipSpace(nameEnd, end);
+        if (p == end || *p != '=')
+        {
+            throw XmlProcessingException(GetErrorLocationStr(p) + ": '=' expected");
+        }
+        p = SkipSpace(p + 1, end);
+        if (p == end || (*p != '"' && *p != '\''))
+        {
+            throw XmlProcessingException(GetErrorLocationStr(p) + ": quoted value expected");
+        }
+        const char* valueBegin = p + 1;
+        const char* valueEnd = static_cast<const char*>(memchr(valueBegin, *p, end - valueBegin));
+        if (!valueEnd)
+        {
+            throw XmlProcessingException(GetErrorLocationStr(p) + ": unterminated value");
+        }
+        StringSpan value(valueBegin, valueEnd);
+        if (name == "version")
+        {
+            contentHandler->Version(value);
+        }
+        else if (name == "encoding")
+        {
+            contentHandler->Encoding(value);
+        }
+        else if (name == "standalone")
+        {
+            contentHandler->Standalone(value == "yes");
+        }
+        else
+        {
+            throw XmlProcessingException(GetErrorLocationStr(name.Begin()) + ": unknown XML declaration attribute '" + name.ToString() + "'");
+        }
+        p = valueEnd + 1;
+    }
+}
+
+const char* XmlSpanParser::ParseName(const char* pos, const char* end)
+{
+    const char* p = pos;
+    while (p != end && !IsNameStop(*p))
+    {
+        ++p;
+    }
+    if (p == pos || (*pos >= '0' && *pos <= '9') || *pos == '-' || *pos == '.')
+    {
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": name expected");
+    }
+    return p;
+}
+
+void XmlSpanParser::SplitQualifiedName(const StringSpan& qualifiedName, StringSpan& prefix, StringSpan& localName, const char* pos)
+{
+    const char* colon = static_cast<const char*>(memchr(qualifiedName.Begin(), ':', qualifiedName.Length()));
+    if (!colon)
+    {
+        prefix = StringSpan();
+        localName = qualifiedName;
+        return;
+    }
+    if (memchr(colon + 1, ':', qualifiedName.End() - colon - 1))
+    {
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": qualified name '" + qualifiedName.ToString() + "' has more than one ':' character");
+    }
+    prefix = StringSpan(qualifiedName.Begin(), colon);
+    localName = StringSpan(colon + 1, qualifiedName.End());
+}
+
+StringSpan XmlSpanParser::GetNamespaceUri(const StringSpan& prefix, bool defaultNamespace, const char* pos)
+{
+    if (prefix.IsEmpty() && !defaultNamespace)
+    {
+        return StringSpan();
+    }
+    for (int i = numNamespaceBindings - 1; i >= 0; --i)
+    {
+        const NamespaceBinding& binding = namespaceBindings[i];
+        if (prefix.Length() == int64_t(binding.prefix.length()) && memcmp(prefix.Begin(), binding.prefix.data(), binding.prefix.length()) == 0)
+        {
+            return StringSpan(binding.uri.data(), binding.uri.data() + binding.uri.length());
+        }
+    }
+    if (prefix.IsEmpty())
+    {
+        return StringSpan();
+    }
+    if (prefix == "xml")
+    {
+        return StringSpan(xmlNamespaceUri, xmlNamespaceUri + strlen(xmlNamespaceUri));
+    }
+    throw XmlProcessingException(GetErrorLocationStr(pos) + ": namespace prefix '" + prefix.ToString() + "' not bound to any namespace URI");
+}
+
+void XmlSpanParser::BindNamespace(const StringSpan& prefix, const StringSpan& uri)
+{
+    if (numNamespaceBindings == int(namespaceBindings.size()))
+    {
+        namespaceBindings.push_back(NamespaceBinding());
+    }
+    NamespaceBinding& binding = namespaceBindings[numNamespaceBindings++];
+    binding.prefix.assign(prefix.Begin(), prefix.End());
+    binding.uri.assign(uri.Begin(), uri.End());
+    binding.depth = depth;
+}
+
+void XmlSpanParser::DecodeValue(const char* begin, const char* end, std::string& value, const char* pos)
+{
+    const char* p = begin;
+    while (p != end)
+    {
+        if (*p == '&')
+        {
+            StringSpan entityName;
+            if (!DecodeReference(p, end, value, entityName, p))
+            {
+                contentHandler->SkippedEntity(entityName);
+            }
+        }
+        else
+        {
+            value.append(1, *p);
+            ++p;
+        }
+    }
+}
+
+bool XmlSpanParser::DecodeReference(const char*& p, const char* end, std::string& value, StringSpan& entityName, const char* pos)
+{
+    const char* semicolon = static_cast<const char*>(memchr(p, ';', end - p));
+    if (!semicolon)
+    {
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": ';' expected");
+    }
+    const char* nameBegin = p + 1;
+    p = semicolon + 1;
+    if (nameBegin != semicolon && *nameBegin == '#')
+    {
+        uint32_t c = 0;
+        const char* q = nameBegin + 1;
+        bool hex = q != semicolon && *q == 'x';
+        if (hex)
+        {
+            ++q;
+        }
+        if (q == semicolon)
+        {
+            throw XmlProcessingException(GetErrorLocationStr(pos) + ": invalid character reference");
+        }
+        for (; q != semicolon; ++q)
+        {
+            char x = *q;
+            uint32_t digit = 0;
+            if (x >= '0' && x <= '9')
+            {
+                digit = x - '0';
+            }
+            else if (hex && x >= 'a' && x <= 'f')
+            {
+                digit = 10 + x - 'a';
+            }
+            else if (hex && x >= 'A' && x <= 'F')
+            {
+                digit = 10 + x - 'A';
+            }
+            else
+            {
+                throw XmlProcessingException(GetErrorLocationStr(pos) + ": invalid character reference");
+            }
+            c = c * (hex ? 16 : 10) + digit;
+            if (c > 0x10FFFF)
+            {
+                throw XmlProcessingException(GetErrorLocationStr(pos) + ": character reference out of range");
+            }
+        }
+        AppendUtf8(value, c);
+        return true;
+    }
+    StringSpan name(nameBegin, semicolon);
+    if (name == "lt")
+    {
+        value.append(1, '<');
+    }
+    else if (name == "gt")
+    {
+        value.append(1, '>');
+    }
+    else if (name == "amp")
+    {
+        value.append(1, '&');
+    }
+    else if (name == "quot")
+    {
+        value.append(1, '"');
+    }
+    else if (name == "apos")
+    {
+        value.append(1, '\'');
+    }
+    else
+    {
+        ParseName(nameBegin, semicolon);
+        entityName = name;
+        return false;
+    }
+    return true;
+}
+
+bool XmlSpanParser::NeedMore(const char* end, bool final, const char* pos, const char* what)
+{
+    if (final)
+    {
+        throw XmlProcessingException(GetErrorLocationStr(pos) + ": unexpected end of content in " + std::string(what));
+    }
+    return false;
+}
+
+std::string XmlSpanParser::GetErrorLocationStr(const char* pos) const
+{
+    int64_t line = lineNumber;
+    int64_t lineStart = lineStartOffset;
+    for (const char* p = bufferStart; p < pos; ++p)
+    {
+        if (*p == '\n')
+        {
+            ++line;
+            lineStart = bufferOffset + (p + 1 - bufferStart);
+        }
+    }
+    int64_t index = bufferOffset + (pos - bufferStart);
+    int64_t column = index - lineStart + 1;
+    return "error in '" + systemId + "' at line " + std::to_string(line) + " column " + std::to_string(column) + " (index " + std::to_string(index) + ")";
+}
+
+void ParseXmlFileSpans(const std::string& xmlFileName, XmlSpanContentHandler* contentHandler)
+{
+    MappedInputFile xmlFile(xmlFileName);
+    ParseXmlContentSpans(xmlFile.Begin(), xmlFile.End(), xmlFileName, contentHandler);
+}
+
+void ParseXmlContentSpans(const char* begin, const char* end, const std::string& systemId, XmlSpanContentHandler* contentHandler)
+{
+    XmlSpanParser parser(contentHandler, systemId);
+    parser.Parse(begin, end);
+}
+
+} } // namespace cmajor::xml
@@ -0,0 +1,210 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+// ==============================================================================
+// Interface to a non-validating zero-copy XML parser with SAX-like API.
+// The parser works directly on an UTF-8 encoded buffer and hands out spans that
+// refer either to the buffer itself or to internal scratch storage of the parser.
+// Spans are valid only for the duration of the content handler callback.
+// Strings are materialized only when the handler asks for them.
+// ==============================================================================
+
+#ifndef CMAJOR_XML_XML_SPAN_PARSER
+#define CMAJOR_XML_XML_SPAN_PARSER
+#include <cmajor/xml/XmlContentHandler.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace cmajor { namespace xml {
+
+class StringSpan
+{
+public:
+    StringSpan() : begin(nullptr), end(nullptr) {}
+    StringSpan(const char* begin_, const char* end_) : begin(begin_), end(end_) {}
+    const char* Begin() const { return begin; }
+    const char* End() const { return end; }
+    int64_t Length() const { return end - begin; }
+    bool IsEmpty() const { return begin == end; }
+    std::string ToString() const { return std::string(begin, end); }
+    std::u32string ToUtf32() const;
+private:
+    const char* begin;
+    const char* end;
+};
+
+bool operator==(const StringSpan& left, const StringSpan& right);
+bool operator==(const StringSpan& left, const char* right);
+
+inline bool operator!=(const StringSpan& left, const StringSpan& right)
+{
+    return !(left == right);
+}
+
+inline bool operator!=(const StringSpan& left, const char* right)
+{
+    return !(left == right);
+}
+
+class SpanAttribute
+{
+public:
+    SpanAttribute(const StringSpan& namespaceUri_, const StringSpan& localName_, const StringSpan& qualifiedName_, const StringSpan& value_);
+    const StringSpan& NamespaceUri() const { return namespaceUri; }
+    const StringSpan& LocalName() const { return localName; }
+    const StringSpan& QualifiedName() const { return qualifiedName; }
+    const StringSpan& Value() const { return value; }
+private:
+    StringSpan namespaceUri;
+    StringSpan localName;
+    StringSpan qualifiedName;
+    StringSpan value;
+};
+
+class SpanAttributes
+{
+public:
+    typedef std::vector<SpanAttribute>::const_iterator const_iterator;
+    const_iterator begin() const { return attributes.begin(); }
+    const_iterator end() const { return attributes.end(); }
+    const_iterator cbegin() const { return attributes.cbegin(); }
+    const_iterator cend() const { return attributes.cend(); }
+    int Count() const { return int(attributes.size()); }
+    bool IsEmpty() const { return attributes.empty(); }
+    void Add(const SpanAttribute& attribute) { attributes.push_back(attribute); }
+    void Clear() { attributes.clear(); }
+    const StringSpan* GetAttributeValue(const char* namespaceUri, const char* localName) const;
+    const StringSpan* GetAttributeValue(const char* qualifiedName) const;
+private:
+    std::vector<SpanAttribute> attributes;
+};
+
+class XmlSpanContentHandler
+{
+public:
+    virtual ~XmlSpanContentHandler();
+    virtual void StartDocument() {}
+    virtual void EndDocument() {}
+    virtual void Version(const StringSpan& xmlVersion) {}
+    virtual void Standalone(bool standalone) {}
+    virtual void Encoding(const StringSpan& encoding) {}
+    virtual void Text(const StringSpan& text) {}
+    virtual void Comment(const StringSpan& comment) {}
+    virtual void PI(const StringSpan& target, const StringSpan& data) {}
+    virtual void CDataSection(const StringSpan& cdata) {}
+    virtual void StartElement(const StringSpan& namespaceUri, const StringSpan& localName, const StringSpan& qualifiedName, const SpanAttributes& attributes) {}
+    virtual void EndElement(const StringSpan& namespaceUri, const StringSpan& localName, const StringSpan& qualifiedName) {}
+    virtual void SkippedEntity(const StringSpan& entityName) {}
+};
+
+//  Forwards span events to an ordinary content handler materializing the strings it needs.
+
+class XmlContentHandlerAdapter : public XmlSpanContentHandler
+{
+public:
+    XmlContentHandlerAdapter(XmlContentHandler* contentHandler_);
+    void StartDocument() override;
+    void EndDocument() override;
+    void Version(const StringSpan& xmlVersion) override;
+    void Standalone(bool standalone) override;
+    void Encoding(const StringSpan& encoding) override;
+    void Text(const StringSpan& text) override;
+    void Comment(const StringSpan& comment) override;
+    void PI(const StringSpan& target, const StringSpan& data) override;
+    void CDataSection(const StringSpan& cdata) override;
+    void StartElement(const StringSpan& namespaceUri, const StringSpan& localName, const StringSpan& qualifiedName, const SpanAttributes& attributes) override;
+    void EndElement(const StringSpan& namespaceUri, const StringSpan& localName, const StringSpan& qualifiedName) override;
+    void SkippedEntity(const StringSpan& entityName) override;
+private:
+    XmlContentHandler* contentHandler;
+    Attributes attributes;
+};
+
+class XmlSpanParser
+{
+public:
+    XmlSpanParser(XmlSpanContentHandler* contentHandler_, const std::string& systemId_);
+    XmlSpanParser(const XmlSpanParser&) = delete;
+    XmlSpanParser& operator=(const XmlSpanParser&) = delete;
+    //  Parses a complete document contained in the buffer [begin, end).
+    void Parse(const char* begin, const char* end);
+    //  Parses as many complete constructs from [begin, end) as possible and returns a pointer to the first unconsumed byte.
+    //  If final is false, a construct that is cut by the end of the buffer is left unconsumed, otherwise it is an error.
+    //  Character data is not held back: the complete part of a cut text run is reported, so text may arrive in several Text calls.
+    //  Consecutive calls continue from where the previous call stopped; the unconsumed bytes must be passed again at the start of the next buffer.
+    const char* Parse(const char* begin, const char* end, bool final);
+    //  Tells the parser that the bytes [begin, end) have been consumed and will not be seen again, so that line numbers stay correct.
+    void Discard(const char* begin, const char* end);
+    bool Finished() const { return finished; }
+private:
+    struct NamespaceBinding
+    {
+        NamespaceBinding() : depth(0) {}
+        std::string prefix;
+        std::string uri;
+        int depth;
+    };
+    struct RawAttribute
+    {
+        StringSpan qualifiedName;
+        StringSpan value;
+        int64_t decodedBegin;
+        int64_t decodedEnd;
+    };
+    XmlSpanContentHandler* contentHandler;
+    std::string systemId;
+    const char* bufferStart;
+    int64_t bufferOffset;
+    int64_t lineNumber;
+    int64_t lineStartOffset;
+    bool started;
+    bool atDocumentStart;
+    bool rootSeen;
+    bool finished;
+    std::vector<std::string> tagStack;
+    int depth;
+    std::vector<NamespaceBinding> namespaceBindings;
+    int numNamespaceBindings;
+    SpanAttributes attributes;
+    std::vector<RawAttribute> rawAttributes;
+    std::string attributeValues;
+    std::string text;
+    bool ParseNext(const char*& pos, const char* end, bool final);
+    bool ParseText(const char*& pos, const char* end, bool final);
+    bool ParseStartTag(const char*& pos, const char* end, bool final);
+    bool ParseEndTag(const char*& pos, const char* end, bool final);
+    bool ParseComment(const char*& pos, const char* end, bool final);
+    bool ParseCDataSection(const char*& pos, const char* end, bool final);
+    bool ParsePI(const char*& pos, const char* end, bool final);
+    bool ParseDocType(const char*& pos, const char* end, bool final);
+    void ParseXmlDeclaration(const char* begin, const char* end);
+    const char* ParseName(const char* pos, const char* end);
+    void SplitQualifiedName(const StringSpan& qualifiedName, StringSpan& prefix, StringSpan& localName, const char* pos);
+    StringSpan GetNamespaceUri(const StringSpan& prefix, bool defaultNamespace, const char* pos);
+    void BindNamespace(const StringSpan& prefix, const StringSpan& uri);
+    void DecodeValue(const char* begin, const char* end, std::string& value, const char* pos);
+    bool DecodeReference(const char*& p, const char* end, std::string& value, StringSpan& entityName, const char* pos);
+    bool NeedMore(const char* end, bool final, const char* pos, const char* what);
+    std::string GetErrorLocationStr(const char* pos) const;
+};
+
+//  ==================================================================================
+//  ParseXmlFileSpans parses given UTF-8 encoded XML file using given span content
+//  handler. The file is memory mapped and not copied.
+//  ==================================================================================
+
+void ParseXmlFileSpans(const std::string& xmlFileName, XmlSpanContentHandler* contentHandler);
+
+//  ==================================================================================
+//  ParseXmlContentSpans parses given UTF-8 encoded XML buffer using given span content
+//  handler. systemId is used for error messages only.
+//  ==================================================================================
+
+void ParseXmlContentSpans(const char* begin, const char* end, const std::string& systemId, XmlSpanContentHandler* contentHandler);
+
+} } // namespace cmajor::xml
+
+#endif // CMAJOR_XML_XML_SPAN_PARSER
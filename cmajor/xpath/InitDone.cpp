@@ -6,6 +6,7 @@
 #include <cmajor/xpath/InitDone.hpp>
 #include <cmajor/xpath/XPathFunction.hpp>
 #include <cmajor/xpath/XPathDebug.hpp>
+#include <cmajor/xpath/XPathQuery.hpp>
 
 namespace cmajor { namespace xpath {
 
@@ -13,10 +14,12 @@ void Init()
 {
     InitFunction();
     InitDebug();
+    InitQuery();
 }
 
 void Done()
 {
+    DoneQuery();
     DoneDebug();
     DoneFunction();
 }
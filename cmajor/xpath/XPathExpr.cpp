@@ -1137,6 +1137,7 @@ std::unique_ptr<XPathObject> XPathUnionExpr::Evaluate(XPathContext& context)
     {
         result->Add((*rightNodeSet)[i]);
     }
+    result->SortInDocumentOrder();
     return std::unique_ptr<XPathObject>(result.release());
 }
 
@@ -1179,6 +1180,7 @@ std::unique_ptr<XPathObject> XPathCombineStepExpr::Evaluate(XPathContext& contex
             result->Add(node);
         }
     }
+    result->SortInDocumentOrder();
     return std::unique_ptr<XPathObject>(result.release());
 }
 
@@ -1269,45 +1271,188 @@ std::unique_ptr<dom::Node> XPathFilterExpr::ToDom() const
     return std::unique_ptr<dom::Node>(element.release());
 }
 
-class NodeSelectionOp : public cmajor::dom::NodeOp
+class NodeCollectorOp : public cmajor::dom::NodeOp
 {
 public:
-    NodeSelectionOp(XPathNodeTestExpr* nodeTest_, XPathNodeSet& nodeSet_, Axis axis_);
+    NodeCollectorOp(std::vector<cmajor::dom::Node*>& nodes_);
     void Apply(cmajor::dom::Node* node) override;
 private:
-    XPathNodeTestExpr* nodeTest;
-    XPathNodeSet& nodeSet;
+    std::vector<cmajor::dom::Node*>& nodes;
+};
+
+NodeCollectorOp::NodeCollectorOp(std::vector<cmajor::dom::Node*>& nodes_) : nodes(nodes_)
+{
+}
+
+void NodeCollectorOp::Apply(cmajor::dom::Node* node)
+{
+    nodes.push_back(node);
+}
+
+// Returns the nodes of an axis one at a time in the same order as Node::Walk visits them, so that a location step can stop as soon as it has found the node it needs.
+// The tree axes are followed through the sibling and parent links; the following, preceding, attribute and namespace axes are collected with Walk up front.
+
+class AxisIterator
+{
+public:
+    AxisIterator(cmajor::dom::Node* contextNode_, Axis axis_);
+    cmajor::dom::Node* Next();
+private:
+    cmajor::dom::Node* contextNode;
     Axis axis;
+    cmajor::dom::Node* current;
+    bool started;
+    std::vector<cmajor::dom::Node*> nodes;
+    int index;
+    cmajor::dom::Node* FirstChild(cmajor::dom::Node* node) const;
+    cmajor::dom::Node* NextInDocumentOrder(cmajor::dom::Node* node) const;
 };
 
-NodeSelectionOp::NodeSelectionOp(XPathNodeTestExpr* nodeTest_, XPathNodeSet& nodeSet_, Axis axis_) : nodeTest(nodeTest_), nodeSet(nodeSet_), axis(axis_)
+AxisIterator::AxisIterator(cmajor::dom::Node* contextNode_, Axis axis_) : contextNode(contextNode_), axis(axis_), current(nullptr), started(false), index(0)
 {
 }
 
-void NodeSelectionOp::Apply(cmajor::dom::Node* node)
+cmajor::dom::Node* AxisIterator::FirstChild(cmajor::dom::Node* node) const
+{
+    if (node->HasChildNodes())
+    {
+        return static_cast<cmajor::dom::ParentNode*>(node)->FirstChild();
+    }
+    return nullptr;
+}
+
+cmajor::dom::Node* AxisIterator::NextInDocumentOrder(cmajor::dom::Node* node) const
 {
-    if (nodeTest->Select(node, axis))
+    cmajor::dom::Node* firstChild = FirstChild(node);
+    if (firstChild)
+    {
+        return firstChild;
+    }
+    while (node && node != contextNode)
     {
-        nodeSet.Add(node);
+        if (node->NextSibling())
+        {
+            return node->NextSibling();
+        }
+        node = node->Parent();
     }
+    return nullptr;
 }
 
-XPathLocationStepExpr::XPathLocationStepExpr(Axis axis_, XPathNodeTestExpr* nodeTest_) : axis(axis_), nodeTest(nodeTest_)
+cmajor::dom::Node* AxisIterator::Next()
+{
+    if (started && !current && nodes.empty())
+    {
+        return nullptr;
+    }
+    bool first = !started;
+    started = true;
+    switch (axis)
+    {
+        case Axis::self: current = first ? contextNode : nullptr; break;
+        case Axis::child: current = first ? FirstChild(contextNode) : current->NextSibling(); break;
+        case Axis::descendant: current = first ? FirstChild(contextNode) : NextInDocumentOrder(current); break;
+        case Axis::descendantOrSelf: current = first ? contextNode : NextInDocumentOrder(current); break;
+        case Axis::parent: current = first ? contextNode->Parent() : nullptr; break;
+        case Axis::ancestor: current = first ? contextNode->Parent() : current->Parent(); break;
+        case Axis::ancestorOrSelf: current = first ? contextNode : current->Parent(); break;
+        case Axis::followingSibling: current = first ? contextNode->NextSibling() : current->NextSibling(); break;
+        case Axis::precedingSibling: current = first ? contextNode->PreviousSibling() : current->PreviousSibling(); break;
+        default:
+        {
+            if (first)
+            {
+                NodeCollectorOp collectNodes(nodes);
+                contextNode->Walk(collectNodes, axis);
+            }
+            if (index < int(nodes.size()))
+            {
+                return nodes[index++];
+            }
+            nodes.clear();
+            current = nullptr;
+            break;
+        }
+    }
+    return current;
+}
+
+XPathLocationStepExpr::XPathLocationStepExpr(Axis axis_, XPathNodeTestExpr* nodeTest_) : axis(axis_), nodeTest(nodeTest_), position(0), lastPosition(false)
 {
 }
 
 void XPathLocationStepExpr::AddPredicate(XPathExpr* predicate)
 {
+    if (predicates.empty())
+    {
+        XPathNumberExpr* number = dynamic_cast<XPathNumberExpr*>(predicate);
+        if (number && number->Value() >= 1 && number->Value() == int(number->Value()))
+        {
+            position = int(number->Value());
+        }
+        XPathFunctionCall* functionCall = dynamic_cast<XPathFunctionCall*>(predicate);
+        if (functionCall && functionCall->FunctionName() == U"last" && functionCall->Arity() == 0)
+        {
+            lastPosition = true;
+        }
+    }
     predicates.push_back(std::unique_ptr<XPathExpr>(predicate));
 }
 
 std::unique_ptr<XPathObject> XPathLocationStepExpr::Evaluate(XPathContext& context)
 {
     std::unique_ptr<XPathNodeSet> nodeSet(new XPathNodeSet());
-    NodeSelectionOp selectNodes(nodeTest.get(), *nodeSet, axis);
-    context.Node()->Walk(selectNodes, axis);
-    for (const std::unique_ptr<XPathExpr>& predicate : predicates)
+    AxisIterator axisIterator(context.Node(), axis);
+    int firstPredicate = 0;
+    if (position > 0)
+    {
+        int count = 0;
+        cmajor::dom::Node* node = axisIterator.Next();
+        while (node)
+        {
+            if (nodeTest->Select(node, axis) && ++count == position)
+            {
+                nodeSet->Add(node);
+                break;
+            }
+            node = axisIterator.Next();
+        }
+        firstPredicate = 1;
+    }
+    else if (lastPosition)
+    {
+        cmajor::dom::Node* last = nullptr;
+        cmajor::dom::Node* node = axisIterator.Next();
+        while (node)
+        {
+            if (nodeTest->Select(node, axis))
+            {
+                last = node;
+            }
+            node = axisIterator.Next();
+        }
+        if (last)
+        {
+            nodeSet->Add(last);
+        }
+        firstPredicate = 1;
+    }
+    else
+    {
+        cmajor::dom::Node* node = axisIterator.Next();
+        while (node)
+        {
+            if (nodeTest->Select(node, axis))
+            {
+                nodeSet->Add(node);
+            }
+            node = axisIterator.Next();
+        }
+    }
+    int np = int(predicates.size());
+    for (int p = firstPredicate; p < np; ++p)
     {
+        XPathExpr* predicate = predicates[p].get();
         std::unique_ptr<XPathNodeSet> filteredNodeSet(new XPathNodeSet());
         int n = nodeSet->Length();
         for (int i = 0; i < n; ++i)
@@ -1339,6 +1484,7 @@ std::unique_ptr<XPathObject> XPathLocationStepExpr::Evaluate(XPathContext& conte
         }
         std::swap(nodeSet, filteredNodeSet);
     }
+    nodeSet->SortInDocumentOrder();
     return std::unique_ptr<XPathObject>(nodeSet.release());
 }
 
@@ -212,6 +212,8 @@ private:
     Axis axis;
     std::unique_ptr<XPathNodeTestExpr> nodeTest;
     std::vector<std::unique_ptr<XPathExpr>> predicates;
+    int position;
+    bool lastPosition;
 };
 
 Axis GetAxis(const std::u32string& axisName);
@@ -306,6 +308,7 @@ class XPathNumberExpr : public XPathExpr
 public:
     XPathNumberExpr(const std::u32string& value_);
     XPathNumberExpr(double value_);
+    double Value() const { return value; }
     std::unique_ptr<XPathObject> Evaluate(XPathContext& context);
     std::unique_ptr<dom::Node> ToDom() const override;
 private:
@@ -317,6 +320,8 @@ class XPathFunctionCall : public XPathExpr
 public:
     XPathFunctionCall(const std::u32string& functionName_);
     void AddArgument(XPathExpr* argument);
+    const std::u32string& FunctionName() const { return functionName; }
+    int Arity() const { return int(arguments.size()); }
     std::unique_ptr<XPathObject> Evaluate(XPathContext& context);
     std::unique_ptr<dom::Node> ToDom() const override;
 private:
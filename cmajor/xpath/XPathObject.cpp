@@ -28,6 +28,11 @@ void XPathNodeSet::Add(cmajor::dom::Node* node)
     nodes.InternalAddNode(node);
 }
 
+void XPathNodeSet::SortInDocumentOrder()
+{
+    nodes.InternalSortInDocumentOrder();
+}
+
 std::unique_ptr<dom::Node> XPathNodeSet::ToDom() const
 {
     std::unique_ptr<dom::Element> result(new dom::Element(U"nodeset"));
@@ -32,6 +32,7 @@ public:
     cmajor::dom::Node* operator[](int index) const { return nodes[index]; }
     int Length() const { return nodes.Length(); }
     void Add(cmajor::dom::Node* node);
+    void SortInDocumentOrder();
     std::unique_ptr<dom::Node> ToDom() const override;
 private:
     cmajor::dom::NodeList nodes;
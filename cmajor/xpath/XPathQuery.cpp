@@ -0,0 +1,161 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#include <cmajor/xpath/XPathQuery.hpp>
+#include <cmajor/xpath/XPath.hpp>
+#include <cmajor/xpath/XPathDebug.hpp>
+#include <cmajor/dom/Document.hpp>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace cmajor { namespace xpath {
+
+XPath* xpathGrammar = nullptr;
+std::mutex grammarMutex;
+
+XPathQuery::XPathQuery(const std::u32string& expression_) : expression(expression_), parseDuration(0)
+{
+    std::lock_guard<std::mutex> lock(grammarMutex);
+    if (!xpathGrammar)
+    {
+        xpathGrammar = XPath::Create();
+    }
+    if (XPathDebugParsing())
+    {
+        xpathGrammar->SetLog(&std::cout);
+    }
+    std::chrono::time_point<std::chrono::steady_clock> startParse = std::chrono::steady_clock::now();
+    expr.reset(xpathGrammar->Parse(&expression[0], &expression[0] + expression.length(), 0, ""));
+    std::chrono::time_point<std::chrono::steady_clock> endParse = std::chrono::steady_clock::now();
+    parseDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(endParse - startParse);
+}
+
+std::unique_ptr<XPathObject> XPathQuery::Evaluate(cmajor::dom::Node* node) const
+{
+    if (XPathDebugQuery())
+    {
+        std::unique_ptr<dom::Node> queryDom = expr->ToDom();
+        SetXPathQueryDom(std::move(queryDom));
+        SetXPathQueryDuration(parseDuration);
+    }
+    std::chrono::time_point<std::chrono::steady_clock> startEvaluate = std::chrono::steady_clock::now();
+    XPathContext context(node, 1, 1);
+    std::unique_ptr<XPathObject> result = expr->Evaluate(context);
+    std::chrono::time_point<std::chrono::steady_clock> endEvaluate = std::chrono::steady_clock::now();
+    if (XPathDebugQuery())
+    {
+        SetXPathExecuteDuration(endEvaluate - startEvaluate);
+    }
+    return result;
+}
+
+std::unique_ptr<XPathObject> XPathQuery::Evaluate(cmajor::dom::Document* document) const
+{
+    return Evaluate(static_cast<cmajor::dom::Node*>(document));
+}
+
+// Least recently used cache of compiled queries keyed by expression text.
+
+class QueryCache
+{
+public:
+    static void Init();
+    static void Done();
+    static QueryCache& Instance() { return *instance; }
+    std::shared_ptr<XPathQuery> GetQuery(const std::u32string& expression);
+    void SetCapacity(int capacity_);
+private:
+    static std::unique_ptr<QueryCache> instance;
+    typedef std::list<std::shared_ptr<XPathQuery>> QueryList;
+    QueryList queries;
+    std::unordered_map<std::u32string, QueryList::iterator> queryMap;
+    int capacity;
+    std::mutex mtx;
+    QueryCache();
+    void Evict();
+};
+
+std::unique_ptr<QueryCache> QueryCache::instance;
+
+const int defaultQueryCacheCapacity = 256;
+
+QueryCache::QueryCache() : capacity(defaultQueryCacheCapacity)
+{
+}
+
+void QueryCache::Init()
+{
+    instance.reset(new QueryCache());
+}
+
+void QueryCache::Done()
+{
+    instance.reset();
+}
+
+std::shared_ptr<XPathQuery> QueryCache::GetQuery(const std::u32string& expression)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = queryMap.find(expression);
+        if (it != queryMap.cend())
+        {
+            queries.splice(queries.begin(), queries, it->second);
+            return *it->second;
+        }
+    }
+    std::shared_ptr<XPathQuery> query(new XPathQuery(expression));
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = queryMap.find(expression);
+    if (it != queryMap.cend())
+    {
+        queries.splice(queries.begin(), queries, it->second);
+        return *it->second;
+    }
+    queries.push_front(query);
+    queryMap[expression] = queries.begin();
+    Evict();
+    return query;
+}
+
+void QueryCache::SetCapacity(int capacity_)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    capacity = capacity_;
+    Evict();
+}
+
+void QueryCache::Evict()
+{
+    while (int(queries.size()) > capacity)
+    {
+        queryMap.erase(queries.back()->Expression());
+        queries.pop_back();
+    }
+}
+
+std::shared_ptr<XPathQuery> GetQuery(const std::u32string& expression)
+{
+    return QueryCache::Instance().GetQuery(expression);
+}
+
+void SetQueryCacheCapacity(int capacity)
+{
+    QueryCache::Instance().SetCapacity(capacity);
+}
+
+void InitQuery()
+{
+    QueryCache::Init();
+}
+
+void DoneQuery()
+{
+    QueryCache::Done();
+}
+
+} } // namespace cmajor::xpath
@@ -0,0 +1,39 @@
+// =================================
+// Copyright (c) 2019 Seppo Laakko
+// Distributed under the MIT license
+// =================================
+
+#ifndef CMAJOR_XPATH_XPATH_QUERY
+#define CMAJOR_XPATH_XPATH_QUERY
+#include <cmajor/xpath/XPathExpr.hpp>
+#include <chrono>
+
+namespace cmajor { namespace xpath {
+
+// An XPath expression that is parsed once and can be evaluated any number of times, also concurrently from different threads.
+
+class XPathQuery
+{
+public:
+    XPathQuery(const std::u32string& expression_);
+    XPathQuery(const XPathQuery&) = delete;
+    XPathQuery& operator=(const XPathQuery&) = delete;
+    const std::u32string& Expression() const { return expression; }
+    XPathExpr* Expr() const { return expr.get(); }
+    std::chrono::nanoseconds ParseDuration() const { return parseDuration; }
+    std::unique_ptr<XPathObject> Evaluate(cmajor::dom::Node* node) const;
+    std::unique_ptr<XPathObject> Evaluate(cmajor::dom::Document* document) const;
+private:
+    std::u32string expression;
+    std::unique_ptr<XPathExpr> expr;
+    std::chrono::nanoseconds parseDuration;
+};
+
+std::shared_ptr<XPathQuery> GetQuery(const std::u32string& expression);
+void SetQueryCacheCapacity(int capacity);
+void InitQuery();
+void DoneQuery();
+
+} } // namespace cmajor::xpath
+
+#endif // CMAJOR_XPATH_XPATH_QUERY